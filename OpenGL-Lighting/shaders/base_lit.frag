@@ -9,10 +9,24 @@ in VS_OUT {
 	vec3 TangentViewPos;
 	vec3 TangentFragPos;
 	mat3 TBN;
+	mat3 nonTransTBN;
 } fs_in;
 
 out vec4 FragColor;
 
+// MODEL_MATERIAL samples the texture_diffuse1/specular1/normal1 maps Model binds, without parallax
+// or the point light, and gamma corrects the result. otherwise the floor's hand bound maps are used.
+#ifdef MODEL_MATERIAL
+struct Material {
+	sampler2D texture_diffuse1;
+	sampler2D texture_specular1;
+	sampler2D texture_normal1;
+	float shininess;
+};
+#define DIFFUSE_TEX material.texture_diffuse1
+#define SPECULAR_TEX material.texture_specular1
+#define NORMAL_TEX material.texture_normal1
+#else
 struct Material {
 	sampler2D diffuse;
 	sampler2D specular;
@@ -20,6 +34,10 @@ struct Material {
 	sampler2D depth;
 	float shininess;
 };
+#define DIFFUSE_TEX material.diffuse
+#define SPECULAR_TEX material.specular
+#define NORMAL_TEX material.normal
+#endif
 
 struct DirLight {
 	vec3 direction;
@@ -37,6 +55,23 @@ struct PointLight {
 };
 
 uniform Material material;
+
+#ifdef MATERIAL_BLOCK
+// the model's imported material parameters, see MaterialParams
+layout(std140) uniform MaterialBlock {
+	vec4 diffuseColor;
+	vec4 specularColor;
+	float shininess;
+	float opacity;
+} materialParams;
+#define SHININESS materialParams.shininess
+#define DIFFUSE_TINT materialParams.diffuseColor.rgb
+#define SPECULAR_TINT materialParams.specularColor.rgb
+#else
+#define SHININESS material.shininess
+#define DIFFUSE_TINT vec3(1.0)
+#define SPECULAR_TINT vec3(1.0)
+#endif
 uniform DirLight dirLight;
 uniform PointLight pointLight;
 
@@ -51,26 +86,36 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec2 texCoords);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec2 texCoords);
 float ShadowDirCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir);
 float ShadowPointCalculation(PointLight light, vec3 fragPos);
+#ifndef MODEL_MATERIAL
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir);
 vec2 SteepParallaxMapping(vec2 texCoords, vec3 viewDir);
 vec2 ParallaxOcclusionMapping(vec2 texCoords, vec3 viewDir);
+#endif
 
 void main () {
 	vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
 
+#ifdef MODEL_MATERIAL
+	vec2 texCoords = fs_in.TexCoords;
+#else
 	// vec3 norm = normalize(fs_in.Normal);
 	vec2 texCoords = ParallaxOcclusionMapping(fs_in.TexCoords, viewDir);
 
 	if (texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0) discard;
+#endif
 
-	vec3 norm = texture(material.normal, texCoords).rgb;
-	norm = normalize(norm * 2.0 - 1.0);
+	// z is rebuilt from x/y so BC5 (two channel) normal maps sample the same as rgb ones
+	vec2 normXY = texture(NORMAL_TEX, texCoords).rg * 2.0 - 1.0;
+	vec3 norm = normalize(vec3(normXY, sqrt(max(1.0 - dot(normXY, normXY), 0.0))));
 	
 	vec3 result = CalcDirLight(dirLight, norm, viewDir, texCoords); 
+#ifdef MODEL_MATERIAL
+	float gamma = 2.2;
+	result = pow(result, vec3(1.0/gamma));
+#else
 	result += CalcPointLight(pointLight, norm, fs_in.TangentFragPos, viewDir, texCoords);
+#endif
 
-	// float gamma = 2.2;
-	// result = pow(result, vec3(1.0/gamma));
 	FragColor = vec4(result, 1.0);
 }
 
@@ -79,13 +124,13 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec2 texCoords) {
 	float diff = max(dot(normal, lightDir), 0.0);
 
 	vec3 halfwayDir = normalize(lightDir + viewDir);
-	float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+	float spec = pow(max(dot(normal, halfwayDir), 0.0), SHININESS);
  
 	float shadow = ShadowDirCalculation(fs_in.FragPosLightSpace, normal, lightDir);
 	
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, texCoords));
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, texCoords));
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, texCoords));
+	vec3 ambient = light.ambient * vec3(texture(DIFFUSE_TEX, texCoords));
+	vec3 diffuse = light.diffuse * diff * vec3(texture(DIFFUSE_TEX, texCoords)) * DIFFUSE_TINT;
+	vec3 specular = light.specular * spec * vec3(texture(SPECULAR_TEX, texCoords)) * SPECULAR_TINT;
 
 	return (ambient + (1.0 - shadow) * (diffuse + specular));
 }
@@ -99,15 +144,15 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
 	float diff = max(dot(normal, lightDir), 0.0);
 
 	vec3 halfwayDir = normalize(lightDir + viewDir);
-	float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+	float spec = pow(max(dot(normal, halfwayDir), 0.0), SHININESS);
 
 	float shadow = ShadowPointCalculation(light, fragPos);
 
 	float attenuation = 1.0 / (light.positionAndConstant.a + light.ambientAndLinear.a * distance + light.diffuseAndQuadratic.a * (distance * distance));
 
-	vec3 ambient = light.ambientAndLinear.rgb * vec3(texture(material.diffuse, fs_in.TexCoords));
-	vec3 diffuse = light.diffuseAndQuadratic.rgb * diff * vec3(texture(material.diffuse, fs_in.TexCoords));
-	vec3 specular = light.specular.rgb * spec * vec3(texture(material.specular, fs_in.TexCoords));
+	vec3 ambient = light.ambientAndLinear.rgb * vec3(texture(DIFFUSE_TEX, fs_in.TexCoords));
+	vec3 diffuse = light.diffuseAndQuadratic.rgb * diff * vec3(texture(DIFFUSE_TEX, fs_in.TexCoords)) * DIFFUSE_TINT;
+	vec3 specular = light.specular.rgb * spec * vec3(texture(SPECULAR_TEX, fs_in.TexCoords)) * SPECULAR_TINT;
  
 	ambient *= attenuation;
 	diffuse *= attenuation;
@@ -159,6 +204,7 @@ float ShadowPointCalculation(PointLight light, vec3 fragPos)
 	return shadow;
 }
 
+#ifndef MODEL_MATERIAL
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
 	float height = texture(material.depth, texCoords).r;
 	vec2 p = viewDir.xy / viewDir.z * (height * height_scale);
@@ -221,4 +267,5 @@ vec2 ParallaxOcclusionMapping(vec2 texCoords, vec3 viewDir) {
 	vec2 finalTexCoords = prevTexCoords * weight + currTexCoords * (1.0 - weight);
 
 	return finalTexCoords;
-}
\ No newline at end of file
+}
+#endif
@@ -1,9 +1,26 @@
 #version 330 core
+#ifdef COMPACT_VERTEX
+// the bitangent isn't stored, B below is rebuilt from N and T anyway
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in vec2 aNormalOct;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec2 aTangentOct;
+
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 decodeOctahedral(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+#endif
 
 out VS_OUT {
 	vec3 FragPos;
@@ -17,18 +34,33 @@ out VS_OUT {
 	mat3 nonTransTBN;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 lightSpaceMatrix;
 
 uniform vec3 viewPos;
 uniform vec3 lightPos;
 
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
+
 void main()
 {
+#ifdef COMPACT_VERTEX
+	vec3 aPos = positionOffset + positionScale * aPosition.xyz;
+	vec3 aNormal = decodeOctahedral(aNormalOct);
+	vec3 aTangent = decodeOctahedral(aTangentOct);
+#endif
 	vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-	vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
+	vs_out.Normal = normalMatrix * aNormal;
 	vs_out.TexCoords = aTexCoords;
 	vs_out.FragPosLightSpace = lightSpaceMatrix * model * vec4(aPos, 1.0);
 	
@@ -45,5 +77,5 @@ void main()
 	vs_out.TBN = TBN;
 	vs_out.nonTransTBN = mat3(T, B, N);
 
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	gl_Position = viewProjection * vec4(vs_out.FragPos, 1.0);
 }
\ No newline at end of file
@@ -64,8 +64,8 @@ void main () {
 
 	if (texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0) discard;
 
-	vec3 norm = texture(material.normal, texCoords).rgb;
-	norm = normalize(norm * 2.0 - 1.0);
+	vec2 normXY = texture(material.normal, texCoords).rg * 2.0 - 1.0;
+	vec3 norm = normalize(vec3(normXY, sqrt(max(1.0 - dot(normXY, normXY), 0.0))));
 	
 	vec3 result = CalcDirLight(dirLight, norm, viewDir, texCoords); 
 	result += CalcPointLight(pointLight, norm, fs_in.TangentFragPos, viewDir, texCoords);
@@ -1,22 +1,71 @@
 #version 330 core
 
+#ifdef COMPACT_VERTEX
+// VertexLayout::Compact(Quantized) from Mesh::setupMesh
+layout (location = 0) in vec4 aPosition;
+layout (location = 1) in vec2 aNormalOct;
+layout (location = 2) in vec2 aTexCoords;
+
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 decodeOctahedral(vec2 e) {
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0) v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+#ifdef INSTANCED
+// InstanceBuffer attributes, the model matrix comes per instance instead of as a uniform
+layout (location = 5) in mat4 aModel;
+layout (location = 9) in vec4 aInstanceParams;
+// world matrix of the drawn mesh's node, set by Model::DrawInstanced
+uniform mat4 nodeMatrix = mat4(1.0);
+
+out vec4 InstanceParams;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;
+#endif
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
 
 void main() {
+#ifdef COMPACT_VERTEX
+	vec3 aPos = positionOffset + positionScale * aPosition.xyz;
+	vec3 aNormal = decodeOctahedral(aNormalOct);
+#endif
+#ifdef INSTANCED
+	mat4 model = aModel * nodeMatrix;
+#endif
 	FragPos = vec3(model * vec4(aPos, 1.0));
-	Normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef INSTANCED
+	// the matrix only exists per instance here
+	mat3 normalMatrix = transpose(inverse(mat3(model)));
+#endif
+	Normal = normalMatrix * aNormal;
 	TexCoords = aTexCoords;
+#ifdef INSTANCED
+	InstanceParams = aInstanceParams;
+#endif
 
-	gl_Position = projection * view * vec4(FragPos, 1.0);
+	gl_Position = viewProjection * vec4(FragPos, 1.0);
 }
 
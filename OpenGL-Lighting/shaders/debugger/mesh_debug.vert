@@ -17,18 +17,28 @@ out VS_OUT {
 	mat3 nonTransTBN;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
+uniform mat3 normalMatrix;
 uniform mat4 lightSpaceMatrix;
 
 uniform vec3 viewPos;
 uniform vec3 lightPos;
 
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
+
 void main()
 {
 	vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-	vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
+	vs_out.Normal = normalMatrix * aNormal;
 	vs_out.TexCoords = aTexCoords;
 	vs_out.FragPosLightSpace = lightSpaceMatrix * model * vec4(aPos, 1.0);
 	
@@ -45,5 +55,5 @@ void main()
 	vs_out.TBN = TBN;
 	vs_out.nonTransTBN = mat3(T, B, N);
 
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	gl_Position = viewProjection * vec4(vs_out.FragPos, 1.0);
 }
\ No newline at end of file
@@ -17,8 +17,8 @@ out vec4 FragColor;
 uniform sampler2D normalMap;
 
 void main() {
-	vec3 n = texture(normalMap, fs_in.TexCoords).rgb;
-	n = normalize(n * 2.0 - 1.0);
+	vec2 nXY = texture(normalMap, fs_in.TexCoords).rg * 2.0 - 1.0;
+	vec3 n = normalize(vec3(nXY, sqrt(max(1.0 - dot(nXY, nXY), 0.0))));
 	n = normalize(fs_in.nonTransTBN * n);
 
 	FragColor = vec4(n, 1.0);
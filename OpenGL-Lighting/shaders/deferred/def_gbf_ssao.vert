@@ -10,8 +10,18 @@ out vec2 TexCoords;
 uniform bool invertedNormals;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;
+
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    mat4 invView;
+    mat4 invProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+};
 
 void main()
 {
@@ -19,8 +29,8 @@ void main()
     FragPos = viewPos.xyz; 
     TexCoords = aTexCoords;
     
-    mat3 normalMatrix = transpose(inverse(mat3(view * model)));
-    Normal = normalMatrix * (invertedNormals ? -aNormal : aNormal);
+    // the view is rigid, its rotation is its own normal matrix
+    Normal = mat3(view) * normalMatrix * (invertedNormals ? -aNormal : aNormal);
     
     gl_Position = projection * viewPos;
 }
\ No newline at end of file
@@ -14,7 +14,9 @@ struct Light {
 	float Radius;
 };
 
-const int NR_LIGHTS = 32;
+#ifndef NR_LIGHTS
+#define NR_LIGHTS 32
+#endif
 // uniform Light lights[NR_LIGHTS];
 layout(std140) uniform LightBlock {
 	Light lights[NR_LIGHTS];
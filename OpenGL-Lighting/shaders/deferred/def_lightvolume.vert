@@ -3,13 +3,22 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
 
 out vec2 TexCoords;
 
 void main() {
-	vec4 fragPos = projection * view * model * vec4(aPos, 1.0);
+	vec4 fragPos = viewProjection * model * vec4(aPos, 1.0);
 	gl_Position = fragPos;
 
 	// get screen space uvs
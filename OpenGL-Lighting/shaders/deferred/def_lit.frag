@@ -7,18 +7,35 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 
+#ifdef SSAO
+// one attenuated light in view space, ambient scaled by the blurred occlusion
+uniform sampler2D ssao;
+
+struct Light {
+	vec3 Position;
+	vec3 Color;
+
+	float Linear;
+	float Quadratic;
+	float Radius;
+};
+uniform Light light;
+#else
 struct Light {
 	vec3 Position;
 	vec3 Color;
 	float Radius;
 };
 
-const int NR_LIGHTS = 32;
+#ifndef NR_LIGHTS
+#define NR_LIGHTS 32
+#endif
 layout(std140) uniform LightBlock {
 	Light lights[NR_LIGHTS];
 };
 
 uniform vec3 viewPos;
+#endif
 
 void main() {
 	vec3 FragPos = texture(gPosition, TexCoords).rgb;
@@ -26,6 +43,24 @@ void main() {
 	vec3 Albedo = texture(gAlbedoSpec, TexCoords).rgb;
 	float Specular = texture(gAlbedoSpec, TexCoords).a;
 
+#ifdef SSAO
+	float AmbientOcclusion = texture(ssao, TexCoords).r;
+
+	// blinn-phong view space
+	vec3 lighting = vec3(0.3 * Albedo * AmbientOcclusion);
+	vec3 viewDir = normalize(-FragPos);
+	vec3 lightDir = normalize(light.Position - FragPos);
+	vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Albedo * light.Color;
+
+	vec3 halfwayDir = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(Normal, halfwayDir), 0.0), 8.0);
+	vec3 specular = light.Color * spec;
+	float dist = length(light.Position - FragPos);
+	float attenuation = 1.0 / (1.0 + light.Linear * dist + light.Quadratic * dist * dist);
+	diffuse *= attenuation;
+	specular *= attenuation;
+	lighting += diffuse + specular;
+#else
 	vec3 lighting = Albedo * 0.3; // hard-coded ambient component
 	vec3 viewDir = normalize(viewPos - FragPos);
 
@@ -35,6 +70,7 @@ void main() {
 		vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Albedo * lights[i].Color;
 		lighting += diffuse;
 	}
+#endif
 
 	FragColor = vec4(lighting, 1.0);
-}
\ No newline at end of file
+}
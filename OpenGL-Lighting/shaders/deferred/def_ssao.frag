@@ -7,8 +7,21 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
-uniform vec3 samples[64];
-uniform mat4 projection;
+// quality tiers are compiled as variants, see ssao_ambient_occlusion.cpp
+#ifndef KERNEL_SIZE
+#define KERNEL_SIZE 64
+#endif
+uniform vec3 samples[KERNEL_SIZE];
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
 
 // based on resolution/noise size from texNoise texture
 const vec2 noiseScale = vec2(1600.0/4.0, 1200.0/4.0); 
@@ -22,11 +35,10 @@ void main() {
 	vec3 bitangent = cross(normal, tangent);
 	mat3 TBN = mat3(tangent, bitangent, normal);
 
-	int kernelSize = 64;
 	float radius = 0.5;
 	float occlusion = 0.0;
 
-	for (int i = 0; i < kernelSize; ++i) {
+	for (int i = 0; i < KERNEL_SIZE; ++i) {
 		// transform kernel sample from tangent space to view-space
 		vec3 sample = TBN * samples[i];
 		
@@ -48,7 +60,7 @@ void main() {
 		occlusion += (sampleDepth >= sample.z + bias ? 1.0 : 0.0) * rangeCheck;
 	}
 
-	occlusion = 1.0 - (occlusion / kernelSize); // one minus normalize based on kernel size
+	occlusion = 1.0 - (occlusion / float(KERNEL_SIZE)); // one minus normalize based on kernel size
 
 	FragColor = occlusion;
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+#ifdef INSTANCED
+in vec4 InstanceParams; // rgb tint
+#endif
+
+out vec4 FragColor;
+
+uniform sampler2D texture_diffuse1;
+uniform vec3 lightDir;
+
+void main()
+{
+	vec3 albedo = texture(texture_diffuse1, TexCoords).rgb;
+#ifdef INSTANCED
+	albedo *= InstanceParams.rgb;
+#endif
+	float diff = max(dot(normalize(Normal), -normalize(lightDir)), 0.0);
+	FragColor = vec4(albedo * (0.1 + 0.9 * diff), 1.0);
+}
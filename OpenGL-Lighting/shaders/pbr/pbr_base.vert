@@ -9,14 +9,24 @@ out vec3 Normal;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix;
+
+// camera matrices published once per frame, see frame_data.h
+layout (std140) uniform FrameData {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 invView;
+	mat4 invProjection;
+	vec4 cameraPos;
+	vec4 viewport;
+};
 
 void main() {
 	FragPos = vec3(model * vec4(aPos, 1.0));
-	Normal = mat3(transpose(inverse(model))) * aNormal;
+	Normal = normalMatrix * aNormal;
 	TexCoords = aTexCoords;
 
-	gl_Position = projection * view * vec4(FragPos, 1.0);
+	gl_Position = viewProjection * vec4(FragPos, 1.0);
 }
 
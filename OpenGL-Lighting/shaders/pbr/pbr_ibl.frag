@@ -15,10 +15,14 @@ in VS_OUT {
 } fs_in;
 
 uniform vec3 viewPos;
-uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
+// diffuse irradiance / pi projected onto the first nine SH basis functions, rgb in xyz
+layout(std140) uniform IrradianceSH {
+	vec4 shCoefficients[9];
+};
+
 struct Material {
 	sampler2D albedoMap;
 	sampler2D normalMap;
@@ -43,6 +47,7 @@ vec3 Fresnel(float cosTheta, vec3 F0);
 vec3 FresnelRoughness(float cosTheta, vec3 F0, float roughness);
 float NormalDistribution(float nDotH, float roughness);
 float GeometryEq(float dotProd, float roughness);
+vec3 IrradianceSH9(vec3 n);
 
 const float PI = 3.14159265359;
 
@@ -53,8 +58,8 @@ void main() {
 	float roughness = texture(material.roughnessMap,  fs_in.TexCoords).r;
 	float ao = texture(material.aoMap,  fs_in.TexCoords).r;
 
-	vec3 n = texture(material.normalMap, fs_in.TexCoords).rgb;
-	n = normalize(n * 2.0 - 1.0);
+	vec2 nXY = texture(material.normalMap, fs_in.TexCoords).rg * 2.0 - 1.0;
+	vec3 n = normalize(vec3(nXY, sqrt(max(1.0 - dot(nXY, nXY), 0.0))));
 	n = normalize(fs_in.nonTransTBN * n);
 
 	vec3 F0 = vec3(0.04);
@@ -113,7 +118,7 @@ void main() {
 	vec3 kD = 1.0 - kS;
 	kD *= 1.0 - metallic;
 
-	vec3 irradiance = texture(irradianceMap, n).rgb;
+	vec3 irradiance = max(IrradianceSH9(n), vec3(0.0));
 	vec3 diffuse = irradiance * albedo;
 	vec3 prefilteredColor = textureLod(prefilterMap, R, roughness * MAX_REFLECTION_LOD).rgb;
 
@@ -153,4 +158,17 @@ float NormalDistribution(float nDotH, float roughness) {
 float GeometryEq(float dotProd, float roughness) {
 	float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
 	return dotProd / (dotProd * (1.0 - k) + k);
-}
\ No newline at end of file
+}
+
+// evaluates the SH9 basis in the same order the cpu projection writes it
+vec3 IrradianceSH9(vec3 n) {
+	return shCoefficients[0].rgb * 0.282095
+		+ shCoefficients[1].rgb * 0.488603 * n.y
+		+ shCoefficients[2].rgb * 0.488603 * n.z
+		+ shCoefficients[3].rgb * 0.488603 * n.x
+		+ shCoefficients[4].rgb * 1.092548 * n.x * n.y
+		+ shCoefficients[5].rgb * 1.092548 * n.y * n.z
+		+ shCoefficients[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+		+ shCoefficients[7].rgb * 1.092548 * n.x * n.z
+		+ shCoefficients[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+}
@@ -2,11 +2,30 @@
 
 out vec4 FragColor;
 
+// NORMAL_MAP reads base_lit.vert's tangent frame and perturbs n with material.normalMap,
+// IBL_AMBIENT replaces the constant ambient with the irradiance map
+#ifdef NORMAL_MAP
+in VS_OUT {
+	vec3 FragPos;
+	vec3 Normal;
+	vec2 TexCoords;
+	vec4 FragPosLightSpace;
+	vec3 TangentLightPos;
+	vec3 TangentViewPos;
+	vec3 TangentFragPos;
+	mat3 TBN;
+	mat3 nonTransTBN;
+} fs_in;
+#else
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+#endif
 
 uniform vec3 viewPos;
+#ifdef IBL_AMBIENT
+uniform samplerCube irradianceMap;
+#endif
 
 struct Material {
 	sampler2D albedoMap;
@@ -30,31 +49,49 @@ uniform Light lights[4];
 
 
 vec3 Fresnel(float cosTheta, vec3 F0);
+vec3 FresnelRoughness(float cosTheta, vec3 F0, float roughness);
 float NormalDistribution(float nDotH, float roughness);
 float GeometryEq(float dotProd, float roughness);
 
 const float PI = 3.14159265359;
 
 void main() {
-
-	vec3 albedo = pow(texture(material.albedoMap, TexCoords).rgb, vec3(2.2));
-	// vec3 normal map not used yet
-	float metallic = texture(material.metallicMap, TexCoords).r;
-	float roughness = texture(material.roughnessMap, TexCoords).r;
-	float ao = texture(material.aoMap, TexCoords).r;
-
-	vec3 n = normalize(Normal);				
-	vec3 v = normalize(viewPos - FragPos);					// view dir
+#ifdef NORMAL_MAP
+	vec3 fragPos = fs_in.FragPos;
+	vec2 texCoords = fs_in.TexCoords;
+#else
+	vec3 fragPos = FragPos;
+	vec2 texCoords = TexCoords;
+#endif
+
+	vec3 albedo = pow(texture(material.albedoMap, texCoords).rgb, vec3(2.2));
+	float metallic = texture(material.metallicMap, texCoords).r;
+	float roughness = texture(material.roughnessMap, texCoords).r;
+	float ao = texture(material.aoMap, texCoords).r;
+
+#ifdef NORMAL_MAP
+	// bc5 maps only keep x and y, z is rebuilt so rgb maps work the same
+	vec2 nXY = texture(material.normalMap, texCoords).rg * 2.0 - 1.0;
+	vec3 n = normalize(vec3(nXY, sqrt(max(1.0 - dot(nXY, nXY), 0.0))));
+	n = normalize(fs_in.nonTransTBN * n);
+#else
+	vec3 n = normalize(Normal);
+#endif
+
+	vec3 F0 = vec3(0.04);
+	F0 = mix(F0, albedo, metallic);
+
+	vec3 v = normalize(viewPos - fragPos);	// view dir
 
 	roughness = max(roughness, 0.0001);
 
-	vec3 Lo = vec3(0.0);									// Irradiance
+	vec3 Lo = vec3(0.0);	// Irradiance
 
 	for (int i = 0; i < 4; i++) {
-		vec3 l = normalize(lights[i].position - FragPos);	// light dir
-		vec3 h = normalize(v + l);							// halfway vector
+		vec3 l = normalize(lights[i].position - fragPos);	// light dir
+		vec3 h = normalize(v + l);	// halfway vector
 
-		float distance = length(lights[i].position - FragPos);
+		float distance = length(lights[i].position - fragPos);
 		float attenuation = 1.0 / (distance * distance);
 		vec3 radiance = lights[i].color * attenuation;
 
@@ -65,9 +102,6 @@ void main() {
 		float nDotV = max(dot(n, v), 0.0);
 
 		// Specular BRDF
-		vec3 F0 = vec3(0.04);
-		F0 = mix(F0, albedo, metallic);
-		
 		vec3 F = Fresnel(vDotH, F0);
 		float D = NormalDistribution(nDotH, roughness);
 		float G = GeometryEq(nDotL, roughness) * GeometryEq(nDotV, roughness);
@@ -80,7 +114,7 @@ void main() {
 		vec3 kS = F;
 		vec3 kD = vec3(1.0) - kS;
 		kD *= 1.0 - metallic;		// decreases diffuse reflections as metallic value increases.
-		
+
 		vec3 fLambert = albedo;
 		vec3 DiffuseBRDF = kD * fLambert / PI;
 
@@ -88,7 +122,14 @@ void main() {
 		Lo += (DiffuseBRDF + SpecBRDF) * radiance * nDotL;
 	}
 
-	vec3 ambient = vec3(0.03) * albedo * ao;
+#ifdef IBL_AMBIENT
+	// ambient value based on irradiance map
+	vec3 kS = FresnelRoughness(max(dot(n, v), 0.0), F0, roughness);
+	vec3 kD = 1.0 - kS;
+	vec3 ambient = kD * texture(irradianceMap, n).rgb * albedo * ao;
+#else
+	vec3 ambient = vec3(0.03) * albedo * ao; // base ambient value
+#endif
 	vec3 color = ambient + Lo;
 
 	// HDR and gamma corrections
@@ -103,6 +144,11 @@ vec3 Fresnel(float cosTheta, vec3 F0) {
 	return F0 + (1.0 - F0) * pow(max((1.0 - cosTheta), 0.0), 5.0);
 }
 
+// based on Sebastien Lagarde's implementation
+vec3 FresnelRoughness(float cosTheta, vec3 F0, float roughness) {
+	return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
+}
+
 // uses TrowBridge-Reitz GGX
 float NormalDistribution(float nDotH, float roughness) {
     float a2 = roughness * roughness;
@@ -114,4 +160,4 @@ float NormalDistribution(float nDotH, float roughness) {
 float GeometryEq(float dotProd, float roughness) {
 	float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
 	return dotProd / (dotProd * (1.0 - k) + k);
-}
\ No newline at end of file
+}
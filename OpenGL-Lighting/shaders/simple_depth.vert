@@ -1,9 +1,19 @@
 #version 330 core
+#ifdef COMPACT_VERTEX
+// only the position of the compact layouts is needed here
+layout (location = 0) in vec4 aPosition;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+#else
 layout (location = 0) in vec3 aPos;
+#endif
 
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main() {
+#ifdef COMPACT_VERTEX
+	vec3 aPos = positionOffset + positionScale * aPosition.xyz;
+#endif
 	gl_Position =  lightSpaceMatrix * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -13,6 +13,8 @@
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 
@@ -42,12 +44,12 @@ int hdr_main()
 	}
 
 	// viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	glFrontFace(GL_CCW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
+	glstate::CullFace(GL_BACK);
+	glstate::Enable(GL_CULL_FACE);
 
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
@@ -123,11 +125,13 @@ int hdr_main()
 	glm::vec3 specular = glm::vec3(1.0f);
 	glm::vec3 ambient = glm::vec3(0.05f);
 
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		
@@ -136,49 +140,45 @@ int hdr_main()
 		glm::mat4 lightSpaceMatrix = lightProjection * lightView;
 
 		// get directional shadow pass
-		glCullFace(GL_FRONT);
-		glEnable(GL_DEPTH_TEST); // enable depth testing (disabled for tone mapping)
+		glstate::CullFace(GL_FRONT);
+		glstate::Enable(GL_DEPTH_TEST); // enable depth testing (disabled for tone mapping)
 
 		depthDirShader.use();
 		depthDirShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-		depthDirShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		depthDirShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		depthFBO.bind();
 		glClear(GL_DEPTH_BUFFER_BIT);
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 		glm::mat4 model = glm::mat4(1.0f);
 		model = glm::translate(model, pointLightPos);
 		model = glm::rotate(model, glm::radians((float)std::fmod(glfwGetTime() * 50, 360.0)), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.5, 0.5, 0.5));
-		depthDirShader.setMat4("model", model);
+		depthDirShader.setModel(model);
 
-		glBindVertexArray(lightCubeVAO);
+		glstate::BindVertexArray(lightCubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 		depthFBO.unbind();
-		glCullFace(GL_BACK);
+		glstate::CullFace(GL_BACK);
 
 		// saved rendered scene to the tonemapper
 		tonemapper.bind();
-		glViewport(0, 0, W_WIDTH, W_HEIGHT);
+		glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		lightSourceShader.use();
-		lightSourceShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		lightSourceShader.setMat4("view", camera.getViewMatrix());
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, pointLightPos);
 		model = glm::rotate(model, glm::radians((float)std::fmod(glfwGetTime() * 50, 360.0)), glm::vec3(1.0f, 0.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(0.5, 0.5, 0.5));
-		lightSourceShader.setMat4("model", model);
-		glBindVertexArray(lightCubeVAO);
+		lightSourceShader.setModel(model);
+		glstate::BindVertexArray(lightCubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 
 		floorShader.use();
-		floorShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		floorShader.setMat4("view", camera.getViewMatrix());
-		floorShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		floorShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		floorShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 		floorShader.setVec3("lightPos", dirLightPos);
@@ -203,22 +203,24 @@ int hdr_main()
 		floorShader.setFloat("height_scale", 0.05f);
 
 		bindTextures(textureIDs);
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		tonemapper.unbind();
 
 		// render color attachment from tonemapper
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
-		glDisable(GL_DEPTH_TEST);
+		glstate::Disable(GL_DEPTH_TEST);
 		hdrShader.use();
 		hdrShader.setInt("hdrBuffer", 0);
 		hdrShader.setFloat("exposure", 0.05);
-		glBindVertexArray(HDRFrame);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffer.id);
+		glstate::BindVertexArray(HDRFrame);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, colorBuffer.id);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
+		frameUniforms.endFrame();
+
 		// checks events and swap buffers
 		glfwPollEvents();
 		glfwSwapBuffers(window);
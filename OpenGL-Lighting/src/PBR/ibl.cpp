@@ -13,6 +13,10 @@
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/ibl_baker.h"
+#include "../modules/program_cache.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 #include <random>
@@ -43,13 +47,13 @@ int main()
 	}
 
 	// Viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	//glFrontFace(GL_CCW);
-	//glCullFace(GL_BACK);
-	// glEnable(GL_CULL_FACE);
-	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	//glstate::CullFace(GL_BACK);
+	// glstate::Enable(GL_CULL_FACE);
+	glstate::Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -65,191 +69,49 @@ int main()
 
 	// Shaders
 	Shader PBRShader("shaders/base_lit.vert", "shaders/pbr/pbr_ibl.frag");
-	Shader EQRToCubemap("shaders/cubemapping/eqr_to_cubemap.vert", "shaders/cubemapping/eqr_to_cubemap.frag");
 	Shader Skybox("shaders/cubemapping/skybox.vert", "shaders/cubemapping/skybox.frag");
-	Shader IrradianceShader("shaders/cubemapping/eqr_to_cubemap.vert", "shaders/cubemapping/irradiance_convolution.frag");
-	Shader PrefilterShader("shaders/cubemapping/eqr_to_cubemap.vert", "shaders/cubemapping/prefilter_cubemap.frag");
-	Shader IntegratedBRDF("shaders/pbr/brdf.vert", "shaders/pbr/brdf.frag");
 	Shader OutputFrame("shaders/post_process/framebuffer_quad.vert", "shaders/post_process/rh_tonemapping.frag");
 	
 
 	// Objects
-	unsigned int indicesCount;
-	unsigned int sphere = createSphereVAO(indicesCount, 1.0f, 64, 64);
+	// 64x64 up close, simplified levels as it shrinks on screen
+	Mesh sphere = createSphereMesh(1.0f, 64, 64);
 	unsigned int cube = createCubeVAO();
-	unsigned int frame = createFrameVAO();
 
-	// Textures
-	unsigned int tex_albedo = loadTexture("resources/textures/pbr/rusted_iron/albedo.png", true, TextureColorSpace::sRGB);
-	unsigned int tex_normal = loadTexture("resources/textures/pbr/rusted_iron/normal.png", true, TextureColorSpace::Linear);
-	unsigned int tex_metallic = loadTexture("resources/textures/pbr/rusted_iron/metallic.png", true, TextureColorSpace::Linear);
-	unsigned int tex_roughness = loadTexture("resources/textures/pbr/rusted_iron/roughness.png", true, TextureColorSpace::Linear);
-	unsigned int tex_ao = loadTexture("resources/textures/pbr/rusted_iron/ao.png", true, TextureColorSpace::Linear);
-
-	// HDR
-	Framebuffer hdrCapture(512, 512);
-	hdrCapture.attachRenderbuffer(GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24);
-
-	unsigned int hdr = loadHDR("resources/textures/hdr/newport_loft.hdr", true);
-
-	unsigned int envCubemap;
-	glGenTextures(1, &envCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // mipmaps to reduce artifacts
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-	glm::mat4 captureViews[] =
-	{
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-	};
-
-	EQRToCubemap.use();
-	EQRToCubemap.setInt("equirectangularMap", 0);
-	EQRToCubemap.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdr);
-
-	hdrCapture.bind();
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		EQRToCubemap.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glBindVertexArray(cube);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-	}
-	hdrCapture.unbind();
-
-	// generate mipmaps after the cubemap base texture is set
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-	// Irradiance
-	unsigned int irradianceCubemap;
-	glGenTextures(1, &irradianceCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		// no need for high resolution due to low frequency detailing
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-	hdrCapture.editRenderbufferStorage(32, 32, GL_DEPTH_COMPONENT24);
-
-	IrradianceShader.use();
-	IrradianceShader.setInt("environmentMap", 0);
-	IrradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-	hdrCapture.bind();
-	for (unsigned int i = 0; i < 6; i++)
-	{
-		IrradianceShader.setMat4("view", captureViews[i]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceCubemap, 0);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glBindVertexArray(cube);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-	}
-	hdrCapture.unbind();
-
-	// HDR pre-filtered map
-	unsigned int prefilterMap;
-	glGenTextures(1, &prefilterMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-	for (unsigned int i = 0; i < 6; ++i)
-	{
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable trilinear filtering
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-	// capture prefilter mip levels
-	PrefilterShader.use();
-	PrefilterShader.setInt("environmentMap", 0);
-	PrefilterShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-
-	hdrCapture.bind();
-	unsigned int maxMipLevels = 5;
-	for (unsigned int mip = 0; mip < maxMipLevels; mip++) {
-		unsigned int mipWidth = 128 * std::pow(0.5, mip);
-		unsigned int mipHeight = 128 * std::pow(0.5, mip);
-		glBindRenderbuffer(GL_RENDERBUFFER, hdrCapture.getRBO());
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24,
-			mipWidth, mipHeight);
-		glViewport(0, 0, mipWidth, mipHeight);
-
-		float roughness = (float)mip / (float)(maxMipLevels - 1);
-		PrefilterShader.setFloat("roughness", roughness);
-		for (unsigned int i = 0; i < 6; i++)
-		{
-			PrefilterShader.setMat4("view", captureViews[i]);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterMap, mip);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			glBindVertexArray(cube);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-			glBindVertexArray(0);
-		}
-	}
-	hdrCapture.unbind();
-
-	// Precomputed BRDF
-	unsigned int brdfLUTTexture;
-	glGenTextures(1, &brdfLUTTexture);
-
-	glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	//hdrCapture.bind();
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrCapture.FBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, hdrCapture.getRBO());
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
-	glViewport(0, 0, 512, 512);
-	IntegratedBRDF.use();
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glBindVertexArray(frame);
-	glDrawArrays(GL_TRIANGLES, 0, 6);
-	hdrCapture.unbind();
+	// Textures (material set decodes concurrently)
+	std::vector<unsigned int> loadedTextures = loadTextures({
+		{ "resources/textures/pbr/rusted_iron/albedo.png", true, TextureColorSpace::sRGB },
+		{ "resources/textures/pbr/rusted_iron/normal.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/metallic.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/roughness.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/ao.png", true, TextureColorSpace::Linear }
+	});
+	unsigned int tex_albedo = loadedTextures[0];
+	unsigned int tex_normal = loadedTextures[1];
+	unsigned int tex_metallic = loadedTextures[2];
+	unsigned int tex_roughness = loadedTextures[3];
+	unsigned int tex_ao = loadedTextures[4];
+
+	// IBL maps, baked from the hdr on the first run and read back from the cache afterwards
+	double iblStart = glfwGetTime();
+	bool iblFromCache = false;
+	IBLMaps ibl = loadOrBakeIBL("resources/textures/hdr/newport_loft.hdr", IBLBakeParams(), &iblFromCache);
+	glFinish();
+	std::cout << "IBL maps " << (iblFromCache ? "loaded from cache" : "baked") << " in "
+		<< (glfwGetTime() - iblStart) * 1000.0 << " ms" << std::endl;
+	unsigned int envCubemap = ibl.environment;
+	unsigned int prefilterMap = ibl.prefilter;
+	unsigned int brdfLUTTexture = ibl.brdfLUT;
+
+	// diffuse irradiance is evaluated from the SH in the shader
+	SH9Block irradianceBlock = toSH9Block(ibl.irradianceSH);
+	UniformBuffer uboIrradiance(sizeof(SH9Block), GL_STATIC_DRAW);
+	uboIrradiance.setData(&irradianceBlock, sizeof(SH9Block));
+
+	unsigned int bindingPoint = 0;
+	unsigned int uniformBlockIndex = glGetUniformBlockIndex(PBRShader.ID, "IrradianceSH");
+	glUniformBlockBinding(PBRShader.ID, uniformBlockIndex, bindingPoint);
+	uboIrradiance.bindBufferBase(bindingPoint);
 
 	// Static uniforms for skyboxes
 	Skybox.use();
@@ -283,34 +145,57 @@ int main()
 	Framebuffer DebugFramebuffer(W_WIDTH, W_HEIGHT, DebugTexture, GL_COLOR_ATTACHMENT0);
 	DebugFramebuffer.attachRenderbuffer(GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24);
 
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	// compile vs program binary load time of every shader built so far
+	ProgramCache::instance().printReport();
+
+	UniformHandle<glm::vec3> lightPositionUniforms[4];
+	UniformHandle<glm::vec3> lightColorUniforms[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		lightPositionUniforms[i] = PBRShader.getUniform<glm::vec3>("lights[" + std::to_string(i) + "].position");
+		lightColorUniforms[i] = PBRShader.getUniform<glm::vec3>("lights[" + std::to_string(i) + "].color");
+	}
+	UniformHandle<int> materialMaps[] = {
+		PBRShader.getUniform<int>("material.albedoMap"),
+		PBRShader.getUniform<int>("material.normalMap"),
+		PBRShader.getUniform<int>("material.metallicMap"),
+		PBRShader.getUniform<int>("material.roughnessMap"),
+		PBRShader.getUniform<int>("material.aoMap")
+	};
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
+
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
+
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		float time = glfwGetTime();
 		/*
 		
-		glViewport(0, 0, W_WIDTH, W_HEIGHT);
+		glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 		outputFrame.use();
 		outputFrame.setInt("hdrBuffer", 0);
 		outputFrame.setFloat("exposure", 1.0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
-		glBindVertexArray(frame);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+		glstate::BindVertexArray(frame);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		*/
 
 		// PBR Sphere
 		PBRShader.use();
-		PBRShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		PBRShader.setMat4("view", camera.getViewMatrix());
 
-		PBRShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), fmod(time * 30.0f, 360.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		glm::mat4 sphereModel = computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), fmod(time * 30.0f, 360.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		LODView lodView(camera.getCameraPos(), camera.getFOV(), (float)W_HEIGHT);
+		PBRShader.setModel(sphereModel);
 		PBRShader.setVec3("viewPos", camera.getCameraPos());
 
 		// material uniforms, flip commented out code if not using textures
@@ -318,66 +203,63 @@ int main()
 		// PBRShader.setFloat("material.metallic", 1.0f);
 		// PBRShader.setFloat("material.roughness", 0.2f);
 		// PBRShader.setFloat("material.ao", 0.0f);
-		PBRShader.setInt("material.albedoMap", 0);
-		PBRShader.setInt("material.normalMap", 1);
-		PBRShader.setInt("material.metallicMap", 2);
-		PBRShader.setInt("material.roughnessMap", 3);
-		PBRShader.setInt("material.aoMap", 4);
+		for (int i = 0; i < 5; i++)
+			PBRShader.set(materialMaps[i], i);
 		bindTextures(sphereTex);
-		PBRShader.setInt("irradianceMap", 5);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
 		PBRShader.setInt("prefilterMap", 6);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+		glstate::ActiveTexture(GL_TEXTURE6);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
 		PBRShader.setInt("brdfLUT", 7);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+		glstate::ActiveTexture(GL_TEXTURE7);
+		glstate::BindTexture(GL_TEXTURE_2D, brdfLUTTexture);
 		
 		// light uniforms
 		for (int i = 0; i < 4; ++i)
 		{
-			PBRShader.setVec3("lights[" + std::to_string(i) + "].position", lightPositions[i]);
-			PBRShader.setVec3("lights[" + std::to_string(i) + "].color", lightColors[i]);
+			PBRShader.set(lightPositionUniforms[i], lightPositions[i]);
+			PBRShader.set(lightColorUniforms[i], lightColors[i]);
 		}
-		glBindVertexArray(sphere);
-		glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
+		sphere.Draw(PBRShader, sphereModel, lodView);
 
 		// Skybox
 		glFrontFace(GL_CW);
-		glDepthFunc(GL_LEQUAL);
+		glstate::DepthFunc(GL_LEQUAL);
 		Skybox.use();
-		glm::mat4 view = glm::mat4(1.0f);
-		glm::vec3 cameraPos = camera.getCameraPos();
-		view = glm::lookAt(cameraPos, cameraPos + camera.getCameraFront(), camera.getCameraUp());
-		Skybox.setMat4("view", glm::mat4(glm::mat3(view)));
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-		// glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
-		//glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
-		glBindVertexArray(cube);
+		// rotation only, the cube stays centred on the camera
+		Skybox.setMat4("view", glm::mat4(glm::mat3(camera.getViewMatrix())));
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		// glstate::BindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+		glstate::BindVertexArray(cube);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glDepthFunc(GL_LESS);
+		glstate::DepthFunc(GL_LESS);
 		glFrontFace(GL_CCW);
 
 		// Debugger caching
 		DebugFramebuffer.bind();
 		DebugOutputShader.use();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		DebugOutputShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		DebugOutputShader.setMat4("view", camera.getViewMatrix());
-		DebugOutputShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), fmod(time * 30.0f, 360.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		DebugOutputShader.setModel(sphereModel);
 		DebugOutputShader.setVec3("viewPos", camera.getCameraPos());
 		DebugOutputShader.setInt("normalMap", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_normal);
-		glBindVertexArray(sphere);
-		glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, tex_normal);
+		sphere.Draw(DebugOutputShader, sphereModel, lodView);
 		DebugFramebuffer.unbind();
 
-		glDisable(GL_DEPTH_TEST);
+		glstate::Disable(GL_DEPTH_TEST);
 		DisplayFramebufferTexture(DebuggerFrame, debugFrameVAO, DebugTexture.id);
-		glEnable(GL_DEPTH_TEST);
+		glstate::Enable(GL_DEPTH_TEST);
+
+		frameCount++;
+		if (glfwGetTime() - statsTime > 5.0) {
+			Shader::printUniformStats(frameCount);
+			Mesh::printDrawStats(frameCount);
+			frameCount = 0;
+			statsTime = glfwGetTime();
+		}
+
+		frameUniforms.endFrame();
 
 		// checks events and swap buffers
 		glfwPollEvents();
@@ -8,11 +8,14 @@
 #include "../modules/model.h"
 #include "../modules/utils.h"
 #include "../modules/shader.h"
+#include "../modules/shader_variants.h"
 #include "../modules/camera.h"
 #include "../modules/framebuffer.h"
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 #include <random>
@@ -43,12 +46,12 @@ int pbr_main()
 	}
 
 	// Viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	//glFrontFace(GL_CCW);
-	//glCullFace(GL_BACK);
-	// glEnable(GL_CULL_FACE);
+	//glstate::CullFace(GL_BACK);
+	// glstate::Enable(GL_CULL_FACE);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -63,7 +66,8 @@ int pbr_main()
 	glfwSetWindowUserPointer(window, &camera);
 
 	// Shaders
-	Shader PBRShader("shaders/base_lit.vert", "shaders/pbr/pbr_textures_wnormals.frag");
+	ShaderVariants PBRVariants("shaders/base_lit.vert", "shaders/pbr/pbr_textures.frag");
+	Shader& PBRShader = PBRVariants.get(ShaderDefines().define("NORMAL_MAP").define("IBL_AMBIENT"));
 	Shader EQRToCubemap("shaders/cubemapping/eqr_to_cubemap.vert", "shaders/cubemapping/eqr_to_cubemap.frag");
 	Shader Skybox("shaders/cubemapping/skybox.vert", "shaders/cubemapping/skybox.frag");
 	Shader IrradianceShader("shaders/cubemapping/eqr_to_cubemap.vert", "shaders/cubemapping/irradiance_convolution.frag");
@@ -73,22 +77,30 @@ int pbr_main()
 	unsigned int sphere = createSphereVAO(indicesCount, 1.0f, 64, 64);
 	unsigned int cube = createCubeVAO();
 
-	// Textures
-	unsigned int tex_albedo = loadTexture("resources/textures/pbr/rusted_iron/albedo.png", true, TextureColorSpace::sRGB);
-	unsigned int tex_normal = loadTexture("resources/textures/pbr/rusted_iron/normal.png", true, TextureColorSpace::Linear);
-	unsigned int tex_metallic = loadTexture("resources/textures/pbr/rusted_iron/metallic.png", true, TextureColorSpace::Linear);
-	unsigned int tex_roughness = loadTexture("resources/textures/pbr/rusted_iron/roughness.png", true, TextureColorSpace::Linear);
-	unsigned int tex_ao = loadTexture("resources/textures/pbr/rusted_iron/ao.png", true, TextureColorSpace::Linear);
+	// Textures (material set and environment decode concurrently)
+	std::vector<unsigned int> loadedTextures = loadTextures({
+		{ "resources/textures/pbr/rusted_iron/albedo.png", true, TextureColorSpace::sRGB },
+		{ "resources/textures/pbr/rusted_iron/normal.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/metallic.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/roughness.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/ao.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/hdr/newport_loft.hdr", true, TextureColorSpace::Linear, true }
+	});
+	unsigned int tex_albedo = loadedTextures[0];
+	unsigned int tex_normal = loadedTextures[1];
+	unsigned int tex_metallic = loadedTextures[2];
+	unsigned int tex_roughness = loadedTextures[3];
+	unsigned int tex_ao = loadedTextures[4];
 
 	// HDR
 	Framebuffer hdrCapture(512, 512);
 	hdrCapture.attachRenderbuffer(GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24);
 
-	unsigned int hdr = loadHDR("resources/textures/hdr/newport_loft.hdr", true);
+	unsigned int hdr = loadedTextures[5];
 
 	unsigned int envCubemap;
 	glGenTextures(1, &envCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 	for (unsigned int i = 0; i < 6; ++i)
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -99,7 +111,7 @@ int pbr_main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
 	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
 	glm::mat4 captureViews[] =
@@ -115,8 +127,8 @@ int pbr_main()
 	EQRToCubemap.use();
 	EQRToCubemap.setInt("equirectangularMap", 0);
 	EQRToCubemap.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdr);
+	glstate::ActiveTexture(GL_TEXTURE0);
+	glstate::BindTexture(GL_TEXTURE_2D, hdr);
 
 	hdrCapture.bind();
 	for (unsigned int i = 0; i < 6; i++) {
@@ -124,16 +136,16 @@ int pbr_main()
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(cube);
+		glstate::BindVertexArray(cube);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		glstate::BindVertexArray(0);
 	}
 	hdrCapture.unbind();
 
 	// Irradiance
 	unsigned int irradianceCubemap;
 	glGenTextures(1, &irradianceCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
 	for (unsigned int i = 0; i < 6; ++i)
 	{
 		// no need for high resolution due to low frequency detailing
@@ -145,15 +157,15 @@ int pbr_main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
 	hdrCapture.editRenderbufferStorage(32, 32, GL_DEPTH_COMPONENT24);
 
 	IrradianceShader.use();
 	IrradianceShader.setInt("environmentMap", 0);
 	IrradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+	glstate::ActiveTexture(GL_TEXTURE0);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
 
 	hdrCapture.bind();
 	for (unsigned int i = 0; i < 6; i++) {
@@ -161,9 +173,9 @@ int pbr_main()
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceCubemap, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(cube);
+		glstate::BindVertexArray(cube);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		glstate::BindVertexArray(0);
 	}
 	hdrCapture.unbind();
 
@@ -189,23 +201,24 @@ int pbr_main()
 
 	std::vector<unsigned int> sphereTex = { tex_albedo, tex_normal, tex_metallic, tex_roughness, tex_ao,  };
 
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
+
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 		
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// PBR Sphere
 		PBRShader.use();
-		PBRShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		PBRShader.setMat4("view", camera.getViewMatrix());
 
 		float time = glfwGetTime();
-		PBRShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), fmod(time * 30.0f, 360.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+		PBRShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), fmod(time * 30.0f, 360.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
 		PBRShader.setVec3("viewPos", camera.getCameraPos());
 
 		// material uniforms, flip commented out code if not using textures
@@ -220,33 +233,32 @@ int pbr_main()
 		PBRShader.setInt("material.aoMap", 4);
 		bindTextures(sphereTex);
 		PBRShader.setInt("irradianceMap", 5);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
+		glstate::ActiveTexture(GL_TEXTURE5);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
 
 		// light uniforms
 		for (int i = 0; i < 4; ++i) {
 			PBRShader.setVec3("lights[" + std::to_string(i) + "].position", lightPositions[i]);
 			PBRShader.setVec3("lights[" + std::to_string(i) + "].color", lightColors[i]);
 		}
-		glBindVertexArray(sphere);
+		glstate::BindVertexArray(sphere);
 		glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
 
 		// Skybox
 		glFrontFace(GL_CW);
-		glDepthFunc(GL_LEQUAL);
+		glstate::DepthFunc(GL_LEQUAL);
 		Skybox.use();
-		glm::mat4 view = glm::mat4(1.0f);
-		glm::vec3 cameraPos = camera.getCameraPos();
-		view = glm::lookAt(cameraPos, cameraPos + camera.getCameraFront(), camera.getCameraUp());
-		Skybox.setMat4("view", glm::mat4(glm::mat3(view)));
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-		//glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
-		glBindVertexArray(cube);
+		Skybox.setMat4("view", glm::mat4(glm::mat3(camera.getViewMatrix())));
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+		//glstate::BindTexture(GL_TEXTURE_CUBE_MAP, irradianceCubemap);
+		glstate::BindVertexArray(cube);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glDepthFunc(GL_LESS);
+		glstate::DepthFunc(GL_LESS);
 		glFrontFace(GL_CCW);
 
+		frameUniforms.endFrame();
+
 		// checks events and swap buffers
 		glfwPollEvents();
 		glfwSwapBuffers(window);
@@ -13,6 +13,8 @@
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 #include <random>
@@ -43,12 +45,12 @@ int pbr_test_main()
 	}
 
 	// Viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	glFrontFace(GL_CCW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
+	glstate::CullFace(GL_BACK);
+	glstate::Enable(GL_CULL_FACE);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -68,19 +70,19 @@ int pbr_test_main()
 
 	Shader PBRShader("shaders/base_vertex.vert", "shaders/pbr/pbr_test.frag");
 
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		PBRShader.use();
-		PBRShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		PBRShader.setMat4("view", camera.getViewMatrix());
-		PBRShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
+		PBRShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(0.0f, 1.0f, 0.0f)));
 		PBRShader.setVec3("viewPos", camera.getCameraPos());
 
 		float time = glfwGetTime();
@@ -95,9 +97,11 @@ int pbr_test_main()
 		PBRShader.setVec3("material.baseColor", glm::vec3(1.0f, 0.0f, 1.0f));
 		PBRShader.setFloat("material.roughness", 0.1f);
 
-		glBindVertexArray(sphere);
+		glstate::BindVertexArray(sphere);
 		glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
 		
+		frameUniforms.endFrame();
+
 		// checks events and swap buffers
 		glfwPollEvents();
 		glfwSwapBuffers(window);
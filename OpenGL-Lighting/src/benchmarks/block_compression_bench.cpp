@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "../modules/image_decoder.h"
+#include "../modules/block_compressor.h"
+
+// a red to green ramp keeps r+g+b constant, so its spread is orthogonal to both the luminance axis and
+// the block's bounding box diagonal. the color encoders have to keep two distinct endpoints for it.
+static void checkChromaGradient()
+{
+	unsigned char ramp[16 * 4];
+	for (int i = 0; i < 16; i++) {
+		ramp[i * 4 + 0] = static_cast<unsigned char>(255 - 17 * i);
+		ramp[i * 4 + 1] = static_cast<unsigned char>(17 * i);
+		ramp[i * 4 + 2] = 0;
+		ramp[i * 4 + 3] = 255;
+	}
+
+	std::vector<unsigned char> bc1 = compressImage(ramp, 4, 4, 4, BlockFormat::BC1, nullptr);
+	if (bc1[0] == bc1[2] && bc1[1] == bc1[3])
+		std::cout << "ERROR::BLOCK_COMPRESSION::BC1 collapsed a chroma gradient to one endpoint" << std::endl;
+
+	std::vector<unsigned char> bc7 = compressImage(ramp, 4, 4, 4, BlockFormat::BC7, nullptr);
+	std::vector<unsigned char> decoded = decompressImage(bc7.data(), 4, 4, BlockFormat::BC7);
+	if (std::equal(decoded.begin(), decoded.begin() + 4, decoded.end() - 4))
+		std::cout << "ERROR::BLOCK_COMPRESSION::BC7 collapsed a chroma gradient to one endpoint" << std::endl;
+}
+
+// encodes the base level of every pbr/cyborg texture once on the calling thread and once across the
+// shared pool, then decodes it again to report the psnr. needs no gl context.
+int block_compression_bench_main()
+{
+	checkChromaGradient();
+
+	struct Entry {
+		const char* path;
+		TextureCompression compression;
+	};
+	const Entry textures[] = {
+		{ "resources/textures/pbr/gold/albedo.png", TextureCompression::Color },
+		{ "resources/textures/pbr/gold/normal.png", TextureCompression::Normal },
+		{ "resources/textures/pbr/gold/metallic.png", TextureCompression::Mask },
+		{ "resources/textures/pbr/gold/roughness.png", TextureCompression::Mask },
+		{ "resources/textures/pbr/gold/ao.png", TextureCompression::Mask },
+		{ "resources/textures/pbr/grass/roughness.png", TextureCompression::Mask },
+		{ "resources/textures/pbr/plastic/albedo.png", TextureCompression::Color },
+		{ "resources/textures/pbr/rusted_iron/metallic.png", TextureCompression::Mask },
+		{ "resources/textures/pbr/wall/roughness.png", TextureCompression::Mask },
+		{ "resources/objects/cyborg/cyborg_diffuse.png", TextureCompression::Color },
+		{ "resources/objects/cyborg/cyborg_normal.png", TextureCompression::Normal },
+		{ "resources/objects/cyborg/cyborg_specular.png", TextureCompression::Color }
+	};
+
+	std::cout << std::left << std::setw(50) << "texture" << std::setw(6) << "fmt" << std::setw(12) << "size"
+		<< std::right << std::setw(12) << "serial MP/s" << std::setw(12) << "pool MP/s"
+		<< std::setw(8) << "ratio" << std::setw(10) << "PSNR dB" << std::endl;
+
+	double totalSerialMs = 0.0;
+	double totalPoolMs = 0.0;
+	for (const Entry& entry : textures) {
+		DecodedImage image = decodeImage(entry.path, false);
+		if (!image.valid()) {
+			std::cout << std::left << std::setw(50) << entry.path << "failed to load" << std::endl;
+			continue;
+		}
+
+		const unsigned char* pixels = static_cast<const unsigned char*>(image.data);
+		BlockFormat format = chooseBlockFormat(entry.compression, image.channels);
+		double megapixels = static_cast<double>(image.width) * image.height / 1e6;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		std::vector<unsigned char> serial = compressImage(pixels, image.width, image.height, image.channels, format, nullptr);
+		auto mid = std::chrono::high_resolution_clock::now();
+		std::vector<unsigned char> pooled = compressImage(pixels, image.width, image.height, image.channels, format);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		double serialMs = std::chrono::duration<double, std::milli>(mid - start).count();
+		double poolMs = std::chrono::duration<double, std::milli>(end - mid).count();
+		totalSerialMs += serialMs;
+		totalPoolMs += poolMs;
+
+		std::vector<unsigned char> decoded = decompressImage(pooled.data(), image.width, image.height, format);
+		double psnr = computePSNR(pixels, image.channels, decoded.data(), image.width, image.height, format);
+		double ratio = static_cast<double>(image.width) * image.height * image.channels / pooled.size();
+
+		std::cout << std::left << std::setw(50) << entry.path << std::setw(6) << blockFormatName(format)
+			<< std::setw(12) << (std::to_string(image.width) + "x" + std::to_string(image.height))
+			<< std::right << std::fixed << std::setprecision(1)
+			<< std::setw(12) << megapixels / (serialMs / 1000.0)
+			<< std::setw(12) << megapixels / (poolMs / 1000.0)
+			<< std::setw(7) << ratio << "x";
+		if (std::isinf(psnr))
+			std::cout << std::setw(10) << "inf" << std::endl;
+		else
+			std::cout << std::setw(10) << psnr << std::endl;
+
+		if (serial != pooled)
+			std::cout << "ERROR::BLOCK_COMPRESSION::Serial and pooled output differ for " << entry.path << std::endl;
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << "total encode: " << totalSerialMs << " ms serial, "
+		<< totalPoolMs << " ms pooled (" << ThreadPool::shared().size() << " threads)" << std::endl;
+	return 0;
+}
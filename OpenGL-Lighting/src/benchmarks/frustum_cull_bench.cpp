@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../modules/frustum.h"
+
+// tests 1M random boxes against a camera frustum with the scalar and the SSE2 loop of cullBoxes,
+// per frame the way a scene of that many meshes would be culled. cpu only, no window or context is created.
+int frustum_cull_bench_main()
+{
+	const size_t boxCount = 1000000;
+	const int iterations = 50;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.5f, 8.0f);
+	BoxBatch boxes;
+	boxes.reserve(boxCount);
+	for (size_t i = 0; i < boxCount; i++) {
+		glm::vec3 minimum(position(rng), position(rng), position(rng));
+		boxes.add(minimum, minimum + glm::vec3(size(rng), size(rng), size(rng)));
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1600.0f / 1200.0f, 0.1f, 1000.0f);
+	std::vector<unsigned char> visible(boxCount);
+
+	std::cout << std::left << std::setw(10) << "loop" << std::right << std::setw(12) << "visible"
+		<< std::setw(12) << "ms" << std::setw(14) << "Mboxes/s" << std::endl;
+
+	size_t visibleCounts[2] = {};
+	std::vector<unsigned char> results[2];
+	const char* loops[] = { "scalar", "sse2" };
+	for (int simd = 0; simd < 2; simd++) {
+		double totalMs = 0.0;
+		size_t visibleCount = 0;
+		for (int i = 0; i < iterations; i++) {
+			// the camera turns a little every frame so no two passes see the same planes
+			float angle = glm::radians(360.0f * i / iterations);
+			glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::sin(angle), 0.1f, std::cos(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+			Frustum frustum(projection * view);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			visibleCount += cullBoxes(frustum, boxes, visible.data(), simd != 0);
+			auto end = std::chrono::high_resolution_clock::now();
+			totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+		}
+		visibleCounts[simd] = visibleCount;
+		results[simd] = visible;
+
+		double ms = totalMs / iterations;
+		std::cout << std::left << std::setw(10) << loops[simd] << std::right << std::setw(12) << visibleCount / iterations
+			<< std::setw(12) << std::fixed << std::setprecision(3) << ms
+			<< std::setw(14) << std::setprecision(1) << boxCount / ms / 1000.0 << std::endl;
+	}
+
+	// without SSE2 compiled in both rows ran the scalar loop
+	if (visibleCounts[0] != visibleCounts[1] || results[0] != results[1])
+		std::cout << "ERROR::FRUSTUM_CULL_BENCH::SCALAR_AND_SIMD_RESULTS_DIFFER" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../modules/model.h"
+#include "../modules/mesh_cache.h"
+#include "../modules/texture_cache.h"
+
+// loads every model in resources/objects twice: once with the cache removed (cold, assimp import
+// plus cache write) and once from the freshly written cache (warm).
+int mesh_cache_bench_main()
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Mesh Cache Benchmark", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	const char* models[] = {
+		"resources/objects/cyborg/cyborg.obj",
+		"resources/objects/backpack/backpack.obj",
+		"resources/objects/rock/rock.obj",
+		"resources/objects/planet/planet.obj"
+	};
+
+	struct Result {
+		const char* path;
+		double coldMs;
+		double warmMs;
+		bool warmHit;
+	};
+	std::vector<Result> results;
+
+	for (const char* path : models) {
+		std::remove(MeshCache::cachePathFor(path).c_str());
+
+		// cold is gone before warm loads so its textures aren't shared through the texture cache
+		double coldMs;
+		{
+			Model cold(path);
+			coldMs = cold.getLoadTimeMs();
+		}
+		Model warm(path);
+		results.push_back({ path, coldMs, warm.getLoadTimeMs(), warm.isLoadedFromCache() });
+	}
+
+	std::cout << std::endl << std::left << std::setw(44) << "model" << std::right
+		<< std::setw(12) << "cold (ms)" << std::setw(12) << "warm (ms)" << std::setw(10) << "speedup" << std::endl;
+	for (const Result& r : results) {
+		std::cout << std::left << std::setw(44) << r.path << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << r.coldMs << std::setw(12) << r.warmMs;
+		if (r.warmHit && r.warmMs > 0.0)
+			std::cout << std::setw(9) << r.coldMs / r.warmMs << "x" << std::endl;
+		else
+			std::cout << std::setw(10) << "miss" << std::endl;
+	}
+
+	// two live copies of the same model, the second one should take every texture from the cache
+	{
+		Model first(models[1]);
+		Model second(models[1]);
+		std::cout << std::endl;
+		TextureCache::instance().printStats();
+	}
+
+	glfwTerminate();
+
+	return 0;
+}
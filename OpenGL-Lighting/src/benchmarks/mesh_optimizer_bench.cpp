@@ -0,0 +1,83 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "../modules/model.h"
+#include "../modules/mesh_optimizer.h"
+
+// imports the demo models the way Model does and replays their index buffers through the fifo cache
+// simulator as imported, after welding + optimizeMesh and after the same with the overdraw pass.
+// cpu only, no window or context is created.
+int mesh_optimizer_bench_main()
+{
+	const char* models[] = {
+		"resources/objects/cyborg/cyborg.obj",
+		"resources/objects/backpack/backpack.obj",
+		"resources/objects/rock/rock.obj",
+		"resources/objects/planet/planet.obj"
+	};
+	const unsigned int cacheSizes[] = { 16, 32 };
+	const char* passes[] = { "assimp", "vcache", "vcache+overdraw" };
+
+	std::cout << std::left << std::setw(44) << "model" << std::setw(18) << "order" << std::right
+		<< std::setw(10) << "acmr 16" << std::setw(10) << "atvr 16" << std::setw(10) << "acmr 32" << std::setw(10) << "atvr 32"
+		<< std::setw(10) << "ms" << std::endl;
+
+	for (const char* path : models) {
+		Assimp::Importer import;
+		const aiScene* scene = import.ReadFile(path, MODEL_IMPORT_FLAGS);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+			std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+			continue;
+		}
+
+		// per pass and cache size, summed over every mesh so the ratios come out triangle weighted
+		double transforms[3][2] = {};
+		double referenced[3][2] = {};
+		double optimizeMs[3] = {};
+		double triangles = 0.0;
+
+		for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+			// every attribute, so welding keeps the same uv, normal and tangent seams the import does
+			std::vector<Vertex> sourceVertices;
+			std::vector<unsigned int> sourceIndices;
+			Model::readMeshGeometry(scene->mMeshes[m], sourceVertices, sourceIndices);
+			if (sourceIndices.size() < 3) continue;
+			triangles += static_cast<double>(sourceIndices.size() / 3);
+
+			for (int pass = 0; pass < 3; pass++) {
+				std::vector<Vertex> vertices = sourceVertices;
+				std::vector<unsigned int> indices = sourceIndices;
+				if (pass > 0) {
+					auto start = std::chrono::high_resolution_clock::now();
+					weldVertices(vertices, indices);
+					optimizeMesh(vertices, indices, pass == 2);
+					auto end = std::chrono::high_resolution_clock::now();
+					optimizeMs[pass] += std::chrono::duration<double, std::milli>(end - start).count();
+				}
+
+				for (int c = 0; c < 2; c++) {
+					VertexCacheStats stats = simulateVertexCache(indices.data(), indices.size(), vertices.size(), cacheSizes[c]);
+					double meshTransforms = stats.acmr * static_cast<double>(indices.size() / 3);
+					transforms[pass][c] += meshTransforms;
+					// transforms over atvr gives back the referenced vertex count
+					if (stats.atvr > 0.0f)
+						referenced[pass][c] += meshTransforms / stats.atvr;
+				}
+			}
+		}
+
+		if (triangles == 0.0) continue;
+		for (int pass = 0; pass < 3; pass++) {
+			std::cout << std::left << std::setw(44) << path << std::setw(18) << passes[pass] << std::right << std::fixed << std::setprecision(3);
+			for (int c = 0; c < 2; c++)
+				std::cout << std::setw(10) << transforms[pass][c] / triangles << std::setw(10) << transforms[pass][c] / referenced[pass][c];
+			std::cout << std::setprecision(2) << std::setw(10) << optimizeMs[pass] << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../modules/utils.h"
+#include "../modules/transform_store.h"
+
+// builds the model matrices of 100k objects with computeModelMatrix in a loop and with TransformStore::update,
+// scalar and SSE2 on one thread, SSE2 on the shared pool, and SSE2 with a tenth of the objects dirty.
+// cpu only, no window or context is created.
+int transform_bench_main()
+{
+	const size_t objectCount = 100000;
+	const int iterations = 50;
+
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<glm::vec3> positions(objectCount), scales(objectCount), axes(objectCount);
+	std::vector<float> angles(objectCount);
+	TransformStore store;
+	store.reserve(objectCount);
+	for (size_t i = 0; i < objectCount; i++) {
+		positions[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 100.0f;
+		scales[i] = glm::vec3(1.5f + unit(rng), 1.5f + unit(rng), 1.5f + unit(rng));
+		axes[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 0.01f));
+		angles[i] = unit(rng) * 180.0f;
+		store.add(positions[i], angles[i], axes[i], scales[i]);
+	}
+	std::vector<glm::mat4> reference(objectCount);
+
+	std::cout << std::left << std::setw(28) << "path" << std::right << std::setw(12) << "ms" << std::setw(14) << "Mmatrices/s"
+		<< std::setw(14) << "max error" << std::endl;
+
+	auto report = [&](const char* path, double ms, size_t matrices, bool check) {
+		float maxError = 0.0f;
+		if (check) {
+			for (size_t i = 0; i < objectCount; i++)
+				for (int c = 0; c < 4; c++)
+					for (int r = 0; r < 4; r++)
+						maxError = std::max(maxError, std::abs(store.getMatrix(static_cast<uint32_t>(i))[c][r] - reference[i][c][r]));
+		}
+		std::cout << std::left << std::setw(28) << path << std::right << std::setw(12) << std::fixed << std::setprecision(3) << ms
+			<< std::setw(14) << std::setprecision(1) << matrices / ms / 1000.0;
+		if (check)
+			std::cout << std::setw(14) << std::scientific << std::setprecision(2) << maxError;
+		std::cout << std::endl;
+	};
+
+	double totalMs = 0.0;
+	for (int n = 0; n < iterations; n++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < objectCount; i++)
+			reference[i] = computeModelMatrix(positions[i], scales[i], angles[i], axes[i]);
+		auto end = std::chrono::high_resolution_clock::now();
+		totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+	}
+	report("computeModelMatrix", totalMs / iterations, objectCount, false);
+
+	struct Pass {
+		const char* path;
+		bool simd;
+		bool parallel;
+		size_t dirtyStride; // every n-th object dirty
+	};
+	const Pass passes[] = {
+		{ "store scalar", false, false, 1 },
+		{ "store sse2", true, false, 1 },
+		{ "store sse2 pool", true, true, 1 },
+		{ "store sse2 10% dirty", true, false, 10 },
+	};
+	for (const Pass& pass : passes) {
+		totalMs = 0.0;
+		size_t updated = 0;
+		for (int n = 0; n < iterations; n++) {
+			if (pass.dirtyStride == 1) {
+				store.markAllDirty();
+			}
+			else {
+				for (size_t i = n % pass.dirtyStride; i < objectCount; i += pass.dirtyStride)
+					store.setScale(static_cast<uint32_t>(i), scales[i]);
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			updated += store.update(pass.simd, pass.parallel);
+			auto end = std::chrono::high_resolution_clock::now();
+			totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+		}
+		report(pass.path, totalMs / iterations, updated / iterations, pass.dirtyStride == 1);
+	}
+
+	return 0;
+}
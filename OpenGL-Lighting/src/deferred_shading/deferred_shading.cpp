@@ -10,9 +10,13 @@
 #include "../modules/shader.h"
 #include "../modules/camera.h"
 #include "../modules/framebuffer.h"
-#include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/texture_streamer.h"
+#include "../modules/render_queue.h"
+#include "../modules/uniform_ring.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 
@@ -42,12 +46,12 @@ int deferred_main()
 	}
 
 	// Viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	glFrontFace(GL_CCW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
+	glstate::CullFace(GL_BACK);
+	glstate::Enable(GL_CULL_FACE);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -91,18 +95,24 @@ int deferred_main()
 	unsigned int frameVAO = createFrameVAO();
 
 	// Objects
-	Model cyborg("resources/objects/cyborg/cyborg.obj");
+	// textures stream in over the first frames instead of blocking startup
+	Model cyborg("resources/objects/cyborg/cyborg.obj", true, true, VertexLayout::CompactQuantized);
 	unsigned int floorVAO = createQuadVAO();
-	unsigned int tex_diff = loadTexture("resources/textures/brickwall.jpg", true, TextureColorSpace::sRGB);
+	unsigned int tex_diff;
+	streamTexture("resources/textures/brickwall.jpg", true, TextureColorSpace::sRGB, tex_diff);
 	unsigned int tex_spec = createDefaultTexture();
 
-	unsigned int indicesCount;
-	unsigned int lightSphere = createSphereVAO(indicesCount, 1.0f, 16, 16);
+	// light volumes and markers drop to coarser spheres once the missing detail is under a pixel
+	Mesh lightSphere = createSphereMesh(1.0f, 16, 16);
 
 	// Shaders
 	Shader gBufferShader("shaders/base_vertex.vert", "shaders/deferred/def_gbf.frag");
+	Shader cyborgGBufferShader("shaders/base_vertex.vert", "shaders/deferred/def_gbf.frag", ShaderDefines().define("COMPACT_VERTEX"));
 	Shader baseColorShader("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_basecolor.frag");
-	Shader lightingShader("shaders/deferred/def_lightvolume.vert", "shaders/deferred/def_lightvolume.frag");
+	// the light block is sized at compile time, it has to match the array below
+	const unsigned int NR_LIGHTS = 32;
+	Shader lightingShader("shaders/deferred/def_lightvolume.vert", "shaders/deferred/def_lightvolume.frag",
+		ShaderDefines().define("NR_LIGHTS", (int)NR_LIGHTS));
 	Shader lightSphereShader("shaders/base_vertex.vert", "shaders/emissive_color.frag");
 
 	std::vector<unsigned int> textureIDs = { gPosition.id, gNormal.id, gAlbedoSpec.id };
@@ -114,7 +124,6 @@ int deferred_main()
 		glm::vec3 Color;
 		float Radius;
 	};
-	const unsigned int NR_LIGHTS = 32;
 	Light lights[NR_LIGHTS];
 
 	float radius = 5.0f;
@@ -124,11 +133,41 @@ int deferred_main()
 		lights[i].Color = glm::vec3((sin(angle) + 1.0f) * 0.5f, (cos(angle) + 1.0f) * 0.5f, 0.5f);
 		lights[i].Radius = radius;
 	}
-	UniformBuffer uboLights(sizeof(lights));
+	// the light block is rewritten every frame while the lights move, it streams through the ring so the
+	// upload never waits on the frames still reading last frame's copy. the camera block shares the ring,
+	// it starts at the first aligned offset after the lights.
+	bool animateLights = true;
+	UniformRing uniformRing(sizeof(lights) + 256 + sizeof(FrameData));
 	unsigned int bindingPoint = 0;
-	unsigned int uniformBlockIndex = glGetUniformBlockIndex(lightingShader.ID, "LightBlock");
-	uboLights.bindBufferBase(bindingPoint);
-	uboLights.setData(&lights, sizeof(lights));
+	FrameUniforms frameUniforms(uniformRing);
+
+	// what each light's packets set on top of the model matrix
+	struct LightDraw {
+		glm::vec3 Color;
+		int index;
+	};
+	LightDraw lightDraws[NR_LIGHTS];
+	for (unsigned int i = 0; i < NR_LIGHTS; i++)
+		lightDraws[i] = { lights[i].Color, (int)i };
+	PacketUniforms lightVolumeUniforms = [](Shader& shader, const void* user) {
+		const LightDraw* light = static_cast<const LightDraw*>(user);
+		shader.setVec3("Color", light->Color);
+		shader.setInt("lightIndex", light->index);
+	};
+	PacketUniforms lightMarkerUniforms = [](Shader& shader, const void* user) {
+		shader.setVec3("Color", static_cast<const LightDraw*>(user)->Color);
+	};
+
+	// every pass is submitted up front, then sorted and drawn pass by pass
+	enum { GEOMETRY_PASS, LIGHT_VOLUME_PASS, LIGHT_MARKER_PASS };
+	RenderQueue queue("deferred queue");
+	queue.setDepthRange(0.1f, 1000.0f);
+	queue.setBackToFront(LIGHT_MARKER_PASS, true);
+
+	FrustumCullStats lightVolumeCullStats("light volumes");
+	FrustumCullStats lightMarkerCullStats("light markers");
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
 
 	srand(glfwGetTime());
 	// render loop
@@ -136,113 +175,128 @@ int deferred_main()
 	{
 		// input
 		processInput(window);
+		TextureStreamer::instance().update();
 
-		/*
 		// light movement test
-		float time = glfwGetTime() * 0.5f;
-		radius = 5.0f + sin(time) * (10.0f - 5.0f);
+		if (animateLights) {
+			float time = glfwGetTime() * 0.5f;
+			radius = 5.0f + sin(time) * (10.0f - 5.0f);
+			for (unsigned int i = 0; i < NR_LIGHTS; i++) {
+				float angle = (float)i / (float)NR_LIGHTS * 2.0f * glm::pi<float>();
+				lights[i].Position = glm::vec3(sin(fmod(time * angle, 360.0)) * radius, 0.5f + (float)i / (float)NR_LIGHTS * (0.1f - 0.5f), cos(fmod(time * angle, 360.0)) * radius);
+				lights[i].Color = glm::vec3((sin(fmod(time * angle, 360.0)) + 1.0f) * 0.5f, (cos(fmod(time * angle, 360.0)) + 1.0f) * 0.5f, 0.5f);
+				lights[i].Radius = radius;
+				lightDraws[i].Color = lights[i].Color;
+			}
+		}
+		uniformRing.beginFrame();
+		UniformRing::bind(bindingPoint, uniformRing.push(lights));
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
+		Frustum frustum = camera.getFrustum(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
+		glm::vec3 cameraPos = camera.getCameraPos();
+		LODView lodView(cameraPos, camera.getFOV(), (float)W_HEIGHT);
+
+		// cyborg model, stored in the compact layout, and the floor. tex_diff holds the streamer's placeholder
+		// until the brick texture is in, so the ids are read again every frame
+		glm::mat4 model = glm::mat4(1.0f);
+		unsigned int floorTextures[] = { tex_diff, tex_spec };
+		queue.submit(GEOMETRY_PASS, cyborgGBufferShader, cyborg, model, glm::length(cameraPos), &lodView);
+		queue.submitArrays(GEOMETRY_PASS, gBufferShader, floorVAO, 0, 6, computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)), 0.0f, floorTextures, 2);
+
+		// a volume outside the frustum lights nothing on screen
 		for (unsigned int i = 0; i < NR_LIGHTS; i++) {
-			float angle = (float)i / (float)NR_LIGHTS * 2.0f * glm::pi<float>();
-			lights[i].Position = glm::vec3(sin(fmod(time * angle, 360.0)) * radius, 0.5f + (float)i / (float)NR_LIGHTS * (0.1f - 0.5f), cos(fmod(time * angle, 360.0)) * radius);
-			lights[i].Color = glm::vec3((sin(fmod(time * angle, 360.0)) + 1.0f) * 0.5f, (cos(fmod(time * angle, 360.0)) + 1.0f) * 0.5f, 0.5f);
-			lights[i].Radius = radius;
+			lightVolumeCullStats.tested++;
+			if (!frustum.intersectsSphere(lights[i].Position, lights[i].Radius)) {
+				lightVolumeCullStats.culled++;
+				continue;
+			}
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, lights[i].Position);
+			model = glm::scale(model, glm::vec3(lights[i].Radius));
+			queue.submit(LIGHT_VOLUME_PASS, lightingShader, lightSphere, model, glm::length(lights[i].Position - cameraPos),
+				lightSphere.selectLOD(model, lodView), lightVolumeUniforms, &lightDraws[i]);
 		}
-		uboLights.setData(&lights, sizeof(lights));
-		*/
+
+		for (unsigned int i = 0; i < NR_LIGHTS; i++) {
+			lightMarkerCullStats.tested++;
+			if (!frustum.intersectsSphere(lights[i].Position, 0.25f)) {
+				lightMarkerCullStats.culled++;
+				continue;
+			}
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, lights[i].Position);
+			model = glm::scale(model, glm::vec3(0.25f));
+			queue.submit(LIGHT_MARKER_PASS, lightSphereShader, lightSphere, model, glm::length(lights[i].Position - cameraPos),
+				lightSphere.selectLOD(model, lodView), lightMarkerUniforms, &lightDraws[i]);
+		}
+
 		// Geometry pass
 		gBuffer.bind();
 		glClearColor(0.0, 0.0, 0.0, 1.0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		gBufferShader.use();
-		gBufferShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		gBufferShader.setMat4("view", camera.getViewMatrix());
-
-		// render cyborg model
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-		gBufferShader.setMat4("model", model);
-		cyborg.Draw(gBufferShader);
-
-		// render floor
-		gBufferShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
-			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		gBufferShader.setInt("texture_diffuse1", 0);
 		gBufferShader.setInt("texture_specular1", 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_diff);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_spec);
-		glBindVertexArray(floorVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		queue.execute(GEOMETRY_PASS);
 		gBuffer.unbind();
 
 		// Base color pass
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glDisable(GL_DEPTH_TEST);
+		glstate::Disable(GL_DEPTH_TEST);
 
 		baseColorShader.use();
 		baseColorShader.setInt("gAlbedoSpec", 0);
 		baseColorShader.setFloat("ambient", 0.5f);
-		baseColorShader.setVec3("viewPos", camera.getCameraPos());
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gAlbedoSpec.id);
-		glBindVertexArray(frameVAO);
+		baseColorShader.setVec3("viewPos", cameraPos);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, gAlbedoSpec.id);
+		glstate::BindVertexArray(frameVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 		// Lighting pass
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_FRONT);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_ONE, GL_ONE);
+		glstate::Enable(GL_CULL_FACE);
+		glstate::CullFace(GL_FRONT);
+		glstate::Enable(GL_BLEND);
+		glstate::BlendFunc(GL_ONE, GL_ONE);
 
 		lightingShader.use();
 		lightingShader.setInt("gPosition", 0);
 		lightingShader.setInt("gNormal", 1);
 		lightingShader.setInt("gAlbedoSpec", 2);
-		lightingShader.setVec3("viewPos", camera.getCameraPos());
-		lightingShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		lightingShader.setMat4("view", camera.getViewMatrix());
+		lightingShader.setVec3("viewPos", cameraPos);
 		bindTextures(textureIDs);
+		queue.execute(LIGHT_VOLUME_PASS);
+		glstate::Disable(GL_BLEND);
+		glstate::CullFace(GL_BACK);
 
-		for (unsigned int i = 0; i < NR_LIGHTS; i++) {
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, lights[i].Position);
-			model = glm::scale(model, glm::vec3(lights[i].Radius));
-			lightingShader.setMat4("model", model);
-			lightingShader.setVec3("Color", lights[i].Color);
-			lightingShader.setInt("lightIndex", i);
-			glBindVertexArray(lightSphere);
-			glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
-		}
-		glDisable(GL_BLEND);
-		glCullFace(GL_BACK);
-
-		glEnable(GL_DEPTH_TEST);
+		glstate::Enable(GL_DEPTH_TEST);
 		gBuffer.bind();
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.FBO);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.FBO);
+		glstate::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		glBlitFramebuffer(0, 0, W_WIDTH, W_HEIGHT, 0, 0, W_WIDTH, W_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// additional forward rendering pass
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		lightSphereShader.use();
-		lightSphereShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		lightSphereShader.setMat4("view", camera.getViewMatrix());
-
-		for (unsigned int i = 0; i < NR_LIGHTS; i++) {
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, lights[i].Position);
-			model = glm::scale(model, glm::vec3(0.25f));
-			lightSphereShader.setMat4("model", model);
-			lightSphereShader.setVec3("Color", lights[i].Color);
-			glBindVertexArray(lightSphere);
-			glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, 0);
+		glstate::Enable(GL_BLEND);
+		glstate::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		queue.execute(LIGHT_MARKER_PASS);
+		glstate::Disable(GL_BLEND);
+		queue.clear();
+		uniformRing.endFrame();
+
+		frameCount++;
+		if (glfwGetTime() - statsTime > 5.0) {
+			lightVolumeCullStats.print(frameCount);
+			lightMarkerCullStats.print(frameCount);
+			queue.stats.print(frameCount);
+			glstate::printStats(frameCount);
+			uniformRing.printStats(frameCount);
+			frameCount = 0;
+			statsTime = glfwGetTime();
 		}
-		glDisable(GL_BLEND);
 
 		// checks events and swap buffers
 		glfwPollEvents();
@@ -8,11 +8,14 @@
 #include "../modules/model.h"
 #include "../modules/utils.h"
 #include "../modules/shader.h"
+#include "../modules/shader_variants.h"
 #include "../modules/camera.h"
 #include "../modules/framebuffer.h"
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 #include <random>
@@ -43,12 +46,12 @@ int ssao_main()
 	}
 
 	// Viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
+	glstate::Enable(GL_DEPTH_TEST);
 	glFrontFace(GL_CCW);
-	glCullFace(GL_BACK);
-	glEnable(GL_CULL_FACE);
+	glstate::CullFace(GL_BACK);
+	glstate::Enable(GL_CULL_FACE);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -106,23 +109,36 @@ int ssao_main()
 	// Normal oriented hemisphere
 	std::uniform_real_distribution<float> randomFloats(0.0, 1.0);
 	std::default_random_engine generator;
-	std::vector<glm::vec3> ssaoKernel;
 
-	for (unsigned int i = 0; i < 64; ++i)
+	// quality tiers, 1/2/3 switch between them. every tier is its own compiled variant of def_ssao.frag
+	// with a kernel spread over its own sample count.
+	const int SSAO_TIERS[] = { 16, 32, 64 };
+	struct SSAOTier {
+		std::vector<glm::vec3> kernel;
+		std::vector<UniformHandle<glm::vec3>> samples;
+		Shader* shader = nullptr;
+	};
+	SSAOTier ssaoTiers[3];
+
+	for (int tier = 0; tier < 3; tier++)
 	{
-		glm::vec3 sample(
-			randomFloats(generator) * 2.0 - 1.0,
-			randomFloats(generator) * 2.0 - 1.0,
-			randomFloats(generator) // z-axis only range 0 to 1
-		);
-		sample = glm::normalize(sample);
-		sample *= randomFloats(generator);
-
-		// distribute samples nearer to the fragment
-		float scale = (float)i / 64.0;
-		scale = lerp(0.1f, 1.0f, scale * scale);
-		sample *= scale;
-		ssaoKernel.push_back(sample);
+		int kernelSize = SSAO_TIERS[tier];
+		for (int i = 0; i < kernelSize; ++i)
+		{
+			glm::vec3 sample(
+				randomFloats(generator) * 2.0 - 1.0,
+				randomFloats(generator) * 2.0 - 1.0,
+				randomFloats(generator) // z-axis only range 0 to 1
+			);
+			sample = glm::normalize(sample);
+			sample *= randomFloats(generator);
+
+			// distribute samples nearer to the fragment
+			float scale = (float)i / (float)kernelSize;
+			scale = lerp(0.1f, 1.0f, scale * scale);
+			sample *= scale;
+			ssaoTiers[tier].kernel.push_back(sample);
+		}
 	}
 
 	// Random rotation vector texture
@@ -140,22 +156,49 @@ int ssao_main()
 
 	// Shaders
 	Shader gBufferShader("shaders/deferred/def_gbf_ssao.vert", "shaders/deferred/def_gbf_ssao.frag");
-	Shader ssaoShader("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_ssao.frag");
+	ShaderVariants ssaoVariants("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_ssao.frag");
 	Shader ssaoBlurShader("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_ssao_blur.frag");
 	Shader baseColorShader("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_basecolor.frag");
-	Shader lightingShader("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_lit_ao.frag");
+	ShaderVariants lightingVariants("shaders/post_process/framebuffer_quad.vert", "shaders/deferred/def_lit.frag");
+	Shader& lightingShader = lightingVariants.get(ShaderDefines().define("SSAO"));
 	Shader lightSphereShader("shaders/base_vertex.vert", "shaders/emissive_color.frag");
 
 	std::vector<unsigned int> gBufferTex = { gPosition.id, gNormal.id, gAlbedoSpec.id };
 	std::vector<unsigned int> aoBufferTex = { gPosition.id, gNormal.id, noiseTexture.id };
 	std::vector<unsigned int> lightingPassTex = { gPosition.id, gNormal.id, gAlbedoSpec.id, ssaoBlurColor.id };
 
+	// variants compile on first use, sample locations are resolved once per variant
+	int ssaoTier = 2;
+	auto selectSSAOTier = [&](int tier) {
+		ssaoTier = tier;
+		SSAOTier& selected = ssaoTiers[tier];
+		if (selected.shader) return;
+
+		selected.shader = &ssaoVariants.get(ShaderDefines().define("KERNEL_SIZE", SSAO_TIERS[tier]));
+		for (int i = 0; i < SSAO_TIERS[tier]; i++)
+			selected.samples.push_back(selected.shader->getUniform<glm::vec3>("samples[" + std::to_string(i) + "]"));
+		std::cout << "SSAO kernel size " << SSAO_TIERS[tier] << std::endl;
+		ShaderVariants::printStats();
+	};
+	selectSSAOTier(ssaoTier);
+	UniformHandle<int> floorDiffuse = gBufferShader.getUniform<int>("texture_diffuse1");
+	UniformHandle<int> floorSpecular = gBufferShader.getUniform<int>("texture_specular1");
+
 	srand(glfwGetTime());
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
+	MeshletCullStats gBufferCullStats("g-buffer");
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		for (int tier = 0; tier < 3; tier++) {
+			if (glfwGetKey(window, GLFW_KEY_1 + tier) == GLFW_PRESS && tier != ssaoTier)
+				selectSSAOTier(tier);
+		}
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		// Geometry pass
 		gBuffer.bind();
@@ -163,25 +206,23 @@ int ssao_main()
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		gBufferShader.use();
-		gBufferShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		gBufferShader.setMat4("view", camera.getViewMatrix());
 
 		// render cyborg model
 		glm::mat4 model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-		gBufferShader.setMat4("model", model);
-		cyborg.Draw(gBufferShader);
+		cyborg.DrawCulled(gBufferShader, MeshletCullView(camera.getProjectionMatrix(), camera.getViewMatrix(), model), model,
+			&gBufferCullStats);
 
 		// render floor
-		gBufferShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		gBufferShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		gBufferShader.setInt("texture_diffuse1", 0);
-		gBufferShader.setInt("texture_specular1", 1);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, tex_diff);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, tex_spec);
-		glBindVertexArray(floorVAO);
+		gBufferShader.set(floorDiffuse, 0);
+		gBufferShader.set(floorSpecular, 1);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, tex_diff);
+		glstate::ActiveTexture(GL_TEXTURE1);
+		glstate::BindTexture(GL_TEXTURE_2D, tex_spec);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		gBuffer.unbind();
 
@@ -189,19 +230,20 @@ int ssao_main()
 		ssaoBuffer.bind();
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glDisable(GL_DEPTH_TEST);
+		glstate::Disable(GL_DEPTH_TEST);
+		SSAOTier& ssao = ssaoTiers[ssaoTier];
+		Shader& ssaoShader = *ssao.shader;
 		ssaoShader.use();
-		ssaoShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
 		ssaoShader.setInt("gPosition", 0);
 		ssaoShader.setInt("gNormal", 1);
 		ssaoShader.setInt("texNoise", 2);
 		// send kernel samples to shader
-		for (unsigned int i = 0; i < 64; i++) {
-			ssaoShader.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+		for (size_t i = 0; i < ssao.kernel.size(); i++) {
+			ssaoShader.set(ssao.samples[i], ssao.kernel[i]);
 		}
 		// render quad
 		bindTextures(aoBufferTex);
-		glBindVertexArray(frameVAO);
+		glstate::BindVertexArray(frameVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		ssaoBuffer.unbind();
 
@@ -212,17 +254,14 @@ int ssao_main()
 		ssaoBlurBuffer.bind();
 		ssaoBlurShader.use();
 		ssaoBlurShader.setInt("ssaoInput", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, ssaoColor.id);
-		glBindVertexArray(frameVAO);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, ssaoColor.id);
+		glstate::BindVertexArray(frameVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		ssaoBlurBuffer.unbind(); 
 
 		// Lighting pass
 		lightingShader.use();
-		// input matrices
-		lightingShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.0f));
-		lightingShader.setMat4("view", camera.getViewMatrix());
 		// input passes
 		lightingShader.setInt("gPosition", 0);
 		lightingShader.setInt("gNormal", 1);
@@ -236,15 +275,26 @@ int ssao_main()
 		lightingShader.setFloat("light.Radius", 1.0f);
 
 		bindTextures(lightingPassTex);
-		glBindVertexArray(frameVAO);
+		glstate::BindVertexArray(frameVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		glEnable(GL_DEPTH_TEST);
+		glstate::Enable(GL_DEPTH_TEST);
 		gBuffer.bind();
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.FBO);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.FBO);
+		glstate::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		glBlitFramebuffer(0, 0, W_WIDTH, W_HEIGHT, 0, 0, W_WIDTH, W_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// uniform traffic, unchanged values are skipped after the first frame
+		frameCount++;
+		if (glfwGetTime() - statsTime > 5.0) {
+			Shader::printUniformStats(frameCount);
+			gBufferCullStats.print(frameCount);
+			frameCount = 0;
+			statsTime = glfwGetTime();
+		}
+
+		frameUniforms.endFrame();
 
 		// checks events and swap buffers
 		glfwPollEvents();
@@ -0,0 +1,184 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../modules/model.h"
+#include "../modules/utils.h"
+#include "../modules/shader.h"
+#include "../modules/camera.h"
+#include "../modules/instance_buffer.h"
+#include "../modules/transform_store.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
+
+constexpr int W_WIDTH = 1600;
+constexpr int W_HEIGHT = 1200;
+
+// a ring of rocks around planet.obj. every 5 seconds the rocks switch between one instanced draw and
+// a draw per rock, and the frame and cpu submission times of the last window are printed.
+int asteroid_main()
+{
+	// initialization phase
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	GLFWwindow* window = glfwCreateWindow(W_WIDTH, W_HEIGHT, "Asteroid Field", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+	// no vsync, the frame time is what is being measured
+	glfwSwapInterval(0);
+
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glstate::Enable(GL_DEPTH_TEST);
+	glstate::Enable(GL_CULL_FACE);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	Camera camera(
+		glm::vec3(0.0f, 20.0f, 220.0f),
+		glm::vec3(0.0f, -0.1f, -1.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f),
+		45.0f
+	);
+	glfwSetWindowUserPointer(window, &camera);
+
+	Model planet("resources/objects/planet/planet.obj");
+	// the planet spins through its mesh's node, the rest of the node tree is left alone
+	uint32_t planetNode = planet.getMeshNode(0);
+	glm::mat4 planetRest = planet.getNodes().getLocal(planetNode);
+	// rock.mtl only has a bump map, it still lands on unit 0 where texture_diffuse1 samples
+	Model rock("resources/objects/rock/rock.obj");
+
+	Shader shader("shaders/base_vertex.vert", "shaders/instanced_lit.frag");
+	Shader instancedShader("shaders/base_vertex.vert", "shaders/instanced_lit.frag", ShaderDefines().define("INSTANCED"));
+
+	// rocks scattered in a ring, each with its own size, tilt and tint
+	const unsigned int NR_ROCKS = 100000;
+	const float ringRadius = 150.0f, ringWidth = 25.0f;
+	TransformStore rocks;
+	rocks.reserve(NR_ROCKS);
+	std::vector<glm::vec3> rockAxes(NR_ROCKS);
+	std::vector<float> rockSpins(NR_ROCKS);
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	InstanceBuffer instances(true);
+	instances.resize(NR_ROCKS);
+	for (unsigned int i = 0; i < NR_ROCKS; i++) {
+		float angle = (float)i / (float)NR_ROCKS * 360.0f;
+		float radius = ringRadius + unit(rng) * ringWidth;
+		glm::vec3 position(sin(glm::radians(angle)) * radius, unit(rng) * ringWidth * 0.2f, cos(glm::radians(angle)) * radius);
+		rockAxes[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 2.0f));
+		rockSpins[i] = unit(rng) * 180.0f;
+		rocks.add(position, rockSpins[i], rockAxes[i], glm::vec3(0.1f + (unit(rng) + 1.0f) * 0.1f));
+
+		float shade = 0.8f + unit(rng) * 0.2f;
+		instances.setParams(i, glm::vec4(shade, shade * 0.95f, shade * 0.9f, 1.0f));
+	}
+	rocks.update();
+	instances.setTransforms(0, rocks.getMatrices(), NR_ROCKS);
+
+	// a window of rocks tumbles every frame, only its matrices are rebuilt and its range of the instance buffer re-sent
+	const unsigned int TUMBLING_ROCKS = 1024;
+	unsigned int tumbleStart = 0;
+
+	bool drawInstanced = true;
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
+	double submitMs = 0.0;
+
+	FrameUniforms frameUniforms;
+	// render loop
+	while (!glfwWindowShouldClose(window))
+	{
+		// input
+		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
+
+		float time = (float)glfwGetTime();
+		for (unsigned int i = 0; i < TUMBLING_ROCKS; i++) {
+			unsigned int index = (tumbleStart + i) % NR_ROCKS;
+			rocks.setRotation(index, rockSpins[index] + time * 45.0f, rockAxes[index]);
+		}
+		rocks.update();
+		unsigned int wrapped = std::min(TUMBLING_ROCKS, NR_ROCKS - tumbleStart);
+		instances.setTransforms(tumbleStart, rocks.getMatrices() + tumbleStart, wrapped);
+		if (wrapped < TUMBLING_ROCKS)
+			instances.setTransforms(0, rocks.getMatrices(), TUMBLING_ROCKS - wrapped);
+		tumbleStart = (tumbleStart + TUMBLING_ROCKS) % NR_ROCKS;
+
+		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glm::vec3 lightDir(-1.0f, -0.3f, -0.5f);
+
+		auto submitStart = std::chrono::high_resolution_clock::now();
+
+		shader.use();
+		shader.setVec3("lightDir", lightDir);
+		glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -3.0f, 0.0f)), glm::vec3(8.0f));
+		planet.setNodeTransform(planetNode, glm::rotate(glm::mat4(1.0f), time * 0.1f, glm::vec3(0.0f, 1.0f, 0.0f)) * planetRest);
+		planet.Draw(shader, model);
+
+		if (drawInstanced) {
+			instancedShader.use();
+			instancedShader.setVec3("lightDir", lightDir);
+			rock.DrawInstanced(instancedShader, instances);
+		}
+		else {
+			// the same rocks with a uniform update and a draw each, tints aside
+			for (unsigned int i = 0; i < NR_ROCKS; i++) {
+				rock.Draw(shader, rocks.getMatrix(i));
+			}
+		}
+
+		auto submitEnd = std::chrono::high_resolution_clock::now();
+		submitMs += std::chrono::duration<double, std::milli>(submitEnd - submitStart).count();
+
+		frameUniforms.endFrame();
+
+		// checks events and swap buffers
+		glfwPollEvents();
+		glfwSwapBuffers(window);
+
+		frameCount++;
+		double now = glfwGetTime();
+		if (now - statsTime > 5.0) {
+			std::cout << (drawInstanced ? "instanced" : "per rock") << " " << NR_ROCKS << " rocks: "
+				<< (now - statsTime) * 1000.0 / frameCount << " ms per frame, "
+				<< submitMs / frameCount << " ms cpu submission" << std::endl;
+			Mesh::printDrawStats(frameCount);
+			InstanceBuffer::printUploadStats(frameCount);
+			planet.printNodeStats(frameCount);
+			drawInstanced = !drawInstanced;
+			frameCount = 0;
+			submitMs = 0.0;
+			statsTime = glfwGetTime();
+		}
+	}
+
+	glfwTerminate();
+
+	return 0;
+}
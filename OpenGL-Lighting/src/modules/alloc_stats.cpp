@@ -0,0 +1,80 @@
+#include "alloc_stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<unsigned long long> allocations(0);
+
+	void* allocate(std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size > 0 ? size : 1);
+	}
+}
+
+namespace allocstats {
+	unsigned long long count()
+	{
+		return allocations.load(std::memory_order_relaxed);
+	}
+
+	void reset()
+	{
+		allocations.store(0, std::memory_order_relaxed);
+	}
+}
+
+// the replaced forms, every other new and delete in the standard library forwards to these
+void* operator new(std::size_t size)
+{
+	void* memory = allocate(size);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// counts heap allocations made through the global operator new, which alloc_stats.cpp replaces.
+// every thread is counted, a frame with none allocated nothing anywhere in the process.
+namespace allocstats {
+	// allocations since the last reset
+	unsigned long long count();
+	void reset();
+}
@@ -0,0 +1,265 @@
+#include "baked_texture.h"
+#include "block_compressor.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+
+namespace {
+	const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	const uint32_t KTX_ENDIANNESS = 0x04030201;
+	const char* SOURCE_KEY = "OGL.source";
+
+	uint32_t alignTo4(uint32_t value)
+	{
+		return (value + 3u) & ~3u;
+	}
+
+	void writePadding(std::ofstream& out, uint32_t written)
+	{
+		static const char zeros[4] = {};
+		out.write(zeros, alignTo4(written) - written);
+	}
+}
+
+bool KTXFile::open(const std::string& path)
+{
+	close();
+	if (!file.open(path)) return false;
+
+	const unsigned char* base = file.data();
+	size_t size = file.size();
+	if (size < sizeof(KTXHeader)) {
+		close();
+		return false;
+	}
+
+	header = reinterpret_cast<const KTXHeader*>(base);
+	if (std::memcmp(header->identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 ||
+		header->endianness != KTX_ENDIANNESS ||
+		header->pixelDepth != 0 || header->numberOfArrayElements != 0 || header->numberOfFaces != 1 ||
+		header->numberOfMipmapLevels == 0 ||
+		sizeof(KTXHeader) + static_cast<size_t>(header->bytesOfKeyValueData) > size) {
+		close();
+		return false;
+	}
+
+	size_t offset = sizeof(KTXHeader) + header->bytesOfKeyValueData;
+	levels.reserve(header->numberOfMipmapLevels);
+	for (uint32_t i = 0; i < header->numberOfMipmapLevels; i++) {
+		if (offset + sizeof(uint32_t) > size) {
+			close();
+			return false;
+		}
+
+		uint32_t imageSize;
+		std::memcpy(&imageSize, base + offset, sizeof(imageSize));
+		offset += sizeof(uint32_t);
+		if (offset + imageSize > size) {
+			close();
+			return false;
+		}
+
+		levels.push_back({ base + offset, imageSize });
+		offset += alignTo4(imageSize);
+	}
+	return true;
+}
+
+void KTXFile::close()
+{
+	file.close();
+	header = nullptr;
+	levels.clear();
+}
+
+std::string KTXFile::getValue(const std::string& key) const
+{
+	const unsigned char* data = file.data() + sizeof(KTXHeader);
+	uint32_t remaining = header->bytesOfKeyValueData;
+
+	while (remaining >= sizeof(uint32_t)) {
+		uint32_t pairSize;
+		std::memcpy(&pairSize, data, sizeof(pairSize));
+		if (pairSize > remaining - sizeof(uint32_t)) break;
+
+		// key and value are both nul terminated utf-8 here
+		const char* pair = reinterpret_cast<const char*>(data + sizeof(uint32_t));
+		size_t keyLength = strnlen(pair, pairSize);
+		if (keyLength < pairSize && key.compare(0, std::string::npos, pair, keyLength) == 0) {
+			const char* value = pair + keyLength + 1;
+			return std::string(value, strnlen(value, pairSize - keyLength - 1));
+		}
+
+		uint32_t step = sizeof(uint32_t) + alignTo4(pairSize);
+		if (step > remaining) break;
+		data += step;
+		remaining -= step;
+	}
+	return std::string();
+}
+
+std::string bakedTexturePath(const std::string& sourcePath, TextureColorSpace space, bool flipVertically)
+{
+	std::string path = sourcePath;
+	if (space == TextureColorSpace::sRGB) path += ".srgb";
+	if (flipVertically) path += ".flip";
+	return path + ".ktx";
+}
+
+std::string textureSourceStamp(const std::string& sourcePath)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(sourcePath.c_str(), &info) != 0) return std::string();
+#else
+	struct stat info;
+	if (stat(sourcePath.c_str(), &info) != 0) return std::string();
+#endif
+	return std::to_string(static_cast<long long>(info.st_size)) + ":" + std::to_string(static_cast<long long>(info.st_mtime));
+}
+
+namespace {
+	// levels are written as given, they already carry the row padding ktx expects
+	bool writeKTXFile(const std::string& path, KTXHeader header, const std::string& sourceStamp,
+		const std::vector<std::vector<unsigned char>>& levels)
+	{
+		std::string tempPath = path + ".tmp";
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::cout << "ERROR::KTX::Could not write " << path << std::endl;
+			return false;
+		}
+
+		uint32_t pairSize = static_cast<uint32_t>(std::strlen(SOURCE_KEY) + 1 + sourceStamp.size() + 1);
+
+		std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+		header.endianness = KTX_ENDIANNESS;
+		header.numberOfFaces = 1;
+		header.numberOfMipmapLevels = static_cast<uint32_t>(levels.size());
+		header.bytesOfKeyValueData = sizeof(uint32_t) + alignTo4(pairSize);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		out.write(reinterpret_cast<const char*>(&pairSize), sizeof(pairSize));
+		out.write(SOURCE_KEY, std::strlen(SOURCE_KEY) + 1);
+		out.write(sourceStamp.c_str(), sourceStamp.size() + 1);
+		writePadding(out, pairSize);
+
+		for (const std::vector<unsigned char>& level : levels) {
+			uint32_t imageSize = static_cast<uint32_t>(level.size());
+			out.write(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+			out.write(reinterpret_cast<const char*>(level.data()), level.size());
+			writePadding(out, imageSize);
+		}
+
+		out.close();
+		if (!out) {
+			std::remove(tempPath.c_str());
+			return false;
+		}
+
+		std::remove(path.c_str());
+		if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+			std::remove(tempPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
+
+bool writeKTX(const std::string& path, const MipChain& chain, const std::string& sourceStamp, TextureCompression compression)
+{
+	if (chain.levels.empty()) return false;
+
+	KTXHeader header = {};
+	header.pixelWidth = chain.width;
+	header.pixelHeight = chain.height;
+	header.glTypeSize = 1;
+	std::vector<std::vector<unsigned char>> levels(chain.levels.size());
+
+	if (compression != TextureCompression::None) {
+		// compressed ktx files leave glType and glFormat at 0
+		BlockFormat format = chooseBlockFormat(compression, chain.channels);
+		header.glInternalFormat = blockFormatInternalFormat(format, chain.space);
+		header.glBaseInternalFormat = blockFormatBaseFormat(format);
+		for (size_t level = 0; level < chain.levels.size(); level++)
+			levels[level] = compressImage(chain.levels[level].data(), chain.levelWidth(level), chain.levelHeight(level), chain.channels, format);
+		return writeKTXFile(path, header, sourceStamp, levels);
+	}
+
+	bool sRGB = chain.space == TextureColorSpace::sRGB;
+	switch (chain.channels) {
+	case 1: header.glFormat = GL_RED; header.glInternalFormat = GL_R8; break;
+	case 2: header.glFormat = GL_RG; header.glInternalFormat = GL_RG8; break;
+	case 3: header.glFormat = GL_RGB; header.glInternalFormat = sRGB ? GL_SRGB8 : GL_RGB8; break;
+	default: header.glFormat = GL_RGBA; header.glInternalFormat = sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8; break;
+	}
+	header.glType = GL_UNSIGNED_BYTE;
+	header.glBaseInternalFormat = header.glFormat;
+
+	// ktx rows are 4 byte aligned, which is also the default GL_UNPACK_ALIGNMENT
+	for (size_t level = 0; level < chain.levels.size(); level++) {
+		size_t rowSize = static_cast<size_t>(chain.levelWidth(level)) * chain.channels;
+		size_t paddedRowSize = alignTo4(static_cast<uint32_t>(rowSize));
+		size_t height = chain.levelHeight(level);
+		levels[level].assign(paddedRowSize * height, 0);
+		for (size_t y = 0; y < height; y++)
+			std::memcpy(&levels[level][y * paddedRowSize], &chain.levels[level][y * rowSize], rowSize);
+	}
+	return writeKTXFile(path, header, sourceStamp, levels);
+}
+
+bool cookTexture(const std::string& sourcePath, TextureColorSpace space, bool flipVertically, TextureCompression compression)
+{
+	DecodedImage image = decodeImage(sourcePath, flipVertically);
+	if (!image.valid()) {
+		std::cout << "ERROR::KTX::Could not load " << sourcePath << std::endl;
+		return false;
+	}
+
+	MipChain chain = bakeMipChain(image, space);
+	return writeKTX(bakedTexturePath(sourcePath, space, flipVertically), chain, textureSourceStamp(sourcePath), compression);
+}
+
+unsigned int loadBakedTexture(const std::string& sourcePath, TextureColorSpace space, bool flipVertically, size_t* bytes)
+{
+	std::string stamp = textureSourceStamp(sourcePath);
+	if (stamp.empty()) return 0;
+
+	KTXFile ktx;
+	if (!ktx.open(bakedTexturePath(sourcePath, space, flipVertically)))
+		return 0;
+	if (ktx.getValue(SOURCE_KEY) != stamp)
+		return 0;
+
+	// block compressed files are skipped when the driver can't sample them, the caller decodes the source instead
+	const KTXHeader& header = ktx.getHeader();
+	bool compressed = header.glType == 0;
+	if (compressed ? !isCompressedFormatSupported(header.glInternalFormat) : header.glType != GL_UNSIGNED_BYTE)
+		return 0;
+
+	// levels go up straight from the mapping
+	std::vector<const GLvoid*> levels(ktx.getLevelCount());
+	std::vector<GLsizei> levelSizes(ktx.getLevelCount());
+	size_t total = 0;
+	for (uint32_t i = 0; i < ktx.getLevelCount(); i++) {
+		levels[i] = ktx.getLevelData(i);
+		levelSizes[i] = static_cast<GLsizei>(ktx.getLevelSize(i));
+		total += ktx.getLevelSize(i);
+	}
+
+	int levelCount = static_cast<int>(levels.size());
+	unsigned int textureID;
+	if (compressed) {
+		Texture texture(header.pixelWidth, header.pixelHeight, header.glInternalFormat, GL_REPEAT, levelCount, levels.data(), levelSizes.data());
+		textureID = texture.id;
+	}
+	else {
+		Texture texture(header.pixelWidth, header.pixelHeight, header.glInternalFormat, header.glFormat, GL_REPEAT, levelCount, levels.data());
+		textureID = texture.id;
+	}
+
+	if (bytes) *bytes = total;
+	return textureID;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "utils.h"
+#include "mapped_file.h"
+#include "mip_baker.h"
+#include "block_compressor.h"
+
+// pre-mipped textures cooked offline into KTX 1.1 files next to their source image. the file name
+// carries the color space and flip flag, a "OGL.source" key/value entry holds the size and mtime of
+// the source so an edited image is never shadowed by a stale bake.
+
+struct KTXHeader {
+	unsigned char identifier[12];
+	uint32_t endianness;
+	uint32_t glType;
+	uint32_t glTypeSize;
+	uint32_t glFormat;
+	uint32_t glInternalFormat;
+	uint32_t glBaseInternalFormat;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t numberOfArrayElements;
+	uint32_t numberOfFaces;
+	uint32_t numberOfMipmapLevels;
+	uint32_t bytesOfKeyValueData;
+};
+
+// read-only view of a mapped .ktx file. plain 2D textures only, no arrays, cubemaps or depth.
+class KTXFile {
+public:
+	bool open(const std::string& path);
+	void close();
+
+	const KTXHeader& getHeader() const { return *header; }
+	// value of a key/value entry, empty if missing
+	std::string getValue(const std::string& key) const;
+	uint32_t getLevelCount() const { return header->numberOfMipmapLevels; }
+	const unsigned char* getLevelData(uint32_t level) const { return levels[level].data; }
+	uint32_t getLevelSize(uint32_t level) const { return levels[level].size; }
+
+private:
+	struct Level {
+		const unsigned char* data;
+		uint32_t size;
+	};
+
+	MappedFile file;
+	const KTXHeader* header = nullptr;
+	std::vector<Level> levels;
+};
+
+std::string bakedTexturePath(const std::string& sourcePath, TextureColorSpace space, bool flipVertically);
+// "<size>:<mtime>" of the source image, empty if it doesn't exist
+std::string textureSourceStamp(const std::string& sourcePath);
+
+// writes every level either as plain 8-bit rows or block compressed in the format chosen for compression
+bool writeKTX(const std::string& path, const MipChain& chain, const std::string& sourceStamp,
+	TextureCompression compression = TextureCompression::None);
+
+// decodes, bakes and writes the .ktx for one source image. returns false if the image can't be loaded.
+bool cookTexture(const std::string& sourcePath, TextureColorSpace space, bool flipVertically,
+	TextureCompression compression = TextureCompression::None);
+
+// uploads the cooked mip chain of sourcePath if an up to date one exists (and, for block compressed
+// files, the driver supports the format), 0 otherwise.
+// bytes receives the estimated vram of the texture.
+unsigned int loadBakedTexture(const std::string& sourcePath, TextureColorSpace space, bool flipVertically, size_t* bytes = nullptr);
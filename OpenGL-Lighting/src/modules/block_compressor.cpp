@@ -0,0 +1,690 @@
+#include "block_compressor.h"
+#include "gl_extensions.h"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSOR_SSE2
+#endif
+
+namespace {
+	// bc7 4-bit index interpolation weights, out of 64
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// 4x4 block as rgba8, 16 pixels in row order
+	struct Block {
+		unsigned char rgba[64];
+	};
+
+	void expandPixel(const unsigned char* in, int channels, unsigned char* out)
+	{
+		switch (channels) {
+		case 1: out[0] = out[1] = out[2] = in[0]; out[3] = 255; break;
+		case 2: out[0] = out[1] = out[2] = in[0]; out[3] = in[1]; break;
+		case 3: out[0] = in[0]; out[1] = in[1]; out[2] = in[2]; out[3] = 255; break;
+		default: std::memcpy(out, in, 4); break;
+		}
+	}
+
+	void gatherBlock(const unsigned char* pixels, int width, int height, int channels, int bx, int by, Block& block)
+	{
+		for (int y = 0; y < 4; y++) {
+			int sy = std::min(by * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++) {
+				int sx = std::min(bx * 4 + x, width - 1);
+				expandPixel(pixels + (static_cast<size_t>(sy) * width + sx) * channels, channels, &block.rgba[(y * 4 + x) * 4]);
+			}
+		}
+	}
+
+	void blockMinMax(const Block& block, unsigned char minimum[4], unsigned char maximum[4])
+	{
+#ifdef BLOCK_COMPRESSOR_SSE2
+		const __m128i* rows = reinterpret_cast<const __m128i*>(block.rgba);
+		__m128i lo = _mm_min_epu8(_mm_min_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+			_mm_min_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+		__m128i hi = _mm_max_epu8(_mm_max_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+			_mm_max_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+		// fold the four pixels left in each register down to one
+		lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+		lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+		hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+		hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+		int packedMin = _mm_cvtsi128_si32(lo);
+		int packedMax = _mm_cvtsi128_si32(hi);
+		std::memcpy(minimum, &packedMin, 4);
+		std::memcpy(maximum, &packedMax, 4);
+#else
+		for (int c = 0; c < 4; c++) {
+			minimum[c] = 255;
+			maximum[c] = 0;
+		}
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) {
+				minimum[c] = std::min(minimum[c], block.rgba[i * 4 + c]);
+				maximum[c] = std::max(maximum[c], block.rgba[i * 4 + c]);
+			}
+		}
+#endif
+	}
+
+	// principal axis of the block's colors over the first `channels` channels, by power iteration
+	void principalAxis(const Block& block, int channels, float mean[4], float axis[4])
+	{
+		for (int c = 0; c < 4; c++) mean[c] = 0.0f;
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < channels; c++)
+				mean[c] += block.rgba[i * 4 + c];
+		for (int c = 0; c < channels; c++) mean[c] /= 16.0f;
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++) {
+			float d[4];
+			for (int c = 0; c < channels; c++) d[c] = block.rgba[i * 4 + c] - mean[c];
+			for (int a = 0; a < channels; a++)
+				for (int b = 0; b < channels; b++)
+					covariance[a][b] += d[a] * d[b];
+		}
+
+		int widest = 0;
+		for (int c = 1; c < channels; c++)
+			if (covariance[c][c] > covariance[widest][widest]) widest = c;
+		for (int c = 0; c < 4; c++) axis[c] = c < channels ? 1.0f : 0.0f;
+		if (covariance[widest][widest] < 1e-6f) return; // flat block, every pixel is the mean
+
+		// seeded from the bounding box diagonal. a spread orthogonal to it (a chroma ramp at constant
+		// luminance) maps the seed to zero, the iteration then restarts from the widest channel
+		unsigned char minimum[4], maximum[4];
+		blockMinMax(block, minimum, maximum);
+		float seedLength = 0.0f;
+		for (int c = 0; c < channels; c++) seedLength = std::max(seedLength, static_cast<float>(maximum[c] - minimum[c]));
+		for (int c = 0; c < channels; c++) axis[c] = (maximum[c] - minimum[c]) / seedLength;
+
+		bool reseeded = false;
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {};
+			for (int a = 0; a < channels; a++)
+				for (int b = 0; b < channels; b++)
+					next[a] += covariance[a][b] * axis[b];
+
+			float length = 0.0f;
+			for (int c = 0; c < channels; c++) length = std::max(length, std::fabs(next[c]));
+			if (length < 1e-4f * covariance[widest][widest]) {
+				if (reseeded) break;
+				reseeded = true;
+				for (int c = 0; c < channels; c++) axis[c] = c == widest ? 1.0f : 0.0f;
+				continue;
+			}
+			for (int c = 0; c < channels; c++) axis[c] = next[c] / length;
+		}
+	}
+
+	// least squares endpoints for fixed per-pixel weights (weight of e1, e0 gets 1 - w)
+	bool refineEndpoints(const Block& block, int channels, const float weights[16], float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; i++) {
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < channels; c++) {
+				ax[c] += a * block.rgba[i * 4 + c];
+				bx[c] += b * block.rgba[i * 4 + c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f) return false;
+
+		for (int c = 0; c < channels; c++) {
+			e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / determinant));
+			e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / determinant));
+		}
+		return true;
+	}
+
+	// ---- BC1 ----
+
+	uint16_t packRGB565(const float color[4])
+	{
+		int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31));
+	}
+
+	void unpackRGB565(uint16_t packed, int color[3])
+	{
+		int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	void bc1Palette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][3])
+	{
+		unpackRGB565(c0, palette[0]);
+		unpackRGB565(c1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			if (fourColor) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	// picks the nearest palette entry per pixel, returns the total squared error
+	int bc1SelectIndices(const Block& block, const int palette[4][3], unsigned char indices[16])
+	{
+		int total = 0;
+		for (int i = 0; i < 16; i++) {
+			const unsigned char* p = &block.rgba[i * 4];
+			int best = std::numeric_limits<int>::max();
+			for (int e = 0; e < 4; e++) {
+				int dr = p[0] - palette[e][0], dg = p[1] - palette[e][1], db = p[2] - palette[e][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < best) {
+					best = error;
+					indices[i] = static_cast<unsigned char>(e);
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	int bc1Try(const Block& block, const float e0[4], const float e1[4], uint16_t& c0, uint16_t& c1, unsigned char indices[16])
+	{
+		c0 = packRGB565(e0);
+		c1 = packRGB565(e1);
+		// c0 > c1 selects four color mode
+		if (c0 < c1) std::swap(c0, c1);
+
+		int palette[4][3];
+		bc1Palette(c0, c1, true, palette);
+		return bc1SelectIndices(block, palette, indices);
+	}
+
+	void encodeBC1(const Block& block, unsigned char* out)
+	{
+		unsigned char minimum[4], maximum[4];
+		blockMinMax(block, minimum, maximum);
+
+		uint16_t c0, c1;
+		unsigned char indices[16] = {};
+		if (minimum[0] == maximum[0] && minimum[1] == maximum[1] && minimum[2] == maximum[2]) {
+			float color[4] = { static_cast<float>(minimum[0]), static_cast<float>(minimum[1]), static_cast<float>(minimum[2]), 0.0f };
+			c0 = c1 = packRGB565(color);
+		}
+		else {
+			// endpoints are the extremes along the principal axis, then one least squares pass
+			float mean[4], axis[4];
+			principalAxis(block, 3, mean, axis);
+			float lo = std::numeric_limits<float>::max(), hi = -lo;
+			for (int i = 0; i < 16; i++) {
+				const unsigned char* p = &block.rgba[i * 4];
+				float t = (p[0] - mean[0]) * axis[0] + (p[1] - mean[1]) * axis[1] + (p[2] - mean[2]) * axis[2];
+				lo = std::min(lo, t);
+				hi = std::max(hi, t);
+			}
+			float e0[4], e1[4];
+			for (int c = 0; c < 3; c++) {
+				e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * hi));
+				e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * lo));
+			}
+
+			int error = bc1Try(block, e0, e1, c0, c1, indices);
+
+			const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+			float weights[16];
+			for (int i = 0; i < 16; i++) weights[i] = indexWeights[indices[i]];
+			float r0[4], r1[4];
+			if (refineEndpoints(block, 3, weights, r0, r1)) {
+				uint16_t rc0, rc1;
+				unsigned char refined[16];
+				int refinedError = bc1Try(block, r0, r1, rc0, rc1, refined);
+				if (refinedError < error) {
+					c0 = rc0;
+					c1 = rc1;
+					std::memcpy(indices, refined, sizeof(refined));
+				}
+			}
+
+			if (c0 == c1) std::memset(indices, 0, sizeof(indices));
+		}
+
+		uint32_t packedIndices = 0;
+		for (int i = 0; i < 16; i++)
+			packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+		out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+		out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+		std::memcpy(out + 4, &packedIndices, 4);
+	}
+
+	void decodeBC1(const unsigned char* in, unsigned char* rgba)
+	{
+		uint16_t c0 = in[0] | (in[1] << 8);
+		uint16_t c1 = in[2] | (in[3] << 8);
+		uint32_t indices;
+		std::memcpy(&indices, in + 4, 4);
+
+		bool fourColor = c0 > c1;
+		int palette[4][3];
+		bc1Palette(c0, c1, fourColor, palette);
+		for (int i = 0; i < 16; i++) {
+			int e = (indices >> (i * 2)) & 3;
+			rgba[i * 4 + 0] = static_cast<unsigned char>(palette[e][0]);
+			rgba[i * 4 + 1] = static_cast<unsigned char>(palette[e][1]);
+			rgba[i * 4 + 2] = static_cast<unsigned char>(palette[e][2]);
+			rgba[i * 4 + 3] = (!fourColor && e == 3) ? 0 : 255;
+		}
+	}
+
+	// ---- BC4 ----
+
+	void encodeBC4(const Block& block, int channel, unsigned char* out)
+	{
+		unsigned char minimum[4], maximum[4];
+		blockMinMax(block, minimum, maximum);
+		unsigned char lo = minimum[channel], hi = maximum[channel];
+
+		// eight value mode: index 0 = hi, 1 = lo, 2..7 step from hi towards lo
+		out[0] = hi;
+		out[1] = lo;
+
+		unsigned char steps[16] = {};
+		if (hi != lo) {
+			float scale = 7.0f / (hi - lo);
+#ifdef BLOCK_COMPRESSOR_SSE2
+			float values[16];
+			for (int i = 0; i < 16; i++) values[i] = block.rgba[i * 4 + channel];
+			__m128 top = _mm_set1_ps(static_cast<float>(hi));
+			__m128 factor = _mm_set1_ps(scale);
+			for (int i = 0; i < 16; i += 4) {
+				__m128i k = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(top, _mm_loadu_ps(values + i)), factor));
+				int ks[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(ks), k);
+				for (int j = 0; j < 4; j++) steps[i + j] = static_cast<unsigned char>(ks[j]);
+			}
+#else
+			for (int i = 0; i < 16; i++)
+				steps[i] = static_cast<unsigned char>((hi - block.rgba[i * 4 + channel]) * scale + 0.5f);
+#endif
+		}
+
+		uint64_t packedIndices = 0;
+		for (int i = 0; i < 16; i++) {
+			unsigned char step = steps[i];
+			uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+			packedIndices |= index << (i * 3);
+		}
+		for (int b = 0; b < 6; b++)
+			out[2 + b] = static_cast<unsigned char>(packedIndices >> (b * 8));
+	}
+
+	void decodeBC4(const unsigned char* in, unsigned char* rgba, int channel)
+	{
+		int palette[8];
+		palette[0] = in[0];
+		palette[1] = in[1];
+		if (palette[0] > palette[1]) {
+			for (int k = 1; k < 7; k++)
+				palette[k + 1] = ((7 - k) * palette[0] + k * palette[1] + 3) / 7;
+		}
+		else {
+			for (int k = 1; k < 5; k++)
+				palette[k + 1] = ((5 - k) * palette[0] + k * palette[1] + 2) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (int b = 0; b < 6; b++)
+			indices |= static_cast<uint64_t>(in[2 + b]) << (b * 8);
+		for (int i = 0; i < 16; i++)
+			rgba[i * 4 + channel] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+	}
+
+	// ---- BC7 (mode 6) ----
+
+	struct BitWriter {
+		unsigned char* out;
+		int position = 0;
+
+		void write(uint32_t value, int bits) {
+			for (int i = 0; i < bits; i++, position++) {
+				if (value & (1u << i))
+					out[position >> 3] |= static_cast<unsigned char>(1u << (position & 7));
+			}
+		}
+	};
+
+	struct BitReader {
+		const unsigned char* in;
+		int position = 0;
+
+		uint32_t read(int bits) {
+			uint32_t value = 0;
+			for (int i = 0; i < bits; i++, position++)
+				value |= static_cast<uint32_t>((in[position >> 3] >> (position & 7)) & 1) << i;
+			return value;
+		}
+	};
+
+	// 7 bits per channel plus one p-bit shared by the endpoint's channels, whichever p-bit fits better
+	void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pBit)
+	{
+		float bestError = std::numeric_limits<float>::max();
+		for (int p = 0; p < 2; p++) {
+			int q[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				q[c] = std::min(127, std::max(0, static_cast<int>((endpoint[c] - p) / 2.0f + 0.5f)));
+				float d = (q[c] * 2 + p) - endpoint[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				pBit = p;
+				std::memcpy(quantized, q, sizeof(q));
+			}
+		}
+	}
+
+	int bc7Try(const Block& block, const float e0[4], const float e1[4], int q0[4], int q1[4], int& p0, int& p1, unsigned char indices[16])
+	{
+		quantizeBC7Endpoint(e0, q0, p0);
+		quantizeBC7Endpoint(e1, q1, p1);
+
+		int palette[16][4];
+		for (int w = 0; w < 16; w++) {
+			for (int c = 0; c < 4; c++) {
+				int a = q0[c] * 2 + p0, b = q1[c] * 2 + p1;
+				palette[w][c] = ((64 - BC7_WEIGHTS[w]) * a + BC7_WEIGHTS[w] * b + 32) >> 6;
+			}
+		}
+
+		int total = 0;
+		for (int i = 0; i < 16; i++) {
+			const unsigned char* p = &block.rgba[i * 4];
+			int best = std::numeric_limits<int>::max();
+			for (int w = 0; w < 16; w++) {
+				int error = 0;
+				for (int c = 0; c < 4; c++) {
+					int d = p[c] - palette[w][c];
+					error += d * d;
+				}
+				if (error < best) {
+					best = error;
+					indices[i] = static_cast<unsigned char>(w);
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	void encodeBC7(const Block& block, unsigned char* out)
+	{
+		float mean[4], axis[4];
+		principalAxis(block, 4, mean, axis);
+		float lo = std::numeric_limits<float>::max(), hi = -lo;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < 4; c++) t += (block.rgba[i * 4 + c] - mean[c]) * axis[c];
+			lo = std::min(lo, t);
+			hi = std::max(hi, t);
+		}
+		float e0[4], e1[4];
+		for (int c = 0; c < 4; c++) {
+			e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * lo));
+			e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * hi));
+		}
+
+		int q0[4], q1[4], p0, p1;
+		unsigned char indices[16];
+		int error = bc7Try(block, e0, e1, q0, q1, p0, p1, indices);
+
+		float weights[16];
+		for (int i = 0; i < 16; i++) weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+		float r0[4], r1[4];
+		if (refineEndpoints(block, 4, weights, r0, r1)) {
+			int rq0[4], rq1[4], rp0, rp1;
+			unsigned char refined[16];
+			if (bc7Try(block, r0, r1, rq0, rq1, rp0, rp1, refined) < error) {
+				std::memcpy(q0, rq0, sizeof(q0));
+				std::memcpy(q1, rq1, sizeof(q1));
+				p0 = rp0;
+				p1 = rp1;
+				std::memcpy(indices, refined, sizeof(refined));
+			}
+		}
+
+		// the anchor (first) index only has 3 bits stored, flip the endpoints if its top bit is set
+		if (indices[0] & 8) {
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (int i = 0; i < 16; i++) indices[i] = static_cast<unsigned char>(15 - indices[i]);
+		}
+
+		std::memset(out, 0, 16);
+		BitWriter writer = { out };
+		writer.write(1u << 6, 7); // mode 6
+		for (int c = 0; c < 4; c++) {
+			writer.write(q0[c], 7);
+			writer.write(q1[c], 7);
+		}
+		writer.write(p0, 1);
+		writer.write(p1, 1);
+		writer.write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			writer.write(indices[i], 4);
+	}
+
+	void decodeBC7(const unsigned char* in, unsigned char* rgba)
+	{
+		BitReader reader = { in };
+		if (reader.read(7) != (1u << 6)) {
+			// not written by this encoder
+			for (int i = 0; i < 64; i++) rgba[i] = 0;
+			return;
+		}
+
+		int e[2][4];
+		for (int c = 0; c < 4; c++) {
+			e[0][c] = reader.read(7);
+			e[1][c] = reader.read(7);
+		}
+		int p0 = reader.read(1), p1 = reader.read(1);
+		for (int c = 0; c < 4; c++) {
+			e[0][c] = e[0][c] * 2 + p0;
+			e[1][c] = e[1][c] * 2 + p1;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			int w = BC7_WEIGHTS[reader.read(i == 0 ? 3 : 4)];
+			for (int c = 0; c < 4; c++)
+				rgba[i * 4 + c] = static_cast<unsigned char>(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+		}
+	}
+
+	void encodeBlock(const Block& block, BlockFormat format, unsigned char* out)
+	{
+		switch (format) {
+		case BlockFormat::BC1: encodeBC1(block, out); break;
+		case BlockFormat::BC4: encodeBC4(block, 0, out); break;
+		case BlockFormat::BC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+		case BlockFormat::BC7: encodeBC7(block, out); break;
+		}
+	}
+
+	void decodeBlock(const unsigned char* in, BlockFormat format, unsigned char* rgba)
+	{
+		for (int i = 0; i < 16; i++) {
+			rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 0;
+			rgba[i * 4 + 3] = 255;
+		}
+
+		switch (format) {
+		case BlockFormat::BC1: decodeBC1(in, rgba); break;
+		case BlockFormat::BC4: decodeBC4(in, rgba, 0); break;
+		case BlockFormat::BC5: decodeBC4(in, rgba, 0); decodeBC4(in + 8, rgba, 1); break;
+		case BlockFormat::BC7: decodeBC7(in, rgba); break;
+		}
+	}
+
+	int comparedChannels(BlockFormat format)
+	{
+		switch (format) {
+		case BlockFormat::BC1: return 3;
+		case BlockFormat::BC4: return 1;
+		case BlockFormat::BC5: return 2;
+		default: return 4;
+		}
+	}
+}
+
+BlockFormat chooseBlockFormat(TextureCompression compression, int channels)
+{
+	switch (compression) {
+	case TextureCompression::Normal: return BlockFormat::BC5;
+	case TextureCompression::Mask: return BlockFormat::BC4;
+	default: return channels == 4 || channels == 2 ? BlockFormat::BC7 : BlockFormat::BC1;
+	}
+}
+
+const char* blockFormatName(BlockFormat format)
+{
+	switch (format) {
+	case BlockFormat::BC1: return "BC1";
+	case BlockFormat::BC4: return "BC4";
+	case BlockFormat::BC5: return "BC5";
+	default: return "BC7";
+	}
+}
+
+size_t blockFormatBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+size_t compressedImageSize(BlockFormat format, int width, int height)
+{
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockFormatBytes(format);
+}
+
+GLenum blockFormatInternalFormat(BlockFormat format, TextureColorSpace space)
+{
+	bool sRGB = space == TextureColorSpace::sRGB;
+	switch (format) {
+	case BlockFormat::BC1: return sRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	default: return sRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+GLenum blockFormatBaseFormat(BlockFormat format)
+{
+	switch (format) {
+	case BlockFormat::BC1: return GL_RGB;
+	case BlockFormat::BC4: return GL_RED;
+	case BlockFormat::BC5: return GL_RG;
+	default: return GL_RGBA;
+	}
+}
+
+bool isCompressedFormatSupported(GLenum internalFormat)
+{
+	switch (internalFormat) {
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+		return true; // core since 3.0
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		return glext::hasS3TC();
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return glext::hasBPTC();
+	default:
+		return false;
+	}
+}
+
+std::vector<unsigned char> compressImage(const unsigned char* pixels, int width, int height, int channels,
+	BlockFormat format, ThreadPool* pool)
+{
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	size_t blockBytes = blockFormatBytes(format);
+	std::vector<unsigned char> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+	auto encodeRows = [&](size_t begin, size_t end) {
+		Block block;
+		for (size_t by = begin; by < end; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				gatherBlock(pixels, width, height, channels, bx, static_cast<int>(by), block);
+				encodeBlock(block, format, &blocks[(by * blocksX + bx) * blockBytes]);
+			}
+		}
+	};
+
+	if (pool)
+		pool->parallelFor(blocksY, encodeRows);
+	else
+		encodeRows(0, blocksY);
+	return blocks;
+}
+
+std::vector<unsigned char> decompressImage(const unsigned char* blocks, int width, int height, BlockFormat format)
+{
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	size_t blockBytes = blockFormatBytes(format);
+	std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+
+	unsigned char decoded[64];
+	for (int by = 0; by < blocksY; by++) {
+		for (int bx = 0; bx < blocksX; bx++) {
+			decodeBlock(blocks + (static_cast<size_t>(by) * blocksX + bx) * blockBytes, format, decoded);
+			for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+					std::memcpy(&rgba[((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4], &decoded[(y * 4 + x) * 4], 4);
+			}
+		}
+	}
+	return rgba;
+}
+
+double computePSNR(const unsigned char* reference, int channels, const unsigned char* decodedRGBA,
+	int width, int height, BlockFormat format)
+{
+	int compared = comparedChannels(format);
+	double squaredError = 0.0;
+	size_t pixelCount = static_cast<size_t>(width) * height;
+	for (size_t i = 0; i < pixelCount; i++) {
+		unsigned char expected[4];
+		expandPixel(reference + i * channels, channels, expected);
+		for (int c = 0; c < compared; c++) {
+			double d = static_cast<double>(expected[c]) - decodedRGBA[i * 4 + c];
+			squaredError += d * d;
+		}
+	}
+
+	double mse = squaredError / (static_cast<double>(pixelCount) * compared);
+	if (mse <= 0.0) return std::numeric_limits<double>::infinity();
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
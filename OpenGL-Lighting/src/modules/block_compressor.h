@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "utils.h"
+#include "thread_pool.h"
+
+// s3tc/rgtc/bptc enums aren't part of the 3.3 core glad header
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+enum class BlockFormat {
+	BC1, // rgb 5:6:5 endpoints, 4 bpp
+	BC4, // single channel, 4 bpp
+	BC5, // two BC4 channels, 8 bpp
+	BC7  // rgba, mode 6 only (7777 endpoints + p-bit, 4-bit indices), 8 bpp
+};
+
+// what a texture holds, decides the block format when cooking
+enum class TextureCompression {
+	None,
+	Color,  // albedo/diffuse/specular: BC1, or BC7 when the image has alpha
+	Normal, // tangent space normal map: BC5 with x/y only, shaders rebuild z
+	Mask    // roughness/metallic/ao read through .r: BC4
+};
+
+BlockFormat chooseBlockFormat(TextureCompression compression, int channels);
+const char* blockFormatName(BlockFormat format);
+size_t blockFormatBytes(BlockFormat format); // bytes per 4x4 block
+size_t compressedImageSize(BlockFormat format, int width, int height);
+GLenum blockFormatInternalFormat(BlockFormat format, TextureColorSpace space);
+GLenum blockFormatBaseFormat(BlockFormat format);
+// whether the current context can sample a compressed internal format
+bool isCompressedFormatSupported(GLenum internalFormat);
+
+// encodes a tightly packed 8-bit image. block rows are split across pool, or run on the calling
+// thread when pool is null. partial blocks at the right/bottom edge repeat the last row/column.
+std::vector<unsigned char> compressImage(const unsigned char* pixels, int width, int height, int channels,
+	BlockFormat format, ThreadPool* pool = &ThreadPool::shared());
+
+// decodes back to rgba8, only used to measure encoder quality
+std::vector<unsigned char> decompressImage(const unsigned char* blocks, int width, int height, BlockFormat format);
+
+// psnr in dB over the channels the format keeps (rgb(a) for color, rg for normals, r for masks)
+double computePSNR(const unsigned char* reference, int channels, const unsigned char* decodedRGBA,
+	int width, int height, BlockFormat format);
@@ -9,37 +9,120 @@ Camera::Camera(const glm::vec3& cameraPos, const glm::vec3& cameraFront, const g
 // Setter implementations
 void Camera::setCameraPos(const glm::vec3& pos)
 {
+    if (pos == cameraPos) return;
     cameraPos = pos;
+    viewDirty = true;
 }
 
 void Camera::setCameraFront(const glm::vec3& front)
 {
+    if (front == cameraFront) return;
     cameraFront = front;
+    viewDirty = true;
 }
 
 void Camera::setCameraUp(const glm::vec3& up)
 {
+    if (up == cameraUp) return;
     cameraUp = up;
+    viewDirty = true;
 }
 
 void Camera::setFOV(const float fov)
 {
+    if (fov == this->fov) return;
     this->fov = fov;
+    projectionDirty = true;
+}
+
+void Camera::setPerspective(float width, float height, float near, float far)
+{
+    if (width == this->width && height == this->height && near == nearPlane && far == farPlane) return;
+    this->width = width;
+    this->height = height;
+    nearPlane = near;
+    farPlane = far;
+    projectionDirty = true;
+}
+
+void Camera::updateMatrices()
+{
+    if (!viewDirty && !projectionDirty) return;
+    if (viewDirty) {
+        view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        invView = glm::inverse(view);
+    }
+    if (projectionDirty) {
+        projection = glm::perspective(glm::radians(fov), width / height, nearPlane, farPlane);
+        invProjection = glm::inverse(projection);
+    }
+    viewProjection = projection * view;
+    viewDirty = projectionDirty = false;
 }
 
 // Getter implementations
-glm::mat4 Camera::getProjectionMatrix(float width, float height, float near, float far)
+const glm::mat4& Camera::getProjectionMatrix(float width, float height, float near, float far)
+{
+    setPerspective(width, height, near, far);
+    return getProjectionMatrix();
+}
+
+const glm::mat4& Camera::getProjectionMatrix()
 {
-    return glm::perspective(glm::radians(fov), width / height, near, far);
+    updateMatrices();
+    return projection;
 }
 
-glm::mat4 Camera::getViewMatrix()
+const glm::mat4& Camera::getViewMatrix()
 {
-    glm::mat4 view = glm::mat4(1.0f);
-    view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    updateMatrices();
     return view;
 }
 
+const glm::mat4& Camera::getViewProjectionMatrix()
+{
+    updateMatrices();
+    return viewProjection;
+}
+
+const glm::mat4& Camera::getInverseViewMatrix()
+{
+    updateMatrices();
+    return invView;
+}
+
+const glm::mat4& Camera::getInverseProjectionMatrix()
+{
+    updateMatrices();
+    return invProjection;
+}
+
+Frustum Camera::getFrustum(float width, float height, float near, float far)
+{
+    setPerspective(width, height, near, far);
+    return Frustum(getViewProjectionMatrix());
+}
+
+float Camera::getWidth() const
+{
+    return width;
+}
+
+float Camera::getHeight() const
+{
+    return height;
+}
+
+float Camera::getNear() const
+{
+    return nearPlane;
+}
+
+float Camera::getFar() const
+{
+    return farPlane;
+}
+
 glm::vec3 Camera::getCameraPos() const
 {
     return cameraPos;
@@ -7,6 +7,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "frustum.h"
+
 class Camera{
 private:
     glm::vec3 cameraPos;
@@ -14,6 +16,23 @@ private:
     glm::vec3 cameraUp;
     float fov;
 
+    // perspective of the cached projection, set through setPerspective or getProjectionMatrix
+    float width = 1.0f;
+    float height = 1.0f;
+    float nearPlane = 0.1f;
+    float farPlane = 1000.0f;
+
+    // rebuilt on first use after a setter changed what they depend on
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::mat4 invView;
+    glm::mat4 invProjection;
+    bool viewDirty = true;
+    bool projectionDirty = true;
+
+    void updateMatrices();
+
 public:
     // Constructor with initialization list
     Camera(const glm::vec3& cameraPos, const glm::vec3& cameraFront, const glm::vec3& cameraUp, const float& fov);
@@ -23,11 +42,24 @@ public:
     void setCameraFront(const glm::vec3& front);
     void setCameraUp(const glm::vec3& up);
     void setFOV(const float fov);
+    // viewport size and clip planes of the projection
+    void setPerspective(float width, float height, float near, float far);
 
 
     // Getter methods
-    glm::mat4 getProjectionMatrix(float width, float height, float near, float far);
-    glm::mat4 getViewMatrix();
+    // the matrices are cached, lookAt and perspective only run again after the camera moved or the perspective changed
+    const glm::mat4& getProjectionMatrix(float width, float height, float near, float far);
+    const glm::mat4& getProjectionMatrix();
+    const glm::mat4& getViewMatrix();
+    const glm::mat4& getViewProjectionMatrix();
+    const glm::mat4& getInverseViewMatrix();
+    const glm::mat4& getInverseProjectionMatrix();
+    // world space planes of getProjectionMatrix * getViewMatrix
+    Frustum getFrustum(float width, float height, float near, float far);
+    float getWidth() const;
+    float getHeight() const;
+    float getNear() const;
+    float getFar() const;
     glm::vec3 getCameraPos() const;
     glm::vec3 getCameraFront() const;
     glm::vec3 getCameraUp() const;
@@ -0,0 +1,33 @@
+#include "frame_data.h"
+
+FrameUniforms::FrameUniforms()
+	: ownRing(new UniformRing(sizeof(FrameData))), ring(ownRing.get())
+{
+}
+
+FrameUniforms::FrameUniforms(UniformRing& ring)
+	: ring(&ring)
+{
+}
+
+void FrameUniforms::publish(Camera& camera, float width, float height, float near, float far)
+{
+	camera.setPerspective(width, height, near, far);
+	data.view = camera.getViewMatrix();
+	data.projection = camera.getProjectionMatrix();
+	data.viewProjection = camera.getViewProjectionMatrix();
+	data.invView = camera.getInverseViewMatrix();
+	data.invProjection = camera.getInverseProjectionMatrix();
+	data.cameraPos = glm::vec4(camera.getCameraPos(), 1.0f);
+	data.viewport = glm::vec4(width, height, near, far);
+
+	if (ownRing)
+		ownRing->beginFrame();
+	UniformRing::bind(FRAME_DATA_BINDING, ring->push(data));
+}
+
+void FrameUniforms::endFrame()
+{
+	if (ownRing)
+		ownRing->endFrame();
+}
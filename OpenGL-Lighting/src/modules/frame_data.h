@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <memory>
+
+#include "camera.h"
+#include "uniform_ring.h"
+
+// binding of the FrameData block, resolved for every program in Shader::build.
+// 0 is left to the demos' light blocks, MATERIAL_BLOCK_BINDING is 2.
+constexpr unsigned int FRAME_DATA_BINDING = 1;
+
+// std140 mirror of the FrameData block:
+// layout (std140) uniform FrameData {
+//     mat4 view; mat4 projection; mat4 viewProjection; mat4 invView; mat4 invProjection;
+//     vec4 cameraPos; vec4 viewport;
+// };
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 invView;
+	glm::mat4 invProjection;
+	glm::vec4 cameraPos;	// w = 1
+	glm::vec4 viewport;		// width, height, near, far
+};
+static_assert(sizeof(FrameData) == 352, "FrameData has to match the std140 block");
+
+// the camera matrices every pass reads, pushed once per frame through a UniformRing instead of set on each program
+class FrameUniforms {
+public:
+	// streams through a ring of its own
+	FrameUniforms();
+	// pushes into ring, which its owner sized for one FrameData more and begins and ends the frames of
+	explicit FrameUniforms(UniformRing& ring);
+
+	// fills the block from the camera's cached matrices and binds it at FRAME_DATA_BINDING, before the first pass.
+	// an owned ring moves on to its next region first.
+	void publish(Camera& camera, float width, float height, float near, float far);
+	// after the frame's last draw, fences an owned ring and does nothing with a shared one
+	void endFrame();
+	const FrameData& getData() const { return data; }
+
+private:
+	std::unique_ptr<UniformRing> ownRing;
+	UniformRing* ring;
+	FrameData data;
+};
@@ -7,12 +7,13 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "texture.h"
+#include "gl_state.h"
 
 class Framebuffer
 {
 private:
-	unsigned int texture;
-	unsigned int rbo;
+	unsigned int texture = 0;
+	unsigned int rbo = 0;
 	int width, height;
 	int samples = 4;
 
@@ -53,7 +54,7 @@ public:
 	}
 
 	void editRenderbufferStorage(int width, int height, GLenum internalFormat) {
-		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, FBO);
 		this->width = width;
 		this->height = height;
 		glBindRenderbuffer(GL_RENDERBUFFER, rbo);
@@ -73,10 +74,10 @@ public:
 	Framebuffer(int width, int height, int samples) : width(width), height(height), samples(samples)
 	{
 		glGenFramebuffers(1, &FBO);
-		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, FBO);
 
 		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
+		glstate::BindTexture(GL_TEXTURE_2D_MULTISAMPLE, texture);
 		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGB, width, height, GL_TRUE);
 		glTexParameteri(GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -89,20 +90,20 @@ public:
 		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 			std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete." << std::endl;
 
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+		glstate::BindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void bind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-		glViewport(0, 0, width, height);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glstate::Viewport(0, 0, width, height);
 	}
 
 	void unbind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	unsigned int getTexture() const 
@@ -117,8 +118,8 @@ public:
 
 	~Framebuffer()
 	{
-		glDeleteFramebuffers(1, &FBO);
-		glDeleteTextures(1, &texture);
+		glstate::DeleteFramebuffers(1, &FBO);
+		glstate::DeleteTextures(1, &texture);
 		glDeleteRenderbuffers(1, &rbo);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "frustum.h"
+
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#endif
+
+static void normalizePlanes(glm::vec4* planes)
+{
+	for (int p = 0; p < 6; p++)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+}
+
+Frustum::Frustum(const glm::mat4& matrix)
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+	for (int i = 0; i < 3; i++) {
+		planes[i * 2] = rows[3] + rows[i];
+		planes[i * 2 + 1] = rows[3] - rows[i];
+	}
+	normalizePlanes(planes);
+}
+
+Frustum Frustum::transformed(const glm::mat4& model) const
+{
+	// a plane is a row vector, p . x == (p * model) . (inverse(model) * x)
+	Frustum result;
+	glm::mat4 transposed = glm::transpose(model);
+	for (int p = 0; p < 6; p++)
+		result.planes[p] = transposed * planes[p];
+	normalizePlanes(result.planes);
+	return result;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const
+{
+	for (int p = 0; p < 6; p++) {
+		if (glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	glm::vec3 extent = (maximum - minimum) * 0.5f;
+	for (int p = 0; p < 6; p++) {
+		glm::vec3 normal(planes[p]);
+		if (glm::dot(normal, center) + planes[p].w < -glm::dot(glm::abs(normal), extent))
+			return false;
+	}
+	return true;
+}
+
+void BoxBatch::add(const glm::vec3& minimum, const glm::vec3& maximum)
+{
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	glm::vec3 extent = (maximum - minimum) * 0.5f;
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extent.x);
+	extentY.push_back(extent.y);
+	extentZ.push_back(extent.z);
+}
+
+void BoxBatch::clear()
+{
+	for (std::vector<float>* column : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+		column->clear();
+}
+
+void BoxBatch::reserve(size_t count)
+{
+	for (std::vector<float>* column : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+		column->reserve(count);
+}
+
+// a box is outside a plane when its center is further behind it than the box reaches along the normal,
+// dot(n, c) + d < -dot(|n|, e)
+size_t cullBoxes(const Frustum& frustum, const BoxBatch& boxes, unsigned char* visible, bool simd)
+{
+	size_t count = boxes.size();
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#ifdef FRUSTUM_SSE2
+	if (simd) {
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+		__m128 absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; p++) {
+			planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+			planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+			planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+			planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+			absX[p] = _mm_andnot_ps(signMask, planeX[p]);
+			absY[p] = _mm_andnot_ps(signMask, planeY[p]);
+			absZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+		}
+
+		for (; i + 4 <= count; i += 4) {
+			__m128 cx = _mm_loadu_ps(&boxes.centerX[i]), cy = _mm_loadu_ps(&boxes.centerY[i]), cz = _mm_loadu_ps(&boxes.centerZ[i]);
+			__m128 ex = _mm_loadu_ps(&boxes.extentX[i]), ey = _mm_loadu_ps(&boxes.extentY[i]), ez = _mm_loadu_ps(&boxes.extentZ[i]);
+
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < 6; p++) {
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+					_mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+				__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+			for (int k = 0; k < 4; k++) {
+				visible[i + k] = !((mask >> k) & 1);
+				visibleCount += visible[i + k];
+			}
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+		glm::vec3 extent(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++) {
+			glm::vec3 normal(frustum.planes[p]);
+			outside = glm::dot(normal, center) + frustum.planes[p].w + glm::dot(glm::abs(normal), extent) < 0.0f;
+		}
+		visible[i] = !outside;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
+
+void FrustumCullStats::print(unsigned int frameCount)
+{
+	if (frameCount > 0 && tested > 0) {
+		std::cout << name << " per frame: " << tested / frameCount << " tested, " << culled / frameCount << " frustum culled ("
+			<< static_cast<int>(100.0 * culled / tested) << "%)" << std::endl;
+	}
+	tested = culled = 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// six normalized planes (left, right, bottom, top, near, far), inside where dot(plane.xyz, p) + plane.w >= 0
+struct Frustum {
+	glm::vec4 planes[6];
+
+	Frustum() = default;
+	// Gribb/Hartmann: the clip space planes pulled back through matrix. projection * view gives world space planes,
+	// projection * view * model the model's object space.
+	explicit Frustum(const glm::mat4& matrix);
+
+	// the same planes in the space model maps from, e.g. world planes into a model's object space
+	Frustum transformed(const glm::mat4& model) const;
+
+	// conservative, boxes and spheres near a corner may pass while lying outside
+	bool intersectsSphere(const glm::vec3& center, float radius) const;
+	bool intersectsBox(const glm::vec3& minimum, const glm::vec3& maximum) const;
+};
+
+// axis aligned boxes as centers and half extents, structure of arrays so cullBoxes tests four at a time
+struct BoxBatch {
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	void add(const glm::vec3& minimum, const glm::vec3& maximum);
+	void clear();
+	void reserve(size_t count);
+	size_t size() const { return centerX.size(); }
+};
+
+// visible[i] = 1 when box i may intersect the frustum, 0 otherwise. returns the number visible.
+// simd = false forces the scalar loop, the SSE2 one is used otherwise when compiled in.
+size_t cullBoxes(const Frustum& frustum, const BoxBatch& boxes, unsigned char* visible, bool simd = true);
+
+// per pass counters for frustum culled draws
+struct FrustumCullStats {
+	std::string name;
+	unsigned long long tested = 0;
+	unsigned long long culled = 0;
+
+	explicit FrustumCullStats(const std::string& name) : name(name) {}
+	// prints the per frame averages over frameCount frames and resets the counters
+	void print(unsigned int frameCount);
+};
@@ -0,0 +1,91 @@
+#include "gl_extensions.h"
+#include <GLFW/glfw3.h>
+
+namespace glext {
+	PFNTEXSTORAGE2DPROC TexStorage2D = nullptr;
+	PFNGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+	PFNPROGRAMBINARYPROC ProgramBinary = nullptr;
+	PFNPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+	PFNMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = nullptr;
+	PFNBUFFERSTORAGEPROC BufferStorage = nullptr;
+
+	static bool loaded = false;
+	static int majorVersion = 0;
+	static int minorVersion = 0;
+	static bool s3tc = false;
+	static bool bptc = false;
+	static bool programBinary = false;
+
+	static bool versionAtLeast(int major, int minor)
+	{
+		return majorVersion > major || (majorVersion == major && minorVersion >= minor);
+	}
+
+	void load()
+	{
+		if (loaded) return;
+		loaded = true;
+
+		glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+		glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+		if (versionAtLeast(4, 2) || glfwExtensionSupported("GL_ARB_texture_storage"))
+			TexStorage2D = (PFNTEXSTORAGE2DPROC)glfwGetProcAddress("glTexStorage2D");
+
+		if (versionAtLeast(4, 1) || glfwExtensionSupported("GL_ARB_get_program_binary")) {
+			GetProgramBinary = (PFNGETPROGRAMBINARYPROC)glfwGetProcAddress("glGetProgramBinary");
+			ProgramBinary = (PFNPROGRAMBINARYPROC)glfwGetProcAddress("glProgramBinary");
+			ProgramParameteri = (PFNPROGRAMPARAMETERIPROC)glfwGetProcAddress("glProgramParameteri");
+
+			// some drivers expose the entry points without a single format to save into
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			programBinary = GetProgramBinary && ProgramBinary && ProgramParameteri && formats > 0;
+		}
+
+		if (versionAtLeast(4, 3) || glfwExtensionSupported("GL_ARB_multi_draw_indirect"))
+			MultiDrawElementsIndirect = (PFNMULTIDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glMultiDrawElementsIndirect");
+
+		if (versionAtLeast(4, 4) || glfwExtensionSupported("GL_ARB_buffer_storage"))
+			BufferStorage = (PFNBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+
+		s3tc = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") != 0;
+		bptc = versionAtLeast(4, 2) || glfwExtensionSupported("GL_ARB_texture_compression_bptc") != 0;
+	}
+
+	bool hasTextureStorage()
+	{
+		load();
+		return TexStorage2D != nullptr;
+	}
+
+	bool hasProgramBinary()
+	{
+		load();
+		return programBinary;
+	}
+
+	bool hasS3TC()
+	{
+		load();
+		return s3tc;
+	}
+
+	bool hasBPTC()
+	{
+		load();
+		return bptc;
+	}
+
+	bool hasMultiDrawIndirect()
+	{
+		load();
+		return MultiDrawElementsIndirect != nullptr;
+	}
+
+	bool hasBufferStorage()
+	{
+		load();
+		return BufferStorage != nullptr;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <glad/glad.h>
+
+// entry points and enums newer than the 3.3 core profile glad was generated for. they are fetched
+// with glfwGetProcAddress the first time a feature is queried (needs a current context) and stay
+// null when the driver doesn't expose them, so every caller keeps a 3.3 fallback.
+
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace glext {
+	typedef void (APIENTRYP PFNTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+
+	typedef void (APIENTRYP PFNGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP PFNPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP PFNPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+	typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride);
+	typedef void (APIENTRYP PFNBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+	// layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance; // must be 0 before GL 4.2
+	};
+
+	extern PFNTEXSTORAGE2DPROC TexStorage2D;
+	extern PFNGETPROGRAMBINARYPROC GetProgramBinary;
+	extern PFNPROGRAMBINARYPROC ProgramBinary;
+	extern PFNPROGRAMPARAMETERIPROC ProgramParameteri;
+	extern PFNMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect;
+	extern PFNBUFFERSTORAGEPROC BufferStorage;
+
+	// resolves every entry point once, later calls are free
+	void load();
+
+	// GL 4.2 or ARB_texture_storage
+	bool hasTextureStorage();
+	// GL 4.1 or ARB_get_program_binary, and the driver offers at least one binary format
+	bool hasProgramBinary();
+	// EXT_texture_compression_s3tc (BC1), not core but exposed by every desktop driver
+	bool hasS3TC();
+	// GL 4.2 or ARB_texture_compression_bptc (BC6H/BC7)
+	bool hasBPTC();
+	// GL 4.3 or ARB_multi_draw_indirect
+	bool hasMultiDrawIndirect();
+	// GL 4.4 or ARB_buffer_storage, needed for persistently mapped buffers
+	bool hasBufferStorage();
+}
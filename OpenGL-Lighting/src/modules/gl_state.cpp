@@ -0,0 +1,337 @@
+#include "gl_state.h"
+#include "gl_extensions.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace glstate {
+	namespace {
+		// no object or enum uses this value, so it stands for "whatever the driver has"
+		const GLuint UNKNOWN = 0xFFFFFFFF;
+
+		const GLenum TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_2D_MULTISAMPLE };
+		constexpr int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+		const GLenum BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+			GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_TEXTURE_BUFFER, GL_DRAW_INDIRECT_BUFFER };
+		constexpr int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+		constexpr int MAX_CAPABILITIES = 16;
+
+		struct IndexedBuffer {
+			GLuint buffer;
+			GLintptr offset;
+			GLsizeiptr size; // -1 for a whole buffer bind
+		};
+
+		struct State {
+			GLuint program;
+			GLuint vertexArray;
+			GLuint drawFramebuffer, readFramebuffer;
+			bool viewportKnown;
+			GLint viewport[4];
+			GLuint activeUnit; // index, not GL_TEXTUREi
+			GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGET_COUNT];
+			GLenum capabilities[MAX_CAPABILITIES];
+			bool capabilityEnabled[MAX_CAPABILITIES];
+			int capabilityCount;
+			GLenum blendSource, blendDestination;
+			GLenum cullFace;
+			GLenum depthFunc;
+			GLuint depthMask;
+			GLuint buffers[BUFFER_TARGET_COUNT];
+			IndexedBuffer uniformBindings[MAX_UNIFORM_BINDINGS];
+		};
+
+		State& current()
+		{
+			static State state;
+			static bool initialized = false;
+			if (!initialized) {
+				initialized = true;
+				invalidate();
+			}
+			return state;
+		}
+
+		// counts the call and tells whether it has to reach the driver
+		bool differs(Category category, bool different)
+		{
+			Stats& counters = stats();
+			if (different) counters.issued[static_cast<int>(category)]++;
+			else counters.elided[static_cast<int>(category)]++;
+			return different;
+		}
+
+		int textureTargetIndex(GLenum target)
+		{
+			for (int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+				if (TEXTURE_TARGETS[i] == target) return i;
+			return -1;
+		}
+
+		int bufferTargetIndex(GLenum target)
+		{
+			for (int i = 0; i < BUFFER_TARGET_COUNT; i++)
+				if (BUFFER_TARGETS[i] == target) return i;
+			return -1;
+		}
+
+		// slot of a capability, added on first use. -1 once the table is full, those pass through.
+		int capabilityIndex(GLenum capability)
+		{
+			State& state = current();
+			for (int i = 0; i < state.capabilityCount; i++)
+				if (state.capabilities[i] == capability) return i;
+			if (state.capabilityCount == MAX_CAPABILITIES) return -1;
+			state.capabilities[state.capabilityCount] = capability;
+			state.capabilityEnabled[state.capabilityCount] = false;
+			return state.capabilityCount++;
+		}
+
+		void setCapability(GLenum capability, bool enable)
+		{
+			State& state = current();
+			int known = state.capabilityCount;
+			int index = capabilityIndex(capability);
+			bool unknown = index < 0 || index >= known;
+			if (!differs(Category::Capability, unknown || state.capabilityEnabled[index] != enable)) return;
+			if (index >= 0) state.capabilityEnabled[index] = enable;
+			if (enable) glEnable(capability);
+			else glDisable(capability);
+		}
+
+		void forgetBuffer(GLuint buffer)
+		{
+			State& state = current();
+			for (GLuint& bound : state.buffers)
+				if (bound == buffer) bound = 0;
+			for (IndexedBuffer& binding : state.uniformBindings)
+				if (binding.buffer == buffer) binding.buffer = UNKNOWN;
+		}
+	}
+
+	void UseProgram(GLuint program)
+	{
+		State& state = current();
+		if (!differs(Category::Program, state.program != program)) return;
+		state.program = program;
+		glUseProgram(program);
+	}
+
+	void BindVertexArray(GLuint vertexArray)
+	{
+		State& state = current();
+		if (!differs(Category::VertexArray, state.vertexArray != vertexArray)) return;
+		state.vertexArray = vertexArray;
+		glBindVertexArray(vertexArray);
+	}
+
+	void BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		State& state = current();
+		bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+		bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+		bool different = (draw && state.drawFramebuffer != framebuffer) || (read && state.readFramebuffer != framebuffer);
+		if (!differs(Category::Framebuffer, different)) return;
+		if (draw) state.drawFramebuffer = framebuffer;
+		if (read) state.readFramebuffer = framebuffer;
+		glBindFramebuffer(target, framebuffer);
+	}
+
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		State& state = current();
+		bool different = !state.viewportKnown || state.viewport[0] != x || state.viewport[1] != y
+			|| state.viewport[2] != width || state.viewport[3] != height;
+		if (!differs(Category::Viewport, different)) return;
+		state.viewportKnown = true;
+		state.viewport[0] = x;
+		state.viewport[1] = y;
+		state.viewport[2] = width;
+		state.viewport[3] = height;
+		glViewport(x, y, width, height);
+	}
+
+	void ActiveTexture(GLenum unit)
+	{
+		State& state = current();
+		GLuint index = unit - GL_TEXTURE0;
+		if (!differs(Category::Texture, state.activeUnit != index)) return;
+		state.activeUnit = index;
+		glActiveTexture(unit);
+	}
+
+	void BindTexture(GLenum target, GLuint texture)
+	{
+		State& state = current();
+		int targetIndex = textureTargetIndex(target);
+		bool tracked = targetIndex >= 0 && state.activeUnit < MAX_TEXTURE_UNITS;
+		if (!differs(Category::Texture, !tracked || state.textures[state.activeUnit][targetIndex] != texture)) return;
+		if (tracked) state.textures[state.activeUnit][targetIndex] = texture;
+		glBindTexture(target, texture);
+	}
+
+	void Enable(GLenum capability)
+	{
+		setCapability(capability, true);
+	}
+
+	void Disable(GLenum capability)
+	{
+		setCapability(capability, false);
+	}
+
+	void BlendFunc(GLenum source, GLenum destination)
+	{
+		State& state = current();
+		if (!differs(Category::Capability, state.blendSource != source || state.blendDestination != destination)) return;
+		state.blendSource = source;
+		state.blendDestination = destination;
+		glBlendFunc(source, destination);
+	}
+
+	void CullFace(GLenum mode)
+	{
+		State& state = current();
+		if (!differs(Category::Capability, state.cullFace != mode)) return;
+		state.cullFace = mode;
+		glCullFace(mode);
+	}
+
+	void DepthFunc(GLenum func)
+	{
+		State& state = current();
+		if (!differs(Category::Capability, state.depthFunc != func)) return;
+		state.depthFunc = func;
+		glDepthFunc(func);
+	}
+
+	void DepthMask(GLboolean flag)
+	{
+		State& state = current();
+		if (!differs(Category::Capability, state.depthMask != static_cast<GLuint>(flag))) return;
+		state.depthMask = flag;
+		glDepthMask(flag);
+	}
+
+	void BindBuffer(GLenum target, GLuint buffer)
+	{
+		State& state = current();
+		int index = bufferTargetIndex(target);
+		if (!differs(Category::Buffer, index < 0 || state.buffers[index] != buffer)) return;
+		if (index >= 0) state.buffers[index] = buffer;
+		glBindBuffer(target, buffer);
+	}
+
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		State& state = current();
+		// the indexed bind also replaces the generic binding
+		int generic = bufferTargetIndex(target);
+		bool tracked = target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS;
+		IndexedBuffer* binding = tracked ? &state.uniformBindings[index] : nullptr;
+		bool different = !tracked || binding->buffer != buffer || binding->size != -1 || state.buffers[generic] != buffer;
+		if (!differs(Category::Buffer, different)) return;
+		if (tracked) *binding = { buffer, 0, -1 };
+		if (generic >= 0) state.buffers[generic] = buffer;
+		glBindBufferBase(target, index, buffer);
+	}
+
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		State& state = current();
+		int generic = bufferTargetIndex(target);
+		bool tracked = target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS;
+		IndexedBuffer* binding = tracked ? &state.uniformBindings[index] : nullptr;
+		bool different = !tracked || binding->buffer != buffer || binding->offset != offset || binding->size != size
+			|| state.buffers[generic] != buffer;
+		if (!differs(Category::Buffer, different)) return;
+		if (tracked) *binding = { buffer, offset, size };
+		if (generic >= 0) state.buffers[generic] = buffer;
+		glBindBufferRange(target, index, buffer, offset, size);
+	}
+
+	void DeleteTextures(GLsizei count, const GLuint* textures)
+	{
+		State& state = current();
+		for (GLsizei i = 0; i < count; i++) {
+			for (auto& unit : state.textures)
+				for (GLuint& bound : unit)
+					if (bound == textures[i]) bound = 0;
+		}
+		glDeleteTextures(count, textures);
+	}
+
+	void DeleteFramebuffers(GLsizei count, const GLuint* framebuffers)
+	{
+		State& state = current();
+		for (GLsizei i = 0; i < count; i++) {
+			if (state.drawFramebuffer == framebuffers[i]) state.drawFramebuffer = 0;
+			if (state.readFramebuffer == framebuffers[i]) state.readFramebuffer = 0;
+		}
+		glDeleteFramebuffers(count, framebuffers);
+	}
+
+	void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays)
+	{
+		State& state = current();
+		for (GLsizei i = 0; i < count; i++)
+			if (state.vertexArray == vertexArrays[i]) state.vertexArray = 0;
+		glDeleteVertexArrays(count, vertexArrays);
+	}
+
+	void DeleteBuffers(GLsizei count, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < count; i++)
+			forgetBuffer(buffers[i]);
+		glDeleteBuffers(count, buffers);
+	}
+
+	void DeleteProgram(GLuint program)
+	{
+		// a current program stays in use until another one is, but its name may be handed out again
+		State& state = current();
+		if (state.program == program) state.program = UNKNOWN;
+		glDeleteProgram(program);
+	}
+
+	void invalidate()
+	{
+		State& state = current();
+		state.program = state.vertexArray = UNKNOWN;
+		state.drawFramebuffer = state.readFramebuffer = UNKNOWN;
+		state.viewportKnown = false;
+		state.activeUnit = UNKNOWN;
+		for (auto& unit : state.textures)
+			std::fill(unit, unit + TEXTURE_TARGET_COUNT, UNKNOWN);
+		state.capabilityCount = 0;
+		state.blendSource = state.blendDestination = UNKNOWN;
+		state.cullFace = state.depthFunc = UNKNOWN;
+		state.depthMask = UNKNOWN;
+		std::fill(state.buffers, state.buffers + BUFFER_TARGET_COUNT, UNKNOWN);
+		for (IndexedBuffer& binding : state.uniformBindings)
+			binding = { UNKNOWN, 0, -1 };
+	}
+
+	Stats& stats()
+	{
+		static Stats counters;
+		return counters;
+	}
+
+	void printStats(unsigned int frameCount)
+	{
+		static const char* names[] = { "program", "vao", "framebuffer", "viewport", "texture", "capability", "buffer" };
+		Stats& counters = stats();
+		if (frameCount > 0) {
+			unsigned long long issued = 0, elided = 0;
+			std::cout << "gl state per frame (issued/elided):";
+			for (int i = 0; i < static_cast<int>(Category::Count); i++) {
+				std::cout << " " << names[i] << " " << counters.issued[i] / frameCount << "/" << counters.elided[i] / frameCount;
+				issued += counters.issued[i];
+				elided += counters.elided[i];
+			}
+			std::cout << ", total " << issued / frameCount << "/" << elided / frameCount << std::endl;
+		}
+		counters = Stats();
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <glad/glad.h>
+
+// shadows the context state the renderer changes most and drops calls that would set what is already set.
+// the entry points mirror the GL ones they wrap. every bind in the tree goes through here, a raw gl call
+// changing tracked state leaves the shadow stale until invalidate(). only valid for the main context.
+namespace glstate {
+	constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+	// indexed uniform buffer bindings that are tracked, higher ones pass straight through
+	constexpr unsigned int MAX_UNIFORM_BINDINGS = 16;
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	// GL_FRAMEBUFFER sets both the draw and the read binding
+	void BindFramebuffer(GLenum target, GLuint framebuffer);
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+	void ActiveTexture(GLenum unit);
+	// on the active unit. 2D, cube map, 2D array and multisample targets are tracked, others pass through.
+	void BindTexture(GLenum target, GLuint texture);
+
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void BlendFunc(GLenum source, GLenum destination);
+	void CullFace(GLenum mode);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean flag);
+
+	// GL_ELEMENT_ARRAY_BUFFER belongs to the bound vertex array and always passes through
+	void BindBuffer(GLenum target, GLuint buffer);
+	void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+	// deleting a bound object reverts its bindings to 0, the shadow has to follow
+	void DeleteTextures(GLsizei count, const GLuint* textures);
+	void DeleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+	void DeleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+	void DeleteBuffers(GLsizei count, const GLuint* buffers);
+	void DeleteProgram(GLuint program);
+
+	// forgets everything, the next call of each kind is issued
+	void invalidate();
+
+	// calls issued to the driver and elided since the last reset
+	enum class Category { Program, VertexArray, Framebuffer, Viewport, Texture, Capability, Buffer, Count };
+	struct Stats {
+		unsigned long long issued[static_cast<int>(Category::Count)] = {};
+		unsigned long long elided[static_cast<int>(Category::Count)] = {};
+	};
+	Stats& stats();
+	// prints the per frame averages over frameCount frames and resets the counters
+	void printStats(unsigned int frameCount);
+}
@@ -0,0 +1,393 @@
+#include "ibl_baker.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader.h"
+#include "framebuffer.h"
+#include "utils.h"
+#include "mesh_cache.h"
+#include "mapped_file.h"
+#include "texture_cache.h"
+#include "gl_state.h"
+
+namespace {
+	const char IBL_CACHE_MAGIC[4] = { 'O', 'G', 'L', 'I' };
+	const int IBL_MAP_COUNT = 3;
+
+	const char* EQR_TO_CUBEMAP_VERT = "shaders/cubemapping/eqr_to_cubemap.vert";
+	const char* EQR_TO_CUBEMAP_FRAG = "shaders/cubemapping/eqr_to_cubemap.frag";
+	const char* PREFILTER_FRAG = "shaders/cubemapping/prefilter_cubemap.frag";
+	const char* BRDF_VERT = "shaders/pbr/brdf.vert";
+	const char* BRDF_FRAG = "shaders/pbr/brdf.frag";
+
+	struct MapLayout {
+		GLenum target;
+		GLenum internalFormat;
+		GLenum format;
+		int size;
+		int levelCount;
+	};
+
+	int fullMipCount(int size)
+	{
+		int levels = 1;
+		while (size > 1) {
+			size >>= 1;
+			levels++;
+		}
+		return levels;
+	}
+
+	int levelSize(int size, int level)
+	{
+		return size >> level > 0 ? size >> level : 1;
+	}
+
+	// same order as the members of IBLMaps
+	void describeMaps(const IBLBakeParams& params, MapLayout layouts[IBL_MAP_COUNT])
+	{
+		layouts[0] = { GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, params.environmentSize, fullMipCount(params.environmentSize) };
+		layouts[1] = { GL_TEXTURE_CUBE_MAP, GL_RGB16F, GL_RGB, params.prefilterSize, params.prefilterLevels };
+		layouts[2] = { GL_TEXTURE_2D, GL_RG16F, GL_RG, params.brdfSize, 1 };
+	}
+
+	unsigned int* mapSlots(IBLMaps& maps, int index)
+	{
+		unsigned int* slots[IBL_MAP_COUNT] = { &maps.environment, &maps.prefilter, &maps.brdfLUT };
+		return slots[index];
+	}
+
+	int faceCount(const MapLayout& layout)
+	{
+		return layout.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	}
+
+	size_t faceBytes(const MapLayout& layout, int level)
+	{
+		size_t size = levelSize(layout.size, level);
+		size_t components = layout.format == GL_RG ? 2 : 3;
+		return size * size * components * sizeof(uint16_t);
+	}
+
+	size_t mapBytes(const MapLayout& layout)
+	{
+		size_t bytes = 0;
+		for (int level = 0; level < layout.levelCount; level++)
+			bytes += faceBytes(layout, level) * faceCount(layout);
+		return bytes;
+	}
+
+	// allocates every level of a map, filled from texels (half floats in file order) when given
+	unsigned int createMap(const MapLayout& layout, const unsigned char* texels)
+	{
+		unsigned int id;
+		glGenTextures(1, &id);
+		glstate::BindTexture(layout.target, id);
+		for (int level = 0; level < layout.levelCount; level++) {
+			int size = levelSize(layout.size, level);
+			for (int face = 0; face < faceCount(layout); face++) {
+				GLenum faceTarget = layout.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				glTexImage2D(faceTarget, level, layout.internalFormat, size, size, 0, layout.format, GL_HALF_FLOAT, texels);
+				if (texels) texels += faceBytes(layout, level);
+			}
+		}
+
+		glTexParameteri(layout.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(layout.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		if (layout.target == GL_TEXTURE_CUBE_MAP)
+			glTexParameteri(layout.target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(layout.target, GL_TEXTURE_MIN_FILTER, layout.levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(layout.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(layout.target, GL_TEXTURE_MAX_LEVEL, layout.levelCount - 1);
+		glstate::BindTexture(layout.target, 0);
+		return id;
+	}
+
+	// reads the environment mip closest to sourceSize back as floats and projects it
+	SH9 projectEnvironmentSH(unsigned int environment, const MapLayout& layout, int sourceSize)
+	{
+		int level = 0;
+		while (level + 1 < layout.levelCount && levelSize(layout.size, level) > sourceSize)
+			level++;
+		int size = levelSize(layout.size, level);
+
+		std::vector<float> texels(static_cast<size_t>(size) * size * 3 * 6);
+		const float* faces[6];
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, environment);
+		for (int face = 0; face < 6; face++) {
+			float* data = texels.data() + static_cast<size_t>(size) * size * 3 * face;
+			glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_FLOAT, data);
+			faces[face] = data;
+		}
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+		return radianceToIrradianceSH9(projectCubemapSH9(faces, size));
+	}
+
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+void IBLMaps::release()
+{
+	unsigned int textures[IBL_MAP_COUNT] = { environment, prefilter, brdfLUT };
+	glstate::DeleteTextures(IBL_MAP_COUNT, textures);
+	environment = prefilter = brdfLUT = 0;
+}
+
+IBLMaps bakeIBL(unsigned int hdrTexture, const IBLBakeParams& params)
+{
+	MapLayout layouts[IBL_MAP_COUNT];
+	describeMaps(params, layouts);
+
+	IBLMaps maps;
+	for (int i = 0; i < IBL_MAP_COUNT; i++)
+		*mapSlots(maps, i) = createMap(layouts[i], nullptr);
+
+	Shader EQRToCubemap(EQR_TO_CUBEMAP_VERT, EQR_TO_CUBEMAP_FRAG);
+	Shader PrefilterShader(EQR_TO_CUBEMAP_VERT, PREFILTER_FRAG);
+	Shader IntegratedBRDF(BRDF_VERT, BRDF_FRAG);
+	unsigned int cube = createCubeVAO();
+	unsigned int frame = createFrameVAO();
+
+	Framebuffer hdrCapture(params.environmentSize, params.environmentSize);
+	hdrCapture.attachRenderbuffer(GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24);
+
+	glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+	glm::mat4 captureViews[] =
+	{
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+	};
+
+	// renders the cube once per face into level of cubemap with the shader already set up
+	auto captureFaces = [&](const Shader& shader, unsigned int cubemap, int level, int size) {
+		glBindRenderbuffer(GL_RENDERBUFFER, hdrCapture.getRBO());
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+		glstate::Viewport(0, 0, size, size);
+		for (unsigned int i = 0; i < 6; i++)
+		{
+			shader.setMat4("view", captureViews[i]);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, level);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			glstate::BindVertexArray(cube);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			glstate::BindVertexArray(0);
+		}
+	};
+
+	// environment cubemap from the equirectangular hdr
+	EQRToCubemap.use();
+	EQRToCubemap.setInt("equirectangularMap", 0);
+	EQRToCubemap.setMat4("projection", captureProjection);
+	glstate::ActiveTexture(GL_TEXTURE0);
+	glstate::BindTexture(GL_TEXTURE_2D, hdrTexture);
+
+	hdrCapture.bind();
+	captureFaces(EQRToCubemap, maps.environment, 0, params.environmentSize);
+	hdrCapture.unbind();
+
+	// generate mipmaps after the cubemap base texture is set
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, maps.environment);
+	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	// irradiance is low frequency, a small environment mip projected on the cpu is plenty
+	maps.irradianceSH = projectEnvironmentSH(maps.environment, layouts[0], params.shSourceSize);
+
+	// prefiltered specular, one roughness step per mip
+	glstate::ActiveTexture(GL_TEXTURE0);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, maps.environment);
+
+	hdrCapture.bind();
+	PrefilterShader.use();
+	PrefilterShader.setInt("environmentMap", 0);
+	PrefilterShader.setMat4("projection", captureProjection);
+	for (int mip = 0; mip < params.prefilterLevels; mip++) {
+		float roughness = params.prefilterLevels > 1 ? (float)mip / (float)(params.prefilterLevels - 1) : 0.0f;
+		PrefilterShader.setFloat("roughness", roughness);
+		captureFaces(PrefilterShader, maps.prefilter, mip, levelSize(params.prefilterSize, mip));
+	}
+
+	// precomputed brdf
+	glBindRenderbuffer(GL_RENDERBUFFER, hdrCapture.getRBO());
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, params.brdfSize, params.brdfSize);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, maps.brdfLUT, 0);
+	glstate::Viewport(0, 0, params.brdfSize, params.brdfSize);
+	IntegratedBRDF.use();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glstate::BindVertexArray(frame);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+	glstate::BindVertexArray(0);
+	hdrCapture.unbind();
+
+	glstate::DeleteVertexArrays(1, &cube);
+	glstate::DeleteVertexArrays(1, &frame);
+	glstate::DeleteProgram(EQRToCubemap.ID);
+	glstate::DeleteProgram(PrefilterShader.ID);
+	glstate::DeleteProgram(IntegratedBRDF.ID);
+	return maps;
+}
+
+std::string IBLCache::cachePathFor(const std::string& hdrPath)
+{
+	return hdrPath + ".iblcache";
+}
+
+uint64_t IBLCache::hashParams(const IBLBakeParams& params)
+{
+	// sample counts live in the shaders, so their sources are part of the key
+	int values[] = { params.environmentSize, params.shSourceSize, params.prefilterSize, params.prefilterLevels, params.brdfSize };
+	uint64_t hash = hashBytes(14695981039346656037ull, values, sizeof(values));
+	const char* shaders[] = { EQR_TO_CUBEMAP_VERT, EQR_TO_CUBEMAP_FRAG, PREFILTER_FRAG, BRDF_VERT, BRDF_FRAG };
+	for (const char* shader : shaders) {
+		uint64_t shaderHash = MeshCache::hashFile(shader);
+		hash = hashBytes(hash, &shaderHash, sizeof(shaderHash));
+	}
+	return hash;
+}
+
+bool IBLCache::write(const std::string& cachePath, uint64_t sourceHash, uint64_t paramsHash, const IBLBakeParams& params, const IBLMaps& maps)
+{
+	std::string tempPath = cachePath + ".tmp";
+	std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "ERROR::IBL_CACHE::Could not write " << cachePath << std::endl;
+		return false;
+	}
+
+	MapLayout layouts[IBL_MAP_COUNT];
+	describeMaps(params, layouts);
+
+	IBLCacheHeader header = {};
+	std::memcpy(header.magic, IBL_CACHE_MAGIC, sizeof(header.magic));
+	header.version = IBL_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.paramsHash = paramsHash;
+	header.textureCount = IBL_MAP_COUNT;
+	for (int k = 0; k < 9; k++)
+		std::memcpy(&header.irradianceSH[k * 3], &maps.irradianceSH.coefficients[k], sizeof(float) * 3);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	uint64_t offset = sizeof(IBLCacheHeader) + sizeof(IBLCacheEntry) * IBL_MAP_COUNT;
+	for (const MapLayout& layout : layouts) {
+		IBLCacheEntry entry = {};
+		entry.dataOffset = offset;
+		entry.target = layout.target;
+		entry.internalFormat = layout.internalFormat;
+		entry.format = layout.format;
+		entry.size = layout.size;
+		entry.levelCount = layout.levelCount;
+		entry.faceCount = faceCount(layout);
+		out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		offset += mapBytes(layout);
+	}
+
+	// rgb16f rows aren't 4 byte multiples on the small mips
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	IBLMaps source = maps;
+	std::vector<unsigned char> texels;
+	for (int i = 0; i < IBL_MAP_COUNT; i++) {
+		const MapLayout& layout = layouts[i];
+		glstate::BindTexture(layout.target, *mapSlots(source, i));
+		for (int level = 0; level < layout.levelCount; level++) {
+			texels.resize(faceBytes(layout, level));
+			for (int face = 0; face < faceCount(layout); face++) {
+				GLenum faceTarget = layout.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+				glGetTexImage(faceTarget, level, layout.format, GL_HALF_FLOAT, texels.data());
+				out.write(reinterpret_cast<const char*>(texels.data()), texels.size());
+			}
+		}
+		glstate::BindTexture(layout.target, 0);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	out.close();
+	if (!out) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::remove(cachePath.c_str());
+	if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool IBLCache::load(const std::string& cachePath, uint64_t sourceHash, uint64_t paramsHash, IBLMaps& maps)
+{
+	MappedFile file;
+	if (!file.open(cachePath)) return false;
+	if (file.size() < sizeof(IBLCacheHeader) + sizeof(IBLCacheEntry) * IBL_MAP_COUNT) return false;
+
+	const IBLCacheHeader* header = reinterpret_cast<const IBLCacheHeader*>(file.data());
+	if (std::memcmp(header->magic, IBL_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != IBL_CACHE_VERSION ||
+		header->sourceHash != sourceHash ||
+		header->paramsHash != paramsHash ||
+		header->textureCount != IBL_MAP_COUNT)
+		return false;
+
+	// validate every entry before anything is uploaded
+	const IBLCacheEntry* entries = reinterpret_cast<const IBLCacheEntry*>(file.data() + sizeof(IBLCacheHeader));
+	MapLayout layouts[IBL_MAP_COUNT];
+	for (int i = 0; i < IBL_MAP_COUNT; i++) {
+		const IBLCacheEntry& entry = entries[i];
+		layouts[i] = { entry.target, entry.internalFormat, entry.format, static_cast<int>(entry.size), static_cast<int>(entry.levelCount) };
+		if ((entry.target != GL_TEXTURE_CUBE_MAP && entry.target != GL_TEXTURE_2D) ||
+			(entry.format != GL_RGB && entry.format != GL_RG) ||
+			entry.size == 0 || entry.levelCount == 0 || entry.levelCount > 16 ||
+			entry.faceCount != static_cast<uint32_t>(faceCount(layouts[i])) ||
+			entry.dataOffset + mapBytes(layouts[i]) > file.size())
+			return false;
+	}
+
+	for (int k = 0; k < 9; k++)
+		maps.irradianceSH.coefficients[k] = glm::vec3(header->irradianceSH[k * 3], header->irradianceSH[k * 3 + 1], header->irradianceSH[k * 3 + 2]);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i = 0; i < IBL_MAP_COUNT; i++)
+		*mapSlots(maps, i) = createMap(layouts[i], file.data() + entries[i].dataOffset);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return true;
+}
+
+IBLMaps loadOrBakeIBL(const std::string& hdrPath, const IBLBakeParams& params, bool* fromCache)
+{
+	std::string cachePath = IBLCache::cachePathFor(hdrPath);
+	uint64_t sourceHash = MeshCache::hashFile(hdrPath);
+	uint64_t paramsHash = IBLCache::hashParams(params);
+
+	IBLMaps maps;
+	bool hit = sourceHash != 0 && IBLCache::load(cachePath, sourceHash, paramsHash, maps);
+	if (fromCache) *fromCache = hit;
+	if (hit) return maps;
+
+	unsigned int hdr = loadHDR(hdrPath.c_str(), true);
+	maps = bakeIBL(hdr, params);
+	TextureCache::instance().release(hdr);
+
+	if (sourceHash != 0 && !IBLCache::write(cachePath, sourceHash, paramsHash, params, maps))
+		std::cout << "ERROR::IBL_CACHE::Failed to cache " << hdrPath << std::endl;
+	return maps;
+}
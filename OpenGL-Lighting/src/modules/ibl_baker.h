@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <glad/glad.h>
+
+#include "sh_projection.h"
+
+// bump whenever the file layout below changes. edits to the bake shaders are picked up by the key.
+constexpr uint32_t IBL_CACHE_VERSION = 2;
+
+struct IBLBakeParams {
+	int environmentSize = 512; // cubemap the hdr is projected onto, mipped down to 1x1
+	int shSourceSize = 64;     // environment mip projected onto the irradiance SH
+	int prefilterSize = 128;
+	int prefilterLevels = 5;   // roughness 0..1 spread over these mips
+	int brdfSize = 512;
+};
+
+// everything the pbr ibl shader reads. ids are owned by whoever holds the struct.
+struct IBLMaps {
+	unsigned int environment = 0; // rgb16f cubemap
+	unsigned int prefilter = 0;   // rgb16f cubemap
+	unsigned int brdfLUT = 0;     // rg16f 2d
+	SH9 irradianceSH;             // diffuse irradiance / pi, see radianceToIrradianceSH9
+
+	void release();
+};
+
+// file layout: header (with the irradiance SH), one entry per texture in IBLMaps order, then the half
+// float texels of every entry (level major, +x..-z faces inside each level, tightly packed rows).
+struct IBLCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint64_t paramsHash;
+	uint32_t textureCount;
+	uint32_t reserved;
+	float irradianceSH[27];
+	uint32_t padding;
+};
+
+struct IBLCacheEntry {
+	uint64_t dataOffset;
+	uint32_t target;
+	uint32_t internalFormat;
+	uint32_t format;
+	uint32_t size;
+	uint32_t levelCount;
+	uint32_t faceCount;
+};
+
+// renders the environment, prefilter and brdf maps from an equirectangular hdr texture and projects
+// the environment onto the irradiance SH. needs the bake shaders under shaders/ and leaves the
+// default framebuffer bound.
+IBLMaps bakeIBL(unsigned int hdrTexture, const IBLBakeParams& params);
+
+class IBLCache {
+public:
+	// e.g. newport_loft.hdr -> newport_loft.hdr.iblcache
+	static std::string cachePathFor(const std::string& hdrPath);
+	// bake parameters plus the contents of every bake shader
+	static uint64_t hashParams(const IBLBakeParams& params);
+
+	// reads every texture back with glGetTexImage and writes it as half floats
+	static bool write(const std::string& cachePath, uint64_t sourceHash, uint64_t paramsHash, const IBLBakeParams& params, const IBLMaps& maps);
+	// uploads the cached textures straight from the mapping, false when missing or stale
+	static bool load(const std::string& cachePath, uint64_t sourceHash, uint64_t paramsHash, IBLMaps& maps);
+};
+
+// cache hit or bake + write. the hdr is only decoded on a miss.
+IBLMaps loadOrBakeIBL(const std::string& hdrPath, const IBLBakeParams& params, bool* fromCache = nullptr);
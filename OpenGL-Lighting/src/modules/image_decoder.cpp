@@ -0,0 +1,87 @@
+#include "image_decoder.h"
+#include "../../stb/stb_image.h"
+
+DecodedImage::DecodedImage(DecodedImage&& other) noexcept
+	: path(std::move(other.path)), width(other.width), height(other.height), channels(other.channels), hdr(other.hdr), data(other.data)
+{
+	other.data = nullptr;
+}
+
+DecodedImage& DecodedImage::operator=(DecodedImage&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		path = std::move(other.path);
+		width = other.width;
+		height = other.height;
+		channels = other.channels;
+		hdr = other.hdr;
+		data = other.data;
+		other.data = nullptr;
+	}
+	return *this;
+}
+
+void DecodedImage::release()
+{
+	if (data) stbi_image_free(data);
+	data = nullptr;
+}
+
+DecodedImage decodeImage(const std::string& path, bool flipVertically, bool hdr)
+{
+	// the flip flag is thread local in stb_image so concurrent decodes don't race on it
+	stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+	DecodedImage image;
+	image.path = path;
+	image.hdr = hdr;
+	if (hdr)
+		image.data = stbi_loadf(path.c_str(), &image.width, &image.height, &image.channels, 0);
+	else
+		image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+	return image;
+}
+
+ImageDecodeBatch::ImageDecodeBatch(ThreadPool& pool) : pool(pool), state(std::make_shared<SharedState>())
+{
+}
+
+ImageDecodeBatch::~ImageDecodeBatch()
+{
+	// drain whatever wasn't collected so no worker writes into a dead batch and nothing leaks
+	size_t index;
+	DecodedImage image;
+	while (next(index, image)) {}
+}
+
+size_t ImageDecodeBatch::add(const std::string& path, bool flipVertically, bool hdr)
+{
+	size_t index = submitted++;
+	std::shared_ptr<SharedState> shared = state;
+	pool.enqueue([shared, index, path, flipVertically, hdr]() {
+		DecodedImage image = decodeImage(path, flipVertically, hdr);
+		{
+			std::lock_guard<std::mutex> lock(shared->mutex);
+			shared->done.push_back({ index, std::move(image) });
+		}
+		shared->condition.notify_one();
+	});
+	return index;
+}
+
+bool ImageDecodeBatch::next(size_t& index, DecodedImage& image)
+{
+	if (collected == submitted) return false;
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->condition.wait(lock, [this]() { return !state->done.empty(); });
+
+	Completion completion = std::move(state->done.front());
+	state->done.pop_front();
+	collected++;
+
+	index = completion.index;
+	image = std::move(completion.image);
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "thread_pool.h"
+
+// pixels decoded by stb_image. move-only, frees the stb allocation on destruction.
+struct DecodedImage {
+	std::string path;
+	int width = 0, height = 0, channels = 0;
+	bool hdr = false;
+	void* data = nullptr; // unsigned char* for ldr images, float* for hdr
+
+	DecodedImage() = default;
+	~DecodedImage() { release(); }
+	DecodedImage(DecodedImage&& other) noexcept;
+	DecodedImage& operator=(DecodedImage&& other) noexcept;
+	DecodedImage(const DecodedImage&) = delete;
+	DecodedImage& operator=(const DecodedImage&) = delete;
+
+	void release();
+	bool valid() const { return data != nullptr; }
+};
+
+// decodes a single image on the calling thread
+DecodedImage decodeImage(const std::string& path, bool flipVertically, bool hdr = false);
+
+// fans stb_image decodes out to the worker pool. finished images come back through a completion
+// queue in the order they finish, so the context thread can upload one while the rest still decode.
+//
+//   ImageDecodeBatch batch;
+//   batch.add("a.png", true);
+//   batch.add("b.png", true);
+//   size_t index; DecodedImage image;
+//   while (batch.next(index, image)) { /* glTexImage2D ... */ }
+class ImageDecodeBatch {
+public:
+	explicit ImageDecodeBatch(ThreadPool& pool = ThreadPool::shared());
+	~ImageDecodeBatch();
+
+	ImageDecodeBatch(const ImageDecodeBatch&) = delete;
+	ImageDecodeBatch& operator=(const ImageDecodeBatch&) = delete;
+
+	// queues a decode and returns its index within the batch
+	size_t add(const std::string& path, bool flipVertically, bool hdr = false);
+
+	// blocks until the next image is decoded. returns false once every queued image was handed out.
+	bool next(size_t& index, DecodedImage& image);
+
+	size_t size() const { return submitted; }
+
+private:
+	struct Completion {
+		size_t index;
+		DecodedImage image;
+	};
+	struct SharedState {
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<Completion> done;
+	};
+
+	ThreadPool& pool;
+	std::shared_ptr<SharedState> state;
+	size_t submitted = 0;
+	size_t collected = 0;
+};
@@ -0,0 +1,154 @@
+#include "instance_buffer.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+
+InstanceBuffer::InstanceBuffer(bool withParams)
+	: withParams(withParams)
+{
+	glGenBuffers(1, &transformVBO);
+	if (withParams)
+		glGenBuffers(1, &paramsVBO);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	glstate::DeleteBuffers(1, &transformVBO);
+	glstate::DeleteBuffers(1, &paramsVBO);
+}
+
+void InstanceBuffer::resize(size_t count)
+{
+	size_t previous = transforms.size();
+	transforms.resize(count, glm::mat4(1.0f));
+	if (withParams)
+		params.resize(count, glm::vec4(0.0f));
+	if (count > previous)
+		markDirty(previous, count);
+	else
+		dirty.erase(std::remove_if(dirty.begin(), dirty.end(),
+			[count](const std::pair<size_t, size_t>& range) { return range.first >= count; }), dirty.end());
+}
+
+void InstanceBuffer::setTransform(size_t index, const glm::mat4& model)
+{
+	transforms[index] = model;
+	markDirty(index, index + 1);
+}
+
+void InstanceBuffer::setTransforms(size_t first, const glm::mat4* models, size_t count)
+{
+	std::copy(models, models + count, transforms.begin() + first);
+	markDirty(first, first + count);
+}
+
+void InstanceBuffer::setParams(size_t index, const glm::vec4& value)
+{
+	if (!withParams) {
+		std::cout << "ERROR::INSTANCE_BUFFER::CREATED_WITHOUT_PARAMS" << std::endl;
+		return;
+	}
+	params[index] = value;
+	markDirty(index, index + 1);
+}
+
+void InstanceBuffer::markDirty(size_t begin, size_t end)
+{
+	// sequential edits, the common case, keep growing the last range
+	if (!dirty.empty() && begin >= dirty.back().first && begin <= dirty.back().second + INSTANCE_MERGE_GAP) {
+		dirty.back().second = std::max(dirty.back().second, end);
+		return;
+	}
+	dirty.push_back(std::make_pair(begin, end));
+}
+
+void InstanceBuffer::upload()
+{
+	if (dirty.empty()) return;
+	size_t count = transforms.size();
+	UploadStats& stats = uploadStats();
+
+	std::sort(dirty.begin(), dirty.end());
+	std::vector<std::pair<size_t, size_t>> ranges;
+	size_t covered = 0;
+	for (const std::pair<size_t, size_t>& range : dirty) {
+		size_t end = std::min(range.second, count);
+		if (range.first >= end) continue;
+		if (!ranges.empty() && range.first <= ranges.back().second + INSTANCE_MERGE_GAP) {
+			covered += std::max(ranges.back().second, end) - ranges.back().second;
+			ranges.back().second = std::max(ranges.back().second, end);
+		}
+		else {
+			covered += end - range.first;
+			ranges.push_back(std::make_pair(range.first, end));
+		}
+	}
+	dirty.clear();
+
+	// past half the buffer a full upload into fresh storage beats waiting on the draws still reading the old one
+	if (count > capacity || covered * 2 > count) {
+		glstate::BindBuffer(GL_ARRAY_BUFFER, transformVBO);
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), transforms.data(), GL_DYNAMIC_DRAW);
+		stats.bytes += count * sizeof(glm::mat4);
+		if (withParams) {
+			glstate::BindBuffer(GL_ARRAY_BUFFER, paramsVBO);
+			glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec4), params.data(), GL_DYNAMIC_DRAW);
+			stats.bytes += count * sizeof(glm::vec4);
+		}
+		capacity = count;
+		stats.ranges++;
+	}
+	else {
+		for (const std::pair<size_t, size_t>& range : ranges) {
+			size_t instances = range.second - range.first;
+			glstate::BindBuffer(GL_ARRAY_BUFFER, transformVBO);
+			glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(glm::mat4), instances * sizeof(glm::mat4), &transforms[range.first]);
+			stats.bytes += instances * sizeof(glm::mat4);
+			if (withParams) {
+				glstate::BindBuffer(GL_ARRAY_BUFFER, paramsVBO);
+				glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(glm::vec4), instances * sizeof(glm::vec4), &params[range.first]);
+				stats.bytes += instances * sizeof(glm::vec4);
+			}
+		}
+		stats.ranges += ranges.size();
+	}
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::attach() const
+{
+	glstate::BindBuffer(GL_ARRAY_BUFFER, transformVBO);
+	for (GLuint column = 0; column < 4; column++) {
+		glEnableVertexAttribArray(INSTANCE_MODEL_LOCATION + column);
+		glVertexAttribPointer(INSTANCE_MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + column, 1);
+	}
+	if (withParams) {
+		glstate::BindBuffer(GL_ARRAY_BUFFER, paramsVBO);
+		glEnableVertexAttribArray(INSTANCE_PARAMS_LOCATION);
+		glVertexAttribPointer(INSTANCE_PARAMS_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glVertexAttribDivisor(INSTANCE_PARAMS_LOCATION, 1);
+	}
+	else {
+		// the shader reads the current generic value instead, (0, 0, 0, 1) unless set
+		glDisableVertexAttribArray(INSTANCE_PARAMS_LOCATION);
+	}
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstanceBuffer::UploadStats& InstanceBuffer::uploadStats()
+{
+	static UploadStats stats;
+	return stats;
+}
+
+void InstanceBuffer::printUploadStats(unsigned int frameCount)
+{
+	UploadStats& stats = uploadStats();
+	if (frameCount > 0) {
+		std::cout << "instance uploads per frame: " << stats.ranges / frameCount << " ranges, "
+			<< stats.bytes / frameCount / 1024 << " KB" << std::endl;
+	}
+	stats = UploadStats();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// attribute locations of the per-instance data, after the widest vertex layout (0-4).
+// a mat4 takes four consecutive locations.
+constexpr GLuint INSTANCE_MODEL_LOCATION = 5;
+constexpr GLuint INSTANCE_PARAMS_LOCATION = 9;
+
+// dirty ranges closer than this many instances are sent as one, a glBufferSubData call costs more than the gap
+constexpr size_t INSTANCE_MERGE_GAP = 64;
+
+// per-instance model matrices, and optionally a vec4 of material params, as divisor 1 vertex attributes.
+// edits stay on the cpu and only the touched ranges go out on upload(), shaders read them with INSTANCED.
+class InstanceBuffer {
+public:
+	explicit InstanceBuffer(bool withParams = false);
+	~InstanceBuffer();
+
+	// owns GL buffers
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	// new instances get the identity and zero params, growing reallocates the GL buffers on the next upload
+	void resize(size_t count);
+	size_t size() const { return transforms.size(); }
+	bool hasParams() const { return withParams; }
+
+	void setTransform(size_t index, const glm::mat4& model);
+	void setTransforms(size_t first, const glm::mat4* models, size_t count);
+	void setParams(size_t index, const glm::vec4& params);
+	const glm::mat4& getTransform(size_t index) const { return transforms[index]; }
+	const glm::vec4& getParams(size_t index) const { return params[index]; }
+
+	// sends the dirty ranges, merged and sorted. draws taking an InstanceBuffer call this themselves.
+	void upload();
+	// points the instance attributes of the bound VAO at this buffer
+	void attach() const;
+
+	// ranges and bytes sent by every InstanceBuffer since the last reset
+	struct UploadStats {
+		unsigned long long ranges = 0;
+		unsigned long long bytes = 0;
+	};
+	static UploadStats& uploadStats();
+	// prints the per frame averages over frameCount frames and resets the counters
+	static void printUploadStats(unsigned int frameCount);
+
+private:
+	bool withParams;
+	unsigned int transformVBO = 0, paramsVBO = 0;
+	size_t capacity = 0; // instances the GL buffers hold
+	std::vector<glm::mat4> transforms;
+	std::vector<glm::vec4> params;
+	std::vector<std::pair<size_t, size_t>> dirty; // [begin, end) in instances
+
+	void markDirty(size_t begin, size_t end);
+};
@@ -0,0 +1,83 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	mapped = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int handle = ::open(path.c_str(), O_RDONLY);
+	if (handle < 0) return false;
+
+	struct stat st;
+	if (fstat(handle, &st) != 0 || st.st_size == 0) {
+		::close(handle);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, handle, 0);
+	if (view == MAP_FAILED) {
+		::close(handle);
+		return false;
+	}
+
+	fd = handle;
+	mapped = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(st.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (mapped) UnmapViewOfFile(mapped);
+	if (mappingHandle) CloseHandle(mappingHandle);
+	if (fileHandle) CloseHandle(fileHandle);
+#else
+	if (mapped) munmap(const_cast<unsigned char*>(mapped), length);
+	if (fd >= 0) ::close(fd);
+#endif
+	mapped = nullptr;
+	length = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	fd = -1;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// read-only memory mapping of a whole file. platform handles are kept opaque so that
+// windows.h never leaks into the rest of the modules.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	const unsigned char* data() const { return mapped; }
+	size_t size() const { return length; }
+	bool isOpen() const { return mapped != nullptr; }
+
+private:
+	const unsigned char* mapped = nullptr;
+	size_t length = 0;
+
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	int fd = -1;
+};
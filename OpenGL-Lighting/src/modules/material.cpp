@@ -0,0 +1,94 @@
+#include "material.h"
+#include "gl_state.h"
+#include "alloc_stats.h"
+
+#include <iostream>
+
+namespace {
+	const char* SLOT_TYPES[MATERIAL_SLOT_COUNT] = { "texture_diffuse", "texture_specular", "texture_normal" };
+}
+
+bool Material::slotForType(const std::string& type, MaterialSlot& slot)
+{
+	for (unsigned int i = 0; i < MATERIAL_SLOT_COUNT; i++) {
+		if (type == SLOT_TYPES[i]) {
+			slot = static_cast<MaterialSlot>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const Material::ShaderBinding& Material::resolve(const Shader& shader) const
+{
+	if (lastBinding < bindings.size() && bindings[lastBinding].program == shader.ID)
+		return bindings[lastBinding];
+	for (size_t i = 0; i < bindings.size(); i++) {
+		if (bindings[i].program == shader.ID) {
+			lastBinding = i;
+			return bindings[i];
+		}
+	}
+
+	ShaderBinding binding;
+	binding.program = shader.ID;
+	for (unsigned int i = 0; i < MATERIAL_SLOT_COUNT; i++) {
+		// material.texture_diffuse1 in a Material struct, a plain texture_diffuse1 otherwise
+		std::string name = std::string(SLOT_TYPES[i]) + "1";
+		binding.samplers[i] = shader.getUniform<int>("material." + name);
+		if (!binding.samplers[i].valid())
+			binding.samplers[i] = shader.getUniform<int>(name);
+	}
+
+	GLuint blockIndex = glGetUniformBlockIndex(shader.ID, "MaterialBlock");
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(shader.ID, blockIndex, MATERIAL_BLOCK_BINDING);
+
+	bindings.push_back(binding);
+	lastBinding = bindings.size() - 1;
+	return bindings.back();
+}
+
+unsigned int Material::bind(const Shader& shader, unsigned int* boundTextures) const
+{
+	const ShaderBinding& binding = resolve(shader);
+
+	unsigned int binds = 0;
+	for (unsigned int i = 0; i < MATERIAL_SLOT_COUNT; i++) {
+		if (textures[i] == 0) continue;
+		shader.set(binding.samplers[i], static_cast<int>(i));
+		if (boundTextures && boundTextures[i] == textures[i]) continue;
+		glstate::ActiveTexture(GL_TEXTURE0 + i);
+		glstate::BindTexture(GL_TEXTURE_2D, textures[i]);
+		if (boundTextures) boundTextures[i] = textures[i];
+		binds++;
+	}
+	if (binds > 0 || !boundTextures)
+		glstate::ActiveTexture(GL_TEXTURE0);
+
+	if (block != 0)
+		glstate::BindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, block, blockOffset, sizeof(MaterialParams));
+
+	BindStats& stats = bindStats();
+	stats.binds++;
+	stats.textureBinds += binds;
+	return binds;
+}
+
+Material::BindStats& Material::bindStats()
+{
+	static BindStats stats;
+	return stats;
+}
+
+void Material::printBindStats(unsigned int frameCount)
+{
+	BindStats& stats = bindStats();
+	if (frameCount > 0) {
+		unsigned long long allocations = allocstats::count();
+		std::cout << "material binds per frame: " << stats.binds / frameCount << " binds, " << stats.textureBinds / frameCount
+			<< " texture binds, " << allocations / frameCount << " heap allocations in the whole frame (" << allocations << " total)" << std::endl;
+	}
+	stats = BindStats();
+	allocstats::reset();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+
+// uniform block binding point MaterialBlock is bound to
+constexpr unsigned int MATERIAL_BLOCK_BINDING = 2;
+
+// fixed texture slots, a slot's texture always goes to the unit with the same number
+enum class MaterialSlot { Diffuse, Specular, Normal, Count };
+constexpr unsigned int MATERIAL_SLOT_COUNT = static_cast<unsigned int>(MaterialSlot::Count);
+
+// scalar parameters laid out like the std140 MaterialBlock in the shaders
+struct MaterialParams {
+	glm::vec4 diffuseColor = glm::vec4(1.0f);
+	glm::vec4 specularColor = glm::vec4(1.0f);
+	float shininess = 32.0f;
+	float opacity = 1.0f;
+	float pad[2] = { 0.0f, 0.0f };
+};
+static_assert(sizeof(MaterialParams) == 48, "MaterialParams has to match the std140 MaterialBlock");
+
+// texture ids per slot and parameters, built once at import. sampler handles and the block index are resolved
+// the first time a shader binds the material, after that binding it is integer indexed calls only.
+class Material {
+public:
+	// slot of a "texture_diffuse" style type name, false for types without one
+	static bool slotForType(const std::string& type, MaterialSlot& slot);
+
+	void setTexture(MaterialSlot slot, unsigned int id) { textures[static_cast<unsigned int>(slot)] = id; }
+	unsigned int getTexture(MaterialSlot slot) const { return textures[static_cast<unsigned int>(slot)]; }
+	void setParams(const MaterialParams& params) { this->params = params; }
+	const MaterialParams& getParams() const { return params; }
+	// range of a uniform buffer the owner filled with params, buffer 0 for none
+	void setBlock(GLuint buffer, GLintptr offset) { block = buffer; blockOffset = offset; }
+
+	// resolves shader ahead of its first bind so not even that frame builds names
+	void prepare(const Shader& shader) const { resolve(shader); }
+	// sampler uniforms, textures and the parameter block. boundTextures, one id per unit from 0, lets units
+	// already holding the right texture be skipped and is updated. returns the textures bound.
+	unsigned int bind(const Shader& shader, unsigned int* boundTextures = nullptr) const;
+
+	// material binds since the last reset
+	struct BindStats {
+		unsigned long long binds = 0;
+		unsigned long long textureBinds = 0;
+	};
+	static BindStats& bindStats();
+	// prints the per frame averages over frameCount frames next to the heap allocations allocstats counted
+	// over the same frames, then resets both
+	static void printBindStats(unsigned int frameCount);
+
+private:
+	struct ShaderBinding {
+		unsigned int program;
+		UniformHandle<int> samplers[MATERIAL_SLOT_COUNT];
+	};
+
+	unsigned int textures[MATERIAL_SLOT_COUNT] = {};
+	MaterialParams params;
+	GLuint block = 0;
+	GLintptr blockOffset = 0;
+	// one per shader this material was bound with, usually one or two
+	mutable std::vector<ShaderBinding> bindings;
+	mutable size_t lastBinding = 0;
+
+	const ShaderBinding& resolve(const Shader& shader) const;
+};
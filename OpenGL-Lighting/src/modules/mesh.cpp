@@ -1,99 +1,314 @@
 #include "mesh.h"
+#include "gl_state.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshTexture> textures)
+#include <cmath>
+
+LODView::LODView(const glm::vec3& cameraPos, float fovDegrees, float viewportHeight, float maxPixelError)
+	: cameraPos(cameraPos), maxPixelError(maxPixelError)
+{
+	pixelsPerUnit = viewportHeight / (2.0f * tanf(glm::radians(fovDegrees) * 0.5f));
+}
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshTexture> textures, VertexLayout layout,
+	std::vector<MeshLOD> lods)
+	: layout(layout), lods(lods)
 {
 	this->vertices = vertices;
 	this->indices = indices;
 	this->textures = textures;
+	updateMaterialTextures();
 	
-	setupMesh();
+	setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+}
+
+Mesh::Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<MeshTexture> textures,
+	VertexLayout layout, std::vector<MeshLOD> lods)
+	: layout(layout), lods(lods)
+{
+	this->textures = textures;
+	updateMaterialTextures();
+
+	setupMesh(vertices, vertexCount, indices, indexCount);
+}
+
+Mesh::Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<MeshTexture> textures,
+	const MeshBufferRange& buffers, std::vector<MeshLOD> lods)
+	: layout(buffers.layout), lods(lods)
+{
+	this->textures = textures;
+	updateMaterialTextures();
+
+	setupMesh(vertices, vertexCount, indices, indexCount, &buffers);
 }
 
 void Mesh::Draw(Shader& shader)
 {
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	for (unsigned int i = 0; i < textures.size(); i++) {
-		glActiveTexture(GL_TEXTURE0 + i);
-		std::string number;
-		std::string name = textures[i].type;
+	drawLevel(shader, 0);
+}
 
-		if (name == "texture_diffuse") number = std::to_string(diffuseNr);
-		else if (name == "texture_specular") number = std::to_string(specularNr);
-		else if (name == "texture_normal") number = std::to_string(normalNr);
+void Mesh::Draw(Shader& shader, const glm::mat4& model, const LODView& view)
+{
+	drawLevel(shader, selectLOD(model, view));
+}
 
-		shader.setInt(("material." + name + number).c_str(), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+unsigned int Mesh::bindMaterial(Shader& shader, unsigned int* boundTextures) const
+{
+	unsigned int binds = material.bind(shader, boundTextures);
+	if (layout != VertexLayout::Standard) {
+		shader.setVec3("positionOffset", dequant.offset);
+		shader.setVec3("positionScale", dequant.scale);
 	}
-	glActiveTexture(GL_TEXTURE0);
+	return binds;
+}
+
+void Mesh::drawLevel(Shader& shader, unsigned int level)
+{
+	bindMaterial(shader);
+
+	const MeshLOD& lod = lods[level];
+	DrawStats& stats = drawStats();
+	stats.triangles += lod.indexCount / 3;
+	stats.draws++;
 
 	// draw mesh
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	glstate::BindVertexArray(VAO);
+	glDrawElementsBaseVertex(GL_TRIANGLES, lod.indexCount, indexType, (void*)((firstIndex + lod.indexOffset) * indexSize()), baseVertex);
+	glstate::BindVertexArray(0);
 }
 
 void Mesh::DrawInstanced(Shader& shader, unsigned int count)
 {
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		std::string number;
-		std::string name = textures[i].type;
-
-		if (name == "texture_diffuse") number = std::to_string(diffuseNr);
-		else if (name == "texture_specular") number = std::to_string(specularNr);
-		else if (name == "texture_normal") number = std::to_string(normalNr);
-
-		shader.setFloat(("material." + name + number).c_str(), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
-	}
-	glActiveTexture(GL_TEXTURE0);
+	bindMaterial(shader);
+
+	DrawStats& stats = drawStats();
+	stats.triangles += static_cast<unsigned long long>(lods[0].indexCount / 3) * count;
+	stats.draws++;
 
 	// draw mesh
-	glBindVertexArray(VAO);
-	glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, count);
-	glBindVertexArray(0);
+	glstate::BindVertexArray(VAO);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lods[0].indexCount, indexType, (void*)((firstIndex + lods[0].indexOffset) * indexSize()), count, baseVertex);
+	glstate::BindVertexArray(0);
+}
+
+void Mesh::DrawInstanced(Shader& shader, InstanceBuffer& instances)
+{
+	if (instances.size() == 0) return;
+	instances.upload();
+	glstate::BindVertexArray(VAO);
+	instances.attach();
+	DrawInstanced(shader, static_cast<unsigned int>(instances.size()));
+}
+
+void Mesh::DrawCulled(Shader& shader, const MeshletCullView& view, MeshletCullStats* stats)
+{
+	if (meshlets.empty()) return;
+	meshlets.cull(view, meshletVisibility);
+
+	// meshlets are consecutive in the index buffer, so runs of visible ones become a single range
+	const std::vector<Meshlet>& clusters = meshlets.getMeshlets();
+	meshletCounts.clear();
+	meshletOffsets.clear();
+	unsigned long long triangles = 0, trianglesDrawn = 0;
+	bool previousVisible = false;
+	for (size_t m = 0; m < clusters.size(); m++) {
+		const Meshlet& meshlet = clusters[m];
+		triangles += meshlet.triangleCount;
+		bool visible = meshletVisibility[m] == MESHLET_VISIBLE;
+		if (visible) {
+			trianglesDrawn += meshlet.triangleCount;
+			if (previousVisible) {
+				meshletCounts.back() += meshlet.triangleCount * 3;
+			}
+			else {
+				meshletCounts.push_back(meshlet.triangleCount * 3);
+				meshletOffsets.push_back((const void*)((firstIndex + meshlet.indexOffset) * indexSize()));
+			}
+		}
+		else if (stats) {
+			if (meshletVisibility[m] == MESHLET_FRUSTUM_CULLED) stats->frustumCulled++;
+			else stats->coneCulled++;
+		}
+		previousVisible = visible;
+	}
+	if (stats) {
+		stats->meshlets += clusters.size();
+		stats->triangles += triangles;
+		stats->trianglesDrawn += trianglesDrawn;
+	}
+	if (meshletCounts.empty()) return;
+
+	bindMaterial(shader);
+	DrawStats& drawCounters = drawStats();
+	drawCounters.triangles += trianglesDrawn;
+	drawCounters.draws++;
+
+	glstate::BindVertexArray(VAO);
+	meshletBaseVertices.assign(meshletCounts.size(), baseVertex);
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, meshletCounts.data(), indexType, meshletOffsets.data(),
+		static_cast<GLsizei>(meshletCounts.size()), meshletBaseVertices.data());
+	glstate::BindVertexArray(0);
 }
 
-void Mesh::setupMesh()
+unsigned int Mesh::selectLOD(const glm::mat4& model, const LODView& view) const
 {
+	if (lods.size() < 2 || boundsRadius <= 0.0f) return 0;
+
+	// largest axis scale keeps the sphere conservative under non-uniform scaling
+	float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	glm::vec3 center = glm::vec3(model * glm::vec4(boundsCenter, 1.0f));
+	float radius = boundsRadius * scale;
+	float distance = glm::length(center - view.cameraPos) - radius;
+	if (distance <= 0.0f) return 0;
+
+	// error of a level as a fraction of the radius times the radius in pixels
+	float projectedRadius = radius * view.pixelsPerUnit / distance;
+	unsigned int level = 0;
+	for (unsigned int i = 1; i < lods.size(); i++) {
+		float pixelError = lods[i].error / boundsRadius * projectedRadius;
+		if (pixelError > view.maxPixelError) break;
+		level = i;
+	}
+	return level;
+}
+
+Mesh::DrawStats& Mesh::drawStats()
+{
+	static DrawStats stats;
+	return stats;
+}
+
+void Mesh::printDrawStats(unsigned int frameCount)
+{
+	DrawStats& stats = drawStats();
+	if (frameCount > 0)
+		std::cout << "mesh draws per frame: " << stats.draws / frameCount << " calls, " << stats.triangles / frameCount << " triangles" << std::endl;
+	stats = DrawStats();
+}
+
+void Mesh::updateMaterialTextures()
+{
+	for (unsigned int i = 0; i < MATERIAL_SLOT_COUNT; i++)
+		material.setTexture(static_cast<MaterialSlot>(i), 0);
+	// later textures of a type have no slot, they were never sampled either
+	for (auto it = textures.rbegin(); it != textures.rend(); ++it) {
+		MaterialSlot slot;
+		if (Material::slotForType(it->type, slot))
+			material.setTexture(slot, it->id);
+	}
+}
+
+void Mesh::setupMesh(const Vertex* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount,
+	const MeshBufferRange* shared)
+{
+	this->indexCount = indexCount;
+	if (lods.empty())
+		lods.push_back({ 0, indexCount, 0.0f });
+
+	// box for frustum culling, and a sphere around its center, close enough to the minimal one for LOD selection
+	if (vertexCount > 0) {
+		boundsMin = boundsMax = vertexData[0].Position;
+		for (unsigned int i = 1; i < vertexCount; i++) {
+			boundsMin = glm::min(boundsMin, vertexData[i].Position);
+			boundsMax = glm::max(boundsMax, vertexData[i].Position);
+		}
+		boundsCenter = (boundsMin + boundsMax) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (unsigned int i = 0; i < vertexCount; i++) {
+			glm::vec3 offset = vertexData[i].Position - boundsCenter;
+			radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+		}
+		boundsRadius = sqrtf(radiusSquared);
+		meshlets.build(vertexData, vertexCount, indexData, lods[0].indexOffset, lods[0].indexCount);
+	}
+
+	if (shared) {
+		VAO = shared->VAO;
+		indexType = shared->indexType;
+		baseVertex = shared->baseVertex;
+		firstIndex = shared->firstIndex;
+		dequant = shared->dequant;
+		vertexBufferBytes = vertexCount * vertexLayoutStride(layout);
+		indexBufferBytes = indexCount * indexSize();
+		return;
+	}
+
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 
-	glBindVertexArray(VAO);
+	glstate::BindVertexArray(VAO);
+
+	glstate::BindBuffer(GL_ARRAY_BUFFER, VBO);
+	vertexBufferBytes = vertexCount * vertexLayoutStride(layout);
+	if (layout == VertexLayout::Standard)
+		glBufferData(GL_ARRAY_BUFFER, vertexBufferBytes, vertexData, GL_STATIC_DRAW);
+	else {
+		std::vector<unsigned char> packed;
+		packVertices(vertexData, vertexCount, layout, packed, dequant);
+		glBufferData(GL_ARRAY_BUFFER, vertexBufferBytes, packed.data(), GL_STATIC_DRAW);
+	}
+
+	// 16-bit indices halve the index buffer for anything under 65536 vertices
+	glstate::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	if (vertexCount <= 65536) {
+		std::vector<unsigned short> shortIndices(indexData, indexData + indexCount);
+		indexType = GL_UNSIGNED_SHORT;
+		indexBufferBytes = indexCount * sizeof(unsigned short);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferBytes, shortIndices.data(), GL_STATIC_DRAW);
+	}
+	else {
+		indexType = GL_UNSIGNED_INT;
+		indexBufferBytes = indexCount * sizeof(unsigned int);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferBytes, indexData, GL_STATIC_DRAW);
+	}
+
+	setupVertexAttributes(layout);
+	glstate::BindVertexArray(0);
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+void Mesh::setupVertexAttributes(VertexLayout layout)
+{
+	if (layout == VertexLayout::Standard) {
+		// vertex positions
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		// vertex normals
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
 
-	// vertex positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+		// vertex texture coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 
-	// vertex normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		// vertex tangent
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
 
-	// vertex texture coords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+		// vertex bitangent
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+	}
+	else {
+		// same locations with COMPACT_VERTEX, the vertex shader decodes them and rebuilds the bitangent
+		GLsizei stride = static_cast<GLsizei>(vertexLayoutStride(layout));
+		bool quantized = layout == VertexLayout::CompactQuantized;
+		size_t attributes = quantized ? offsetof(QuantizedVertex, normal) : offsetof(CompactVertex, normal);
 
-	// vertex tangent
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+		// position, w holds the bitangent sign
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, quantized ? GL_SHORT : GL_FLOAT, quantized ? GL_TRUE : GL_FALSE, stride, (void*)0);
 
-	// vertex bitangent
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+		// octahedral normal
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)attributes);
 
-	glBindVertexArray(0);
+		// half float texture coords
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(attributes + 8));
 
+		// octahedral tangent
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)(attributes + 4));
+	}
 }
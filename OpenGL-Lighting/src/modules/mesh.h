@@ -8,6 +8,10 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shader.h"
+#include "vertex_format.h"
+#include "meshlet.h"
+#include "instance_buffer.h"
+#include "material.h"
 
 struct Vertex {
 	glm::vec3 Position;
@@ -23,19 +27,130 @@ struct MeshTexture {
 	std::string path;
 };
 
+// one level of detail, a range of the mesh's index buffer. level 0 is the full mesh.
+struct MeshLOD {
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	float error; // object space distance the simplified surface may be off by
+};
+
+// what LOD selection needs to know about the view
+struct LODView {
+	glm::vec3 cameraPos = glm::vec3(0.0f);
+	float pixelsPerUnit = 0.0f; // pixels covered by one unit at distance one: viewportHeight / (2 tan(fov / 2))
+	float maxPixelError = 1.0f; // coarsest level whose error stays under this many pixels wins
+
+	LODView() = default;
+	LODView(const glm::vec3& cameraPos, float fovDegrees, float viewportHeight, float maxPixelError = 1.0f);
+};
+
+// where a mesh lives inside a vertex/index buffer pair shared with other meshes (see Model)
+struct MeshBufferRange {
+	unsigned int VAO = 0;
+	VertexLayout layout = VertexLayout::Standard;
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLint baseVertex = 0;      // added to every index
+	uint32_t firstIndex = 0;   // start of the mesh's indices, in indices
+	PositionDequant dequant;   // shared by every mesh in the buffer
+};
+
 class Mesh {
 public:
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indices;
 	std::vector<MeshTexture> textures;
 
-	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshTexture> textures);
+	// the cpu-side vertices and indices are always kept in the standard format, layout only changes what is uploaded.
+	// indices hold every level in lods back to back, no lods means a single level over all of them.
+	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshTexture> textures,
+		VertexLayout layout = VertexLayout::Standard, std::vector<MeshLOD> lods = std::vector<MeshLOD>());
+	// uploads straight from external memory (e.g. a mapped mesh cache) without keeping a cpu-side copy
+	Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<MeshTexture> textures,
+		VertexLayout layout = VertexLayout::Standard, std::vector<MeshLOD> lods = std::vector<MeshLOD>());
+	// draws out of buffers someone else uploaded and owns, vertices and indices are only read for bounds and meshlets
+	Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<MeshTexture> textures,
+		const MeshBufferRange& buffers, std::vector<MeshLOD> lods = std::vector<MeshLOD>());
+	// full detail
 	void Draw(Shader& shader);
+	// level picked by selectLOD for this model matrix
+	void Draw(Shader& shader, const glm::mat4& model, const LODView& view);
 	void DrawInstanced(Shader& shader, unsigned int count);
+	// one instance per entry of instances, uploads its dirty ranges first
+	void DrawInstanced(Shader& shader, InstanceBuffer& instances);
+	// full detail minus the meshlets outside the frustum or facing away from it, one glMultiDrawElements
+	void DrawCulled(Shader& shader, const MeshletCullView& view, MeshletCullStats* stats = nullptr);
+
+	// coarsest level whose error, scaled by the projected size of the bounding sphere, is within view.maxPixelError.
+	// level 0 while the camera is inside the sphere.
+	unsigned int selectLOD(const glm::mat4& model, const LODView& view) const;
+	const std::vector<MeshLOD>& getLODs() const { return lods; }
+	// object space bounds over every vertex
+	glm::vec3 getBoundsMin() const { return boundsMin; }
+	glm::vec3 getBoundsMax() const { return boundsMax; }
+	glm::vec3 getBoundsCenter() const { return boundsCenter; }
+	float getBoundsRadius() const { return boundsRadius; }
+	// clusters of level 0
+	const MeshletSet& getMeshlets() const { return meshlets; }
+
+	// material and dequantization uniforms, the part of a draw that is the same for every range of this mesh.
+	// boundTextures as for Material::bind, returns the textures bound.
+	unsigned int bindMaterial(Shader& shader, unsigned int* boundTextures = nullptr) const;
+	// built from textures, the first texture of each type fills its slot
+	const Material& getMaterial() const { return material; }
+	Material& getMaterial() { return material; }
+	// picks up changed ids in textures, e.g. streamed ones replacing the placeholder
+	void updateMaterialTextures();
+
+	// attribute pointers for layout into the bound VAO, reading from the bound GL_ARRAY_BUFFER
+	static void setupVertexAttributes(VertexLayout layout);
+
+	// triangles and draw calls submitted through every Mesh since the last reset
+	struct DrawStats {
+		unsigned long long triangles = 0;
+		unsigned long long draws = 0;
+	};
+	static DrawStats& drawStats();
+	// prints the per frame averages over frameCount frames and resets the counters
+	static void printDrawStats(unsigned int frameCount);
 
 	const std::vector<unsigned int>& getIndices() const { return indices; }
+	unsigned int getIndexCount() const { return indexCount; }
 	unsigned int getVAO() const { return VAO; }
+	GLint getBaseVertex() const { return baseVertex; }
+	uint32_t getFirstIndex() const { return firstIndex; }
+	VertexLayout getLayout() const { return layout; }
+	// GL_UNSIGNED_SHORT whenever every index fits
+	GLenum getIndexType() const { return indexType; }
+	// sizes of the uploaded buffers
+	size_t getVertexBufferBytes() const { return vertexBufferBytes; }
+	size_t getIndexBufferBytes() const { return indexBufferBytes; }
 private:
-	unsigned int VAO, VBO, EBO;
-	void setupMesh();
+	unsigned int VAO = 0, VBO = 0, EBO = 0; // VBO/EBO stay 0 for shared buffers
+	unsigned int indexCount;
+	VertexLayout layout;
+	PositionDequant dequant;
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLint baseVertex = 0;
+	uint32_t firstIndex = 0;
+	size_t vertexBufferBytes = 0;
+	size_t indexBufferBytes = 0;
+	std::vector<MeshLOD> lods;
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	float boundsRadius = 0.0f;
+
+	MeshletSet meshlets;
+	// per draw scratch for DrawCulled
+	std::vector<unsigned char> meshletVisibility;
+	std::vector<GLsizei> meshletCounts;
+	std::vector<const void*> meshletOffsets;
+	std::vector<GLint> meshletBaseVertices;
+
+	void drawLevel(Shader& shader, unsigned int level);
+	Material material;
+	// uploads its own buffers unless shared is given
+	void setupMesh(const Vertex* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount,
+		const MeshBufferRange* shared = nullptr);
+	size_t indexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int); }
 };
\ No newline at end of file
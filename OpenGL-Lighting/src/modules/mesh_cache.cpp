@@ -0,0 +1,260 @@
+#include "mesh_cache.h"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+static const char MESH_CACHE_MAGIC[4] = { 'O', 'G', 'L', 'M' };
+
+static size_t alignTo4(size_t offset)
+{
+	return (offset + 3) & ~static_cast<size_t>(3);
+}
+
+static void writePadding(std::ofstream& out, size_t& offset)
+{
+	static const char zeros[4] = { 0, 0, 0, 0 };
+	size_t aligned = alignTo4(offset);
+	out.write(zeros, aligned - offset);
+	offset = aligned;
+}
+
+std::string MeshCache::cachePathFor(const std::string& sourcePath)
+{
+	return sourcePath + ".meshcache";
+}
+
+uint64_t MeshCache::hashFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return 0;
+
+	uint64_t hash = 14695981039346656037ull;
+	char buffer[64 * 1024];
+	while (file) {
+		file.read(buffer, sizeof(buffer));
+		std::streamsize count = file.gcount();
+		for (std::streamsize i = 0; i < count; i++) {
+			hash ^= static_cast<unsigned char>(buffer[i]);
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+bool MeshCache::write(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, const std::vector<CachedMesh>& meshes,
+	const NodeHierarchy& nodes)
+{
+	// write to a temporary file first so a crash mid-write never leaves a valid looking cache behind
+	std::string tempPath = cachePath + ".tmp";
+	std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "ERROR::MESH_CACHE::Could not write " << cachePath << std::endl;
+		return false;
+	}
+
+	MeshCacheHeader header = {};
+	std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.importFlags = importFlags;
+	header.vertexSize = sizeof(Vertex);
+	header.meshCount = static_cast<uint32_t>(meshes.size());
+	header.nodeCount = static_cast<uint32_t>(nodes.size());
+
+	// lay out the blobs before writing so the entry table can be written in one go
+	std::vector<MeshCacheEntry> entries(meshes.size());
+	size_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * meshes.size();
+	for (uint32_t n = 0; n < nodes.size(); n++)
+		offset = alignTo4(offset + sizeof(MeshCacheNode) + nodes.getName(n).size());
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const CachedMesh& mesh = meshes[i];
+		MeshCacheEntry& entry = entries[i];
+		entry = {};
+		entry.vertexCount = static_cast<uint32_t>(mesh.vertexCount);
+		entry.indexCount = static_cast<uint32_t>(mesh.indexCount);
+		entry.textureCount = static_cast<uint32_t>(mesh.textures.size());
+		entry.lodCount = static_cast<uint32_t>(mesh.lods.size());
+		entry.node = mesh.node;
+		entry.material = mesh.material;
+
+		offset = alignTo4(offset);
+		entry.vertexOffset = offset;
+		offset += mesh.vertexCount * sizeof(Vertex);
+
+		offset = alignTo4(offset);
+		entry.indexOffset = offset;
+		offset += mesh.indexCount * sizeof(unsigned int);
+
+		offset = alignTo4(offset);
+		entry.lodOffset = offset;
+		offset += mesh.lods.size() * sizeof(MeshLOD);
+
+		offset = alignTo4(offset);
+		entry.textureOffset = offset;
+		for (const MeshTexture& texture : mesh.textures) {
+			offset += 2 * sizeof(uint32_t) + texture.type.size() + texture.path.size();
+			offset = alignTo4(offset);
+		}
+	}
+
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(entries.data()), sizeof(MeshCacheEntry) * entries.size());
+	offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * entries.size();
+
+	for (uint32_t n = 0; n < nodes.size(); n++) {
+		MeshCacheNode node;
+		std::memcpy(node.local, &nodes.getLocal(n)[0][0], sizeof(node.local));
+		node.parent = nodes.getParent(n);
+		node.nameLength = static_cast<uint32_t>(nodes.getName(n).size());
+		out.write(reinterpret_cast<const char*>(&node), sizeof(node));
+		out.write(nodes.getName(n).data(), node.nameLength);
+		offset += sizeof(node) + node.nameLength;
+		writePadding(out, offset);
+	}
+
+	for (const CachedMesh& mesh : meshes) {
+		writePadding(out, offset);
+		out.write(reinterpret_cast<const char*>(mesh.vertices), mesh.vertexCount * sizeof(Vertex));
+		offset += mesh.vertexCount * sizeof(Vertex);
+
+		writePadding(out, offset);
+		out.write(reinterpret_cast<const char*>(mesh.indices), mesh.indexCount * sizeof(unsigned int));
+		offset += mesh.indexCount * sizeof(unsigned int);
+
+		writePadding(out, offset);
+		out.write(reinterpret_cast<const char*>(mesh.lods.data()), mesh.lods.size() * sizeof(MeshLOD));
+		offset += mesh.lods.size() * sizeof(MeshLOD);
+
+		writePadding(out, offset);
+		for (const MeshTexture& texture : mesh.textures) {
+			uint32_t lengths[2] = { static_cast<uint32_t>(texture.type.size()), static_cast<uint32_t>(texture.path.size()) };
+			out.write(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+			out.write(texture.type.data(), texture.type.size());
+			out.write(texture.path.data(), texture.path.size());
+			offset += sizeof(lengths) + texture.type.size() + texture.path.size();
+			writePadding(out, offset);
+		}
+	}
+
+	out.close();
+	if (!out) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::remove(cachePath.c_str());
+	if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::open(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags)
+{
+	close();
+	if (!file.open(cachePath)) return false;
+
+	const unsigned char* base = file.data();
+	size_t size = file.size();
+
+	if (size < sizeof(MeshCacheHeader)) {
+		close();
+		return false;
+	}
+
+	MeshCacheHeader header;
+	std::memcpy(&header, base, sizeof(header));
+	if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != MESH_CACHE_VERSION ||
+		header.sourceHash != sourceHash ||
+		header.importFlags != importFlags ||
+		header.vertexSize != sizeof(Vertex) ||
+		size < sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * static_cast<size_t>(header.meshCount)) {
+		close();
+		return false;
+	}
+
+	const MeshCacheEntry* entries = reinterpret_cast<const MeshCacheEntry*>(base + sizeof(MeshCacheHeader));
+
+	size_t nodeOffset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * static_cast<size_t>(header.meshCount);
+	for (uint32_t n = 0; n < header.nodeCount; n++) {
+		MeshCacheNode node;
+		if (nodeOffset + sizeof(node) > size) {
+			close();
+			return false;
+		}
+		std::memcpy(&node, base + nodeOffset, sizeof(node));
+		nodeOffset += sizeof(node);
+		if (nodeOffset + node.nameLength > size || node.parent >= static_cast<int32_t>(n)) {
+			close();
+			return false;
+		}
+
+		glm::mat4 local;
+		std::memcpy(&local[0][0], node.local, sizeof(node.local));
+		nodes.addNode(std::string(reinterpret_cast<const char*>(base + nodeOffset), node.nameLength), node.parent, local);
+		nodeOffset = alignTo4(nodeOffset + node.nameLength);
+	}
+
+	meshes.reserve(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++) {
+		const MeshCacheEntry& entry = entries[i];
+		if (entry.vertexOffset + static_cast<uint64_t>(entry.vertexCount) * sizeof(Vertex) > size ||
+			entry.indexOffset + static_cast<uint64_t>(entry.indexCount) * sizeof(unsigned int) > size ||
+			entry.lodOffset + static_cast<uint64_t>(entry.lodCount) * sizeof(MeshLOD) > size ||
+			entry.textureOffset > size ||
+			(entry.node >= header.nodeCount && header.nodeCount > 0)) {
+			close();
+			return false;
+		}
+
+		CachedMesh mesh;
+		mesh.vertices = reinterpret_cast<const Vertex*>(base + entry.vertexOffset);
+		mesh.vertexCount = entry.vertexCount;
+		mesh.indices = reinterpret_cast<const unsigned int*>(base + entry.indexOffset);
+		mesh.indexCount = entry.indexCount;
+		mesh.node = entry.node;
+		mesh.material = entry.material;
+		const MeshLOD* lods = reinterpret_cast<const MeshLOD*>(base + entry.lodOffset);
+		mesh.lods.assign(lods, lods + entry.lodCount);
+		for (const MeshLOD& lod : mesh.lods) {
+			if (static_cast<uint64_t>(lod.indexOffset) + lod.indexCount > entry.indexCount) {
+				close();
+				return false;
+			}
+		}
+
+		size_t offset = static_cast<size_t>(entry.textureOffset);
+		for (uint32_t t = 0; t < entry.textureCount; t++) {
+			uint32_t lengths[2];
+			if (offset + sizeof(lengths) > size) {
+				close();
+				return false;
+			}
+			std::memcpy(lengths, base + offset, sizeof(lengths));
+			offset += sizeof(lengths);
+			if (offset + lengths[0] + lengths[1] > size) {
+				close();
+				return false;
+			}
+
+			MeshTexture texture;
+			texture.id = 0;
+			texture.type.assign(reinterpret_cast<const char*>(base + offset), lengths[0]);
+			texture.path.assign(reinterpret_cast<const char*>(base + offset + lengths[0]), lengths[1]);
+			mesh.textures.push_back(texture);
+			offset = alignTo4(offset + lengths[0] + lengths[1]);
+		}
+		meshes.push_back(mesh);
+	}
+	return true;
+}
+
+void MeshCache::close()
+{
+	meshes.clear();
+	nodes.clear();
+	file.close();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "mesh.h"
+#include "mapped_file.h"
+#include "node_hierarchy.h"
+
+// bump whenever Vertex, the file layout below or the import time processing changes so stale caches get rebuilt
+// 2: vertex cache / overdraw / vertex fetch optimization on import
+// 3: welded vertices, LOD levels appended to the indices plus a level table per mesh
+// 4: node tree, every mesh names the node it hangs off
+// 5: material parameters per mesh
+constexpr uint32_t MESH_CACHE_VERSION = 5;
+
+// file layout: header, one entry per mesh, the node table, then the vertex/index/lod/texture blobs the entries point at.
+// every blob starts on a 4 byte boundary so it can be handed to glBufferData straight from the mapping.
+struct MeshCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t importFlags;
+	uint32_t vertexSize;
+	uint32_t meshCount;
+	uint32_t nodeCount;
+};
+
+struct MeshCacheEntry {
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t textureOffset;
+	uint64_t lodOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount; // every level
+	uint32_t textureCount;
+	uint32_t lodCount;
+	uint32_t node;
+	uint32_t reserved;
+	MaterialParams material;
+};
+
+// one per node in depth first order, each followed by its name and padded to 4 bytes
+struct MeshCacheNode {
+	float local[16]; // column major
+	int32_t parent;
+	uint32_t nameLength;
+};
+
+// a mesh as it sits in the mapping, pointers are only valid while the owning MeshCache is open.
+// the importer hands its meshes to write() and Model in the same form.
+struct CachedMesh {
+	const Vertex* vertices;
+	unsigned int vertexCount;
+	const unsigned int* indices;
+	unsigned int indexCount;
+	std::vector<MeshLOD> lods;
+	std::vector<MeshTexture> textures; // type and path only, ids are resolved by the model
+	uint32_t node = 0;
+	MaterialParams material;
+};
+
+class MeshCache {
+public:
+	// cache lives next to the source asset, e.g. cyborg.obj -> cyborg.obj.meshcache
+	static std::string cachePathFor(const std::string& sourcePath);
+	// 64-bit FNV-1a of the file contents, 0 if the file can't be read
+	static uint64_t hashFile(const std::string& path);
+
+	static bool write(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags, const std::vector<CachedMesh>& meshes,
+		const NodeHierarchy& nodes);
+
+	// maps the cache and validates it against the source hash and import flags
+	bool open(const std::string& cachePath, uint64_t sourceHash, unsigned int importFlags);
+	void close();
+
+	const std::vector<CachedMesh>& getMeshes() const { return meshes; }
+	const NodeHierarchy& getNodes() const { return nodes; }
+
+private:
+	MappedFile file;
+	std::vector<CachedMesh> meshes;
+	NodeHierarchy nodes;
+};
@@ -0,0 +1,312 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+	// fifo post-transform cache. a vertex is resident while fewer than size misses happened since it was loaded.
+	struct FifoCache {
+		std::vector<unsigned int> loadedAt;
+		unsigned int size;
+		unsigned int misses = 0;
+
+		FifoCache(size_t vertexCount, unsigned int size) : loadedAt(vertexCount, 0), size(size) {}
+
+		void reset()
+		{
+			// pushes every entry out without touching the timestamps
+			misses += size + 1;
+		}
+
+		// true on a miss
+		bool access(unsigned int vertex)
+		{
+			if (loadedAt[vertex] != 0 && misses - loadedAt[vertex] < size)
+				return false;
+			misses++;
+			loadedAt[vertex] = misses;
+			return true;
+		}
+	};
+
+	struct VertexHash {
+		size_t operator()(const Vertex& vertex) const
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(Vertex); i++)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual {
+		bool operator()(const Vertex& a, const Vertex& b) const { return std::memcmp(&a, &b, sizeof(Vertex)) == 0; }
+	};
+
+	struct Cluster {
+		unsigned int begin;
+		unsigned int end;
+		float sortKey;
+	};
+}
+
+VertexCacheStats simulateVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3) return stats;
+
+	FifoCache cache(vertexCount, cacheSize);
+	std::vector<char> referenced(vertexCount, 0);
+	size_t transforms = 0, unique = 0;
+	for (size_t i = 0; i < indexCount; i++) {
+		if (cache.access(indices[i])) transforms++;
+		if (!referenced[indices[i]]) {
+			referenced[indices[i]] = 1;
+			unique++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(transforms) / static_cast<float>(indexCount / 3);
+	stats.atvr = unique > 0 ? static_cast<float>(transforms) / static_cast<float>(unique) : 0.0f;
+	return stats;
+}
+
+void optimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount,
+	unsigned int cacheSize, std::vector<unsigned int>* clusters)
+{
+	size_t triangleCount = indexCount / 3;
+
+	// triangles around every vertex, liveCount drops as they are emitted
+	std::vector<unsigned int> liveCount(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		liveCount[indices[i]]++;
+
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + liveCount[v];
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; t++) {
+		for (int k = 0; k < 3; k++)
+			adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+	}
+
+	std::vector<unsigned int> timestamps(vertexCount, 0);
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<unsigned int> deadEnd;
+	deadEnd.reserve(triangleCount * 3);
+	std::vector<unsigned int> candidates;
+	unsigned int time = cacheSize + 1;
+	size_t cursor = 0;
+	size_t written = 0;
+
+	// most recently touched vertex that still has triangles, then the first one in input order
+	auto skipDeadEnd = [&]() -> long long {
+		while (!deadEnd.empty()) {
+			unsigned int vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveCount[vertex] > 0) return vertex;
+		}
+		for (; cursor < vertexCount; cursor++) {
+			if (liveCount[cursor] > 0) return static_cast<long long>(cursor);
+		}
+		return -1;
+	};
+
+	if (clusters) clusters->push_back(0);
+	long long fanning = skipDeadEnd();
+	while (fanning >= 0) {
+		candidates.clear();
+		for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+			unsigned int t = adjacency[a];
+			if (emitted[t]) continue;
+
+			for (int k = 0; k < 3; k++) {
+				unsigned int vertex = indices[t * 3 + k];
+				destination[written++] = vertex;
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCount[vertex]--;
+				if (time - timestamps[vertex] > cacheSize)
+					timestamps[vertex] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// oldest candidate that stays in the cache while its remaining triangles are emitted
+		long long next = -1;
+		long long bestPriority = -1;
+		for (unsigned int vertex : candidates) {
+			if (liveCount[vertex] == 0) continue;
+
+			long long priority = 0;
+			if (time - timestamps[vertex] + 2 * liveCount[vertex] <= cacheSize)
+				priority = time - timestamps[vertex];
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		if (next < 0) {
+			next = skipDeadEnd();
+			if (clusters && next >= 0)
+				clusters->push_back(static_cast<unsigned int>(written));
+		}
+		fanning = next;
+	}
+}
+
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+	const std::vector<unsigned int>& clusters, float threshold, unsigned int cacheSize)
+{
+	indexCount -= indexCount % 3;
+	if (indexCount == 0 || clusters.empty()) return;
+
+	// soft boundaries: restart wherever the piece so far is already close to the ACMR of its whole cluster
+	std::vector<Cluster> pieces;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t c = 0; c < clusters.size(); c++) {
+		unsigned int begin = clusters[c];
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(indexCount);
+		if (begin >= end) continue;
+
+		cache.reset();
+		unsigned int missesBefore = cache.misses;
+		for (unsigned int i = begin; i < end; i++)
+			cache.access(indices[i]);
+		float clusterACMR = static_cast<float>(cache.misses - missesBefore) / ((end - begin) / 3);
+
+		cache.reset();
+		unsigned int pieceBegin = begin;
+		missesBefore = cache.misses;
+		for (unsigned int i = begin; i < end; i += 3) {
+			cache.access(indices[i]);
+			cache.access(indices[i + 1]);
+			cache.access(indices[i + 2]);
+
+			unsigned int pieceEnd = i + 3;
+			float pieceACMR = static_cast<float>(cache.misses - missesBefore) / ((pieceEnd - pieceBegin) / 3);
+			if (pieceEnd < end && pieceACMR <= clusterACMR * threshold) {
+				pieces.push_back({ pieceBegin, pieceEnd, 0.0f });
+				pieceBegin = pieceEnd;
+				cache.reset();
+				missesBefore = cache.misses;
+			}
+		}
+		pieces.push_back({ pieceBegin, end, 0.0f });
+	}
+
+	// area weighted centroid of the whole mesh
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for (size_t i = 0; i < indexCount; i += 3) {
+		const glm::vec3& a = vertices[indices[i]].Position;
+		const glm::vec3& b = vertices[indices[i + 1]].Position;
+		const glm::vec3& c = vertices[indices[i + 2]].Position;
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCenter += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	if (meshArea > 0.0f)
+		meshCenter /= meshArea;
+
+	// clusters facing away from the center are more likely to cover the rest
+	for (Cluster& piece : pieces) {
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (unsigned int i = piece.begin; i < piece.end; i += 3) {
+			const glm::vec3& a = vertices[indices[i]].Position;
+			const glm::vec3& b = vertices[indices[i + 1]].Position;
+			const glm::vec3& c = vertices[indices[i + 2]].Position;
+			glm::vec3 faceNormal = glm::cross(b - a, c - a);
+			float faceArea = glm::length(faceNormal);
+			center += (a + b + c) * (faceArea / 3.0f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+		if (area <= 0.0f) continue;
+
+		center /= area;
+		float normalLength = glm::length(normal);
+		if (normalLength > 0.0f)
+			piece.sortKey = glm::dot(center - meshCenter, normal / normalLength);
+	}
+
+	std::stable_sort(pieces.begin(), pieces.end(), [](const Cluster& a, const Cluster& b) {
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indexCount);
+	for (const Cluster& piece : pieces)
+		sorted.insert(sorted.end(), indices + piece.begin, indices + piece.end);
+	std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+	unique.reserve(vertices.size());
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<Vertex> welded;
+	welded.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		auto inserted = unique.emplace(vertices[i], static_cast<unsigned int>(welded.size()));
+		if (inserted.second)
+			welded.push_back(vertices[i]);
+		remap[i] = inserted.first->second;
+	}
+	for (unsigned int& index : indices)
+		index = remap[index];
+
+	vertices.swap(welded);
+	return vertices.size();
+}
+
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	const unsigned int unused = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), unused);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (unsigned int& index : indices) {
+		if (remap[index] == unused) {
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+	return vertices.size();
+}
+
+MeshOptimizeResult optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool reduceOverdraw)
+{
+	MeshOptimizeResult result;
+	result.verticesBefore = vertices.size();
+	result.before = simulateVertexCache(indices.data(), indices.size(), vertices.size());
+
+	// anything but a plain triangle list is left alone
+	if (indices.size() >= 3 && indices.size() % 3 == 0) {
+		std::vector<unsigned int> reordered(indices.size());
+		std::vector<unsigned int> clusters;
+		optimizeVertexCache(reordered.data(), indices.data(), indices.size(), vertices.size(),
+			VERTEX_CACHE_SIZE, reduceOverdraw ? &clusters : nullptr);
+		if (reduceOverdraw)
+			optimizeOverdraw(reordered.data(), reordered.size(), vertices.data(), vertices.size(), clusters);
+		indices.swap(reordered);
+		optimizeVertexFetch(vertices, indices);
+	}
+
+	result.verticesAfter = vertices.size();
+	result.after = simulateVertexCache(indices.data(), indices.size(), vertices.size());
+	return result;
+}
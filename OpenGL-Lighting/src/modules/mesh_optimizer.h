@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "mesh.h"
+
+// post-transform cache size the reordering targets and the simulator models by default
+constexpr unsigned int VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats {
+	float acmr = 0.0f; // vertices transformed per triangle: 3 means no reuse, ~0.5 is the limit for regular grids
+	float atvr = 0.0f; // vertices transformed per referenced vertex, 1 is ideal
+};
+
+// replays the triangles through a fifo cache of cacheSize entries, the way the tests in the
+// literature count transforms. doesn't need a gpu, so results can be checked anywhere.
+VertexCacheStats simulateVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// tipsify (Sander et al. 2007): fans around the most recently used vertices and falls back to a dead-end
+// stack. writes the reordered triangles to destination (must not alias indices). clusters, when given,
+// receives the index offset of every point where the walk had to jump and the cache restarts cold.
+void optimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount,
+	unsigned int cacheSize = VERTEX_CACHE_SIZE, std::vector<unsigned int>* clusters = nullptr);
+
+// splits the clusters further wherever the running ACMR is within threshold of the whole cluster, then sorts
+// them so triangles facing away from the mesh center draw first and hide the rest. threshold trades the
+// vertex cache gains for freedom to reorder, 1.0 keeps only the hard cluster boundaries.
+void optimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+	const std::vector<unsigned int>& clusters, float threshold = 1.05f, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// merges bitwise identical vertices (assimp emits one per face corner unless asked to join them) and
+// remaps indices, returns the new vertex count. the other passes only see reuse once this has run.
+size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// moves vertices into the order the indices first reference them and drops unreferenced ones,
+// returns the new vertex count
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+struct MeshOptimizeResult {
+	VertexCacheStats before;
+	VertexCacheStats after;
+	size_t verticesBefore = 0;
+	size_t verticesAfter = 0;
+};
+
+// vertex cache, overdraw (optional) and vertex fetch passes in that order, in place. the overdraw pass
+// raises ACMR by about 15% on the demo models, so it is left to fill rate bound meshes.
+MeshOptimizeResult optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool reduceOverdraw = false);
@@ -0,0 +1,281 @@
+#include "mesh_simplifier.h"
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+	// symmetric 4x4 plane quadric, error(p) = p^T A p + 2 b.p + c, summed over area weighted planes
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0, c = 0;
+		double weight = 0;
+
+		void addPlane(const glm::vec3& normal, float distance, double planeWeight)
+		{
+			double x = normal.x, y = normal.y, z = normal.z, d = distance;
+			a00 += planeWeight * x * x; a01 += planeWeight * x * y; a02 += planeWeight * x * z;
+			a11 += planeWeight * y * y; a12 += planeWeight * y * z; a22 += planeWeight * z * z;
+			b0 += planeWeight * x * d; b1 += planeWeight * y * d; b2 += planeWeight * z * d;
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void add(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02;
+			a11 += other.a11; a12 += other.a12; a22 += other.a22;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// weighted mean squared distance to the planes
+		double error(const glm::vec3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double value = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0.0 ? std::max(value, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		unsigned int from;
+		unsigned int to;
+		double cost;
+	};
+
+	struct PositionKey {
+		uint32_t bits[3];
+		bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct PositionKeyHash {
+		size_t operator()(const PositionKey& key) const
+		{
+			return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+		}
+	};
+
+	uint64_t edgeKey(unsigned int a, unsigned int b)
+	{
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	glm::vec3 faceNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		return glm::cross(b - a, c - a);
+	}
+}
+
+std::vector<unsigned int> simplifyMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, float* resultError)
+{
+	indexCount -= indexCount % 3;
+	std::vector<unsigned int> current(indices, indices + indexCount);
+	double appliedError = 0.0;
+
+	// vertices sharing a position form one group, a group with several members sits on a seam
+	std::vector<unsigned int> group(vertexCount);
+	std::vector<unsigned int> groupSize(vertexCount, 0);
+	{
+		std::unordered_map<PositionKey, unsigned int, PositionKeyHash> firstAt;
+		firstAt.reserve(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; v++) {
+			PositionKey key;
+			std::memcpy(key.bits, &vertices[v].Position, sizeof(key.bits));
+			auto inserted = firstAt.emplace(key, v);
+			group[v] = inserted.first->second;
+			groupSize[group[v]]++;
+		}
+	}
+
+	// edges used by a single triangle (open border) or more than two (non-manifold) pin their vertices
+	std::vector<char> locked(vertexCount, 0);
+	{
+		std::unordered_map<uint64_t, unsigned int> edgeUses;
+		edgeUses.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; i += 3) {
+			for (int k = 0; k < 3; k++)
+				edgeUses[edgeKey(group[current[i + k]], group[current[i + (k + 1) % 3]])]++;
+		}
+		for (const auto& edge : edgeUses) {
+			if (edge.second != 2) {
+				locked[static_cast<unsigned int>(edge.first >> 32)] = 1;
+				locked[static_cast<unsigned int>(edge.first & 0xffffffffu)] = 1;
+			}
+		}
+		for (unsigned int v = 0; v < vertexCount; v++) {
+			if (groupSize[group[v]] > 1 || locked[group[v]])
+				locked[v] = 1;
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indexCount; i += 3) {
+		const glm::vec3& a = vertices[current[i]].Position;
+		const glm::vec3& b = vertices[current[i + 1]].Position;
+		const glm::vec3& c = vertices[current[i + 2]].Position;
+		glm::vec3 normal = faceNormal(a, b, c);
+		float area = glm::length(normal);
+		if (area <= 0.0f) continue;
+		normal /= area;
+		for (int k = 0; k < 3; k++)
+			quadrics[group[current[i + k]]].addPlane(normal, -glm::dot(normal, a), area);
+	}
+
+	double maxErrorSquared = static_cast<double>(maxError) * maxError;
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<uint64_t> edges;
+	std::vector<Collapse> collapses;
+	std::vector<char> touched(vertexCount);
+	std::vector<unsigned int> remap(vertexCount);
+
+	while (current.size() > targetIndexCount) {
+		size_t triangleCount = current.size() / 3;
+
+		// triangles around every vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (unsigned int index : current)
+			adjacencyOffsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		adjacency.resize(current.size());
+		std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++) {
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[current[t * 3 + k]]++] = static_cast<unsigned int>(t);
+		}
+
+		edges.clear();
+		for (size_t i = 0; i < current.size(); i += 3) {
+			for (int k = 0; k < 3; k++)
+				edges.push_back(edgeKey(current[i + k], current[i + (k + 1) % 3]));
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		// cheaper direction of every edge that has a movable end
+		collapses.clear();
+		for (uint64_t edge : edges) {
+			unsigned int a = static_cast<unsigned int>(edge >> 32);
+			unsigned int b = static_cast<unsigned int>(edge & 0xffffffffu);
+			if (locked[a] && locked[b]) continue;
+
+			Quadric merged = quadrics[group[a]];
+			merged.add(quadrics[group[b]]);
+			double costToB = locked[a] ? -1.0 : merged.error(vertices[b].Position);
+			double costToA = locked[b] ? -1.0 : merged.error(vertices[a].Position);
+			if (costToA < 0.0 || (costToB >= 0.0 && costToB <= costToA))
+				collapses.push_back({ a, b, costToB });
+			else
+				collapses.push_back({ b, a, costToA });
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		// each collapse removes about two triangles, don't overshoot the target by much
+		size_t collapseGoal = std::max<size_t>((current.size() - targetIndexCount) / 6, 1);
+		size_t applied = 0;
+		std::fill(touched.begin(), touched.end(), 0);
+		for (unsigned int v = 0; v < vertexCount; v++)
+			remap[v] = v;
+
+		for (const Collapse& collapse : collapses) {
+			if (collapse.cost > maxErrorSquared || applied >= collapseGoal) break;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			// reject collapses that would flip a surviving triangle around the moving vertex
+			const glm::vec3& target = vertices[collapse.to].Position;
+			bool flips = false;
+			for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; a++) {
+				const unsigned int* triangle = &current[adjacency[a] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) continue;
+
+				glm::vec3 before[3], after[3];
+				for (int k = 0; k < 3; k++) {
+					before[k] = vertices[triangle[k]].Position;
+					after[k] = triangle[k] == collapse.from ? target : before[k];
+				}
+				glm::vec3 normalBefore = faceNormal(before[0], before[1], before[2]);
+				glm::vec3 normalAfter = faceNormal(after[0], after[1], after[2]);
+				if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+					flips = true;
+			}
+			if (flips) continue;
+
+			// the one-ring is frozen for the rest of the pass so the flip test above stays valid
+			for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++) {
+				const unsigned int* triangle = &current[adjacency[a] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+			}
+			touched[collapse.to] = 1;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[group[collapse.to]].add(quadrics[group[collapse.from]]);
+			appliedError = std::max(appliedError, collapse.cost);
+			applied++;
+		}
+		if (applied == 0) break;
+
+		size_t written = 0;
+		for (size_t i = 0; i < current.size(); i += 3) {
+			unsigned int a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+			if (a == b || b == c || a == c) continue;
+			current[written++] = a;
+			current[written++] = b;
+			current[written++] = c;
+		}
+		current.resize(written);
+	}
+
+	if (resultError)
+		*resultError = static_cast<float>(std::sqrt(appliedError));
+	return current;
+}
+
+std::vector<MeshLOD> buildLODChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const MeshLODParams& params)
+{
+	std::vector<MeshLOD> lods;
+	lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+	if (vertices.empty() || indices.size() < 3 || indices.size() % 3 != 0) return lods;
+
+	// same sphere Mesh selects with, so maxError scales with the mesh
+	glm::vec3 minimum = vertices[0].Position, maximum = vertices[0].Position;
+	for (const Vertex& vertex : vertices) {
+		minimum = glm::min(minimum, vertex.Position);
+		maximum = glm::max(maximum, vertex.Position);
+	}
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (const Vertex& vertex : vertices) {
+		glm::vec3 offset = vertex.Position - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	float maxError = params.maxError * std::sqrt(radiusSquared);
+
+	// every level starts over from the full mesh so its error is measured against the original surface
+	std::vector<unsigned int> full(indices);
+	size_t previousCount = full.size();
+	for (unsigned int level = 1; level < params.maxLevels; level++) {
+		size_t target = static_cast<size_t>(previousCount / 3 * params.reduction) * 3;
+		if (target / 3 < params.minTriangles) break;
+
+		float error = 0.0f;
+		std::vector<unsigned int> simplified = simplifyMesh(vertices.data(), vertices.size(), full.data(), full.size(), target, maxError, &error);
+		if (simplified.size() > previousCount * 85 / 100) break;
+
+		std::vector<unsigned int> ordered(simplified.size());
+		optimizeVertexCache(ordered.data(), simplified.data(), simplified.size(), vertices.size());
+
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(ordered.size()), std::max(error, lods.back().error) });
+		indices.insert(indices.end(), ordered.begin(), ordered.end());
+		previousCount = simplified.size();
+	}
+	return lods;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "mesh.h"
+
+// quadric error metric edge collapse (Garland and Heckbert 1997) that only collapses onto existing vertices,
+// so every simplified index list still indexes the original vertex buffer. vertices on open borders and
+// attribute seams (several vertices at one position) never move, the silhouette and uv layout stay intact.
+// stops at targetIndexCount or once the next collapse would move the surface more than maxError
+// (object space distance). resultError receives the largest error actually introduced.
+std::vector<unsigned int> simplifyMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+struct MeshLODParams {
+	unsigned int maxLevels = 5;     // including the full mesh
+	float reduction = 0.5f;         // triangle count of each level relative to the previous one
+	float maxError = 0.05f;         // fraction of the bounding radius a level may deviate by
+	unsigned int minTriangles = 32; // no level below this
+};
+
+// simplifies the full mesh down level by level and appends every level to indices, each one vertex cache
+// optimized on its own. returns the levels (the first covering the original indices), stops early once a
+// level can't get meaningfully smaller within the error bound.
+std::vector<MeshLOD> buildLODChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	const MeshLODParams& params = MeshLODParams());
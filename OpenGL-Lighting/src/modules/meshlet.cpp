@@ -0,0 +1,237 @@
+#include "meshlet.h"
+#include "mesh.h"
+#include "thread_pool.h"
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MESHLET_SSE2
+#endif
+
+void MeshletCullStats::print(unsigned int frameCount)
+{
+	if (frameCount > 0 && meshlets > 0) {
+		double saved = triangles > 0 ? 100.0 * (triangles - trianglesDrawn) / triangles : 0.0;
+		std::cout << name << " meshlets per frame: " << meshlets / frameCount << " tested, "
+			<< frustumCulled / frameCount << " frustum culled, " << coneCulled / frameCount << " cone culled, "
+			<< trianglesDrawn / frameCount << "/" << triangles / frameCount << " triangles drawn ("
+			<< static_cast<int>(saved) << "% saved)" << std::endl;
+	}
+	meshlets = frustumCulled = coneCulled = triangles = trianglesDrawn = 0;
+}
+
+MeshletCullView::MeshletCullView(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model, GLenum cullFace)
+{
+	glm::mat4 mvp = projection * view * model;
+	// the clip space planes pulled back through the whole transform land in object space
+	frustum = Frustum(mvp);
+
+	// the camera is the one point the projection sends to w = 0, unless it is at infinity (orthographic),
+	// then the same clip space vector comes back as the view direction
+	glm::vec4 camera = glm::inverse(mvp) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+	orthographic = std::abs(camera.w) <= 1e-6f * glm::length(glm::vec3(camera));
+	eye = orthographic ? glm::normalize(glm::vec3(camera)) : glm::vec3(camera) / camera.w;
+	facing = cullFace == GL_FRONT ? -1.0f : 1.0f;
+	coneCulling = cullFace != GL_FRONT_AND_BACK;
+}
+
+MeshletCullView MeshletCullView::transformed(const glm::mat4& local) const
+{
+	MeshletCullView result = *this;
+	result.frustum = frustum.transformed(local);
+	glm::mat4 inverseLocal = glm::inverse(local);
+	result.eye = orthographic ? glm::normalize(glm::vec3(inverseLocal * glm::vec4(eye, 0.0f))) : glm::vec3(inverseLocal * glm::vec4(eye, 1.0f));
+	return result;
+}
+
+void MeshletSet::build(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexOffset, size_t indexCount)
+{
+	meshlets.clear();
+	indexCount -= indexCount % 3;
+
+	// a vertex belongs to the current meshlet when its stamp matches the meshlet number
+	std::vector<unsigned int> stamp(vertexCount, ~0u);
+	Meshlet current = { static_cast<uint32_t>(indexOffset), 0, 0 };
+	for (size_t i = indexOffset; i < indexOffset + indexCount; i += 3) {
+		unsigned int id = static_cast<unsigned int>(meshlets.size());
+		unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		unsigned int added = (stamp[a] != id) + (stamp[b] != id && b != a) + (stamp[c] != id && c != a && c != b);
+
+		if (current.vertexCount + added > MESHLET_MAX_VERTICES || current.triangleCount == MESHLET_MAX_TRIANGLES) {
+			meshlets.push_back(current);
+			current = { static_cast<uint32_t>(i), 0, 0 };
+			id++;
+		}
+		for (int k = 0; k < 3; k++) {
+			if (stamp[indices[i + k]] != id) {
+				stamp[indices[i + k]] = id;
+				current.vertexCount++;
+			}
+		}
+		current.triangleCount++;
+	}
+	if (current.triangleCount > 0)
+		meshlets.push_back(current);
+
+	size_t padded = (meshlets.size() + 3) & ~static_cast<size_t>(3);
+	for (std::vector<float>* column : { &centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff })
+		column->assign(padded, 0.0f);
+	for (size_t m = meshlets.size(); m < padded; m++)
+		cutoff[m] = 1.0f;
+
+	for (size_t m = 0; m < meshlets.size(); m++) {
+		const Meshlet& meshlet = meshlets[m];
+		const unsigned int* triangles = indices + meshlet.indexOffset;
+		size_t count = meshlet.triangleCount * 3;
+
+		glm::vec3 minimum = vertices[triangles[0]].Position, maximum = minimum;
+		for (size_t i = 1; i < count; i++) {
+			minimum = glm::min(minimum, vertices[triangles[i]].Position);
+			maximum = glm::max(maximum, vertices[triangles[i]].Position);
+		}
+		glm::vec3 center = (minimum + maximum) * 0.5f;
+		float radiusSquared = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			glm::vec3 offset = vertices[triangles[i]].Position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		// cone around the mean face normal, its cutoff is the sine of the widest normal's angle to the axis
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.triangleCount);
+		glm::vec3 axis(0.0f);
+		for (size_t i = 0; i < count; i += 3) {
+			const glm::vec3& a = vertices[triangles[i]].Position;
+			glm::vec3 normal = glm::cross(vertices[triangles[i + 1]].Position - a, vertices[triangles[i + 2]].Position - a);
+			float length = glm::length(normal);
+			if (length <= 0.0f) continue;
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+		float axisLength = glm::length(axis);
+		float minimumDot = 1.0f;
+		if (axisLength > 0.0f) {
+			axis /= axisLength;
+			for (const glm::vec3& normal : normals)
+				minimumDot = std::min(minimumDot, glm::dot(axis, normal));
+		}
+
+		centerX[m] = center.x;
+		centerY[m] = center.y;
+		centerZ[m] = center.z;
+		radius[m] = std::sqrt(radiusSquared);
+		// past ~85 degrees of spread there is hardly a direction left that sees only back faces
+		if (normals.empty() || minimumDot <= 0.1f) {
+			cutoff[m] = 1.0f;
+		}
+		else {
+			axisX[m] = axis.x;
+			axisY[m] = axis.y;
+			axisZ[m] = axis.z;
+			cutoff[m] = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+	}
+}
+
+void MeshletSet::cull(const MeshletCullView& view, std::vector<unsigned char>& visibility) const
+{
+	size_t padded = centerX.size();
+	visibility.resize(padded);
+	size_t groups = padded / 4;
+	if (meshlets.size() >= MESHLET_PARALLEL_THRESHOLD) {
+		ThreadPool::shared().parallelFor(groups, [&](size_t begin, size_t end) {
+			cullRange(view, begin * 4, end * 4, visibility.data());
+		});
+	}
+	else {
+		cullRange(view, 0, padded, visibility.data());
+	}
+	visibility.resize(meshlets.size());
+}
+
+// the cone test is meshoptimizer's sphere form: the whole cluster faces away when
+// dot(center - eye, axis) >= cutoff * |center - eye| + radius. for an orthographic view only the direction matters.
+void MeshletSet::cullRange(const MeshletCullView& view, size_t begin, size_t end, unsigned char* visibility) const
+{
+	glm::vec3 eye = view.eye;
+	float facing = view.facing;
+	size_t m = begin;
+
+#ifdef MESHLET_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; p++) {
+		planeX[p] = _mm_set1_ps(view.frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(view.frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(view.frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(view.frustum.planes[p].w);
+	}
+	const __m128 eyeX = _mm_set1_ps(eye.x), eyeY = _mm_set1_ps(eye.y), eyeZ = _mm_set1_ps(eye.z);
+	const __m128 facing4 = _mm_set1_ps(facing);
+
+	for (; m + 4 <= end; m += 4) {
+		__m128 cx = _mm_loadu_ps(&centerX[m]), cy = _mm_loadu_ps(&centerY[m]), cz = _mm_loadu_ps(&centerZ[m]);
+		__m128 r = _mm_loadu_ps(&radius[m]);
+		__m128 negativeRadius = _mm_sub_ps(zero, r);
+
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+
+		__m128 backfacing = _mm_setzero_ps();
+		if (view.coneCulling) {
+			__m128 ax = _mm_mul_ps(_mm_loadu_ps(&axisX[m]), facing4);
+			__m128 ay = _mm_mul_ps(_mm_loadu_ps(&axisY[m]), facing4);
+			__m128 az = _mm_mul_ps(_mm_loadu_ps(&axisZ[m]), facing4);
+			__m128 c = _mm_loadu_ps(&cutoff[m]);
+			if (view.orthographic) {
+				__m128 alignment = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, eyeX), _mm_mul_ps(ay, eyeY)), _mm_mul_ps(az, eyeZ));
+				backfacing = _mm_cmpge_ps(alignment, c);
+			}
+			else {
+				__m128 dx = _mm_sub_ps(cx, eyeX), dy = _mm_sub_ps(cy, eyeY), dz = _mm_sub_ps(cz, eyeZ);
+				__m128 alignment = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, dx), _mm_mul_ps(ay, dy)), _mm_mul_ps(az, dz));
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+				backfacing = _mm_cmpge_ps(alignment, _mm_add_ps(_mm_mul_ps(c, length), r));
+			}
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		int backfacingMask = _mm_movemask_ps(backfacing);
+		for (int k = 0; k < 4; k++) {
+			visibility[m + k] = (outsideMask >> k) & 1 ? MESHLET_FRUSTUM_CULLED
+				: (backfacingMask >> k) & 1 ? MESHLET_CONE_CULLED : MESHLET_VISIBLE;
+		}
+	}
+#endif
+
+	for (; m < end; m++) {
+		glm::vec3 center(centerX[m], centerY[m], centerZ[m]);
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++)
+			outside = glm::dot(glm::vec3(view.frustum.planes[p]), center) + view.frustum.planes[p].w < -radius[m];
+		if (outside) {
+			visibility[m] = MESHLET_FRUSTUM_CULLED;
+			continue;
+		}
+
+		bool backfacing = false;
+		if (view.coneCulling) {
+			glm::vec3 axis = glm::vec3(axisX[m], axisY[m], axisZ[m]) * facing;
+			if (view.orthographic) {
+				backfacing = glm::dot(axis, eye) >= cutoff[m];
+			}
+			else {
+				glm::vec3 offset = center - eye;
+				backfacing = glm::dot(axis, offset) >= cutoff[m] * glm::length(offset) + radius[m];
+			}
+		}
+		visibility[m] = backfacing ? MESHLET_CONE_CULLED : MESHLET_VISIBLE;
+	}
+}
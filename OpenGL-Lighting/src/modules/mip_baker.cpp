@@ -0,0 +1,176 @@
+#include "mip_baker.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_BAKER_SSE2
+#endif
+
+namespace {
+	// linear -> sRGB goes through a table fine enough to stay exact after 8-bit rounding in the darks
+	const int LINEAR_TO_SRGB_STEPS = 16384;
+
+	// below this many destination pixels a level is filtered on the calling thread
+	const size_t PARALLEL_PIXEL_THRESHOLD = 16384;
+
+	struct SRGBTables {
+		float toLinear[256];
+		unsigned char toSRGB[LINEAR_TO_SRGB_STEPS + 1];
+
+		SRGBTables() {
+			for (int i = 0; i < 256; i++) {
+				float c = i / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i <= LINEAR_TO_SRGB_STEPS; i++) {
+				float l = static_cast<float>(i) / LINEAR_TO_SRGB_STEPS;
+				float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSRGB[i] = static_cast<unsigned char>(std::min(255.0f, c * 255.0f + 0.5f));
+			}
+		}
+	};
+
+	const SRGBTables& srgbTables()
+	{
+		static SRGBTables tables;
+		return tables;
+	}
+
+	struct LevelJob {
+		const float* source;
+		int sourceWidth, sourceHeight;
+		float* target;
+		unsigned char* encoded;
+		int width, height, channels;
+		int colorChannels; // leading channels stored as sRGB
+	};
+
+	void runRows(ThreadPool& pool, size_t rows, size_t pixels, const std::function<void(size_t, size_t)>& fn)
+	{
+		if (pixels < PARALLEL_PIXEL_THRESHOLD)
+			fn(0, rows);
+		else
+			pool.parallelFor(rows, fn);
+	}
+
+	void decodeRows(const unsigned char* pixels, const LevelJob& job, size_t begin, size_t end)
+	{
+		const SRGBTables& tables = srgbTables();
+		size_t rowValues = static_cast<size_t>(job.width) * job.channels;
+		for (size_t y = begin; y < end; y++) {
+			const unsigned char* in = pixels + y * rowValues;
+			float* out = job.target + y * rowValues;
+			for (size_t i = 0; i < rowValues; i++) {
+				int channel = static_cast<int>(i % job.channels);
+				out[i] = channel < job.colorChannels ? tables.toLinear[in[i]] : in[i] / 255.0f;
+			}
+		}
+	}
+
+	void encodeRow(const float* in, unsigned char* out, const LevelJob& job)
+	{
+		const SRGBTables& tables = srgbTables();
+		size_t rowValues = static_cast<size_t>(job.width) * job.channels;
+		for (size_t i = 0; i < rowValues; i++) {
+			float v = std::min(1.0f, std::max(0.0f, in[i]));
+			int channel = static_cast<int>(i % job.channels);
+			if (channel < job.colorChannels)
+				out[i] = tables.toSRGB[static_cast<int>(v * LINEAR_TO_SRGB_STEPS + 0.5f)];
+			else
+				out[i] = static_cast<unsigned char>(v * 255.0f + 0.5f);
+		}
+	}
+
+	void downsampleRows(const LevelJob& job, size_t begin, size_t end)
+	{
+		int channels = job.channels;
+		size_t sourceValues = static_cast<size_t>(job.sourceWidth) * channels;
+		size_t rowValues = static_cast<size_t>(job.width) * channels;
+		std::vector<float> rowSum(sourceValues);
+
+		for (size_t y = begin; y < end; y++) {
+			// odd sizes clamp, so the last row/column of an odd level is counted twice
+			int y0 = std::min(static_cast<int>(y) * 2, job.sourceHeight - 1);
+			int y1 = std::min(static_cast<int>(y) * 2 + 1, job.sourceHeight - 1);
+			const float* a = job.source + y0 * sourceValues;
+			const float* b = job.source + y1 * sourceValues;
+
+			// vertical pair sum over the whole interleaved row
+			size_t i = 0;
+#ifdef MIP_BAKER_SSE2
+			for (; i + 4 <= sourceValues; i += 4)
+				_mm_storeu_ps(&rowSum[i], _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+#endif
+			for (; i < sourceValues; i++)
+				rowSum[i] = a[i] + b[i];
+
+			// horizontal pair sum, one destination pixel at a time
+			float* out = job.target + y * rowValues;
+			for (int x = 0; x < job.width; x++) {
+				int x0 = std::min(x * 2, job.sourceWidth - 1);
+				int x1 = std::min(x * 2 + 1, job.sourceWidth - 1);
+				const float* p0 = &rowSum[x0 * channels];
+				const float* p1 = &rowSum[x1 * channels];
+				float* o = out + x * channels;
+#ifdef MIP_BAKER_SSE2
+				if (channels == 4) {
+					_mm_storeu_ps(o, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p0), _mm_loadu_ps(p1)), _mm_set1_ps(0.25f)));
+					continue;
+				}
+#endif
+				for (int c = 0; c < channels; c++)
+					o[c] = (p0[c] + p1[c]) * 0.25f;
+			}
+
+			encodeRow(out, job.encoded + y * rowValues, job);
+		}
+	}
+}
+
+MipChain bakeMipChain(const DecodedImage& image, TextureColorSpace space, ThreadPool& pool)
+{
+	MipChain chain;
+	if (!image.valid() || image.hdr) return chain;
+
+	chain.width = image.width;
+	chain.height = image.height;
+	chain.channels = image.channels;
+	chain.space = space;
+
+	int colorChannels = space == TextureColorSpace::sRGB && image.channels >= 3 ? 3 : 0;
+	size_t levelCount = 1;
+	while (chain.levelWidth(levelCount - 1) > 1 || chain.levelHeight(levelCount - 1) > 1)
+		levelCount++;
+
+	// level 0 is the source itself, every other level is filtered from the float copy of the one above
+	const unsigned char* pixels = static_cast<const unsigned char*>(image.data);
+	chain.levels.resize(levelCount);
+	chain.levels[0].assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * image.channels);
+
+	std::vector<float> source(chain.levels[0].size());
+	LevelJob top = { nullptr, 0, 0, source.data(), nullptr, image.width, image.height, image.channels, colorChannels };
+	runRows(pool, image.height, chain.levels[0].size(), [&](size_t begin, size_t end) {
+		decodeRows(pixels, top, begin, end);
+	});
+
+	std::vector<float> target;
+	for (size_t level = 1; level < levelCount; level++) {
+		int width = chain.levelWidth(level);
+		int height = chain.levelHeight(level);
+		size_t values = static_cast<size_t>(width) * height * image.channels;
+		target.resize(values);
+		chain.levels[level].resize(values);
+
+		LevelJob job = { source.data(), chain.levelWidth(level - 1), chain.levelHeight(level - 1),
+			target.data(), chain.levels[level].data(), width, height, image.channels, colorChannels };
+		runRows(pool, height, static_cast<size_t>(width) * height, [&](size_t begin, size_t end) {
+			downsampleRows(job, begin, end);
+		});
+
+		source.swap(target);
+	}
+
+	return chain;
+}
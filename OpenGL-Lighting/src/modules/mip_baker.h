@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+
+#include "utils.h"
+#include "thread_pool.h"
+
+// full mip chain of an 8-bit image, level 0 is the source. rows are tightly packed.
+struct MipChain {
+	int width = 0, height = 0, channels = 0;
+	TextureColorSpace space = TextureColorSpace::Linear;
+	std::vector<std::vector<unsigned char>> levels;
+
+	int levelWidth(size_t level) const { return width >> level > 0 ? width >> level : 1; }
+	int levelHeight(size_t level) const { return height >> level > 0 ? height >> level : 1; }
+};
+
+// builds every level down to 1x1 on the cpu with a 2x2 box filter. sRGB color channels are filtered
+// in linear space (alpha never is), rows of each level are split across the pool. ldr images only.
+MipChain bakeMipChain(const DecodedImage& image, TextureColorSpace space, ThreadPool& pool = ThreadPool::shared());
@@ -1,51 +1,477 @@
 #include "model.h"
-#include "../../stb/stb_image.h"
+#include "mesh_cache.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "baked_texture.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
 
-void Model::Draw(Shader& shader)
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+Model::~Model()
+{
+	TextureStreamer::instance().cancel(this);
+	for (const MeshTexture& texture : textures_loaded)
+		TextureCache::instance().release(texture.id);
+	glstate::DeleteVertexArrays(1, &VAO);
+	glstate::DeleteBuffers(1, &VBO);
+	glstate::DeleteBuffers(1, &EBO);
+	glstate::DeleteBuffers(1, &indirectBuffer);
+	glstate::DeleteBuffers(1, &materialBuffer);
+}
+
+void Model::drawBuckets(Shader& shader)
 {
-	for (unsigned int i = 0; i < meshes.size(); i++)
-		meshes[i].Draw(shader);
+	if (buckets.empty()) return;
+
+	glstate::BindVertexArray(VAO);
+	if (indirectBuffer)
+		glstate::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+	Mesh::DrawStats& stats = Mesh::drawStats();
+	for (const MaterialBucket& bucket : buckets) {
+		meshes[bucket.meshes.front()].bindMaterial(shader);
+		stats.triangles += bucket.triangles;
+		stats.draws++;
+
+		GLsizei drawCount = static_cast<GLsizei>(bucket.meshes.size());
+		if (indirectBuffer)
+			glext::MultiDrawElementsIndirect(GL_TRIANGLES, indexType, (const void*)bucket.indirectOffset, drawCount, 0);
+		else
+			glMultiDrawElementsBaseVertex(GL_TRIANGLES, bucket.counts.data(), indexType, bucket.offsets.data(), drawCount, bucket.baseVertices.data());
+	}
+
+	if (indirectBuffer)
+		glstate::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glstate::BindVertexArray(0);
+}
+
+void Model::drawNodes(Shader& shader, const glm::mat4& model, const unsigned char* visibility)
+{
+	glstate::BindVertexArray(VAO);
+	Mesh::DrawStats& stats = Mesh::drawStats();
+	int64_t currentNode = -1, currentBucket = -1;
+	for (const NodeDraw& draw : nodeDraws) {
+		const MaterialBucket& bucket = buckets[draw.bucket];
+		if (visibility && !visibility[bucket.meshes[draw.slot]]) continue;
+		if (draw.node != currentNode) {
+			shader.setModel(model * nodes.getWorld(draw.node));
+			currentNode = draw.node;
+		}
+		if (static_cast<int64_t>(draw.bucket) != currentBucket) {
+			meshes[bucket.meshes.front()].bindMaterial(shader);
+			currentBucket = static_cast<int64_t>(draw.bucket);
+		}
+		stats.triangles += bucket.counts[draw.slot] / 3;
+		stats.draws++;
+		glDrawElementsBaseVertex(GL_TRIANGLES, bucket.counts[draw.slot], indexType, const_cast<void*>(bucket.offsets[draw.slot]),
+			bucket.baseVertices[draw.slot]);
+	}
+	glstate::BindVertexArray(0);
+}
+
+void Model::Draw(Shader& shader, const Frustum& frustum, const glm::mat4& model, FrustumCullStats* stats)
+{
+	if (buckets.empty()) return;
+	updateNodes();
+
+	meshVisibility.resize(meshes.size());
+	size_t visible = cullBoxes(frustum.transformed(model), nodeTransforms ? nodeBounds : meshBounds, meshVisibility.data());
+	if (stats) {
+		stats->tested += meshes.size();
+		stats->culled += meshes.size() - visible;
+	}
+	if (visible == 0) return;
+	if (nodeTransforms) {
+		drawNodes(shader, model, meshVisibility.data());
+		return;
+	}
+
+	shader.setModel(model);
+	if (visible == meshes.size()) {
+		drawBuckets(shader);
+		return;
+	}
+
+	glstate::BindVertexArray(VAO);
+	Mesh::DrawStats& drawStats = Mesh::drawStats();
+	for (const MaterialBucket& bucket : buckets) {
+		visibleCounts.clear();
+		visibleOffsets.clear();
+		visibleBaseVertices.clear();
+		for (size_t j = 0; j < bucket.meshes.size(); j++) {
+			if (!meshVisibility[bucket.meshes[j]]) continue;
+			visibleCounts.push_back(bucket.counts[j]);
+			visibleOffsets.push_back(bucket.offsets[j]);
+			visibleBaseVertices.push_back(bucket.baseVertices[j]);
+			drawStats.triangles += bucket.counts[j] / 3;
+		}
+		if (visibleCounts.empty()) continue;
+
+		meshes[bucket.meshes.front()].bindMaterial(shader);
+		drawStats.draws++;
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, visibleCounts.data(), indexType, visibleOffsets.data(),
+			static_cast<GLsizei>(visibleCounts.size()), visibleBaseVertices.data());
+	}
+	glstate::BindVertexArray(0);
+}
+
+void Model::Draw(Shader& shader, const glm::mat4& model)
+{
+	updateNodes();
+	if (nodeTransforms) {
+		drawNodes(shader, model);
+		return;
+	}
+	shader.setModel(model);
+	drawBuckets(shader);
+}
+
+void Model::Draw(Shader& shader, const glm::mat4& model, const LODView& view)
+{
+	updateNodes();
+	if (!nodeTransforms)
+		shader.setModel(model);
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		if (nodeTransforms) {
+			glm::mat4 meshModel = model * nodes.getWorld(meshNodes[i]);
+			shader.setModel(meshModel);
+			meshes[i].Draw(shader, meshModel, view);
+		}
+		else {
+			meshes[i].Draw(shader, model, view);
+		}
+	}
+}
+
+void Model::updateNodes()
+{
+	if (!nodes.isDirty()) return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	nodeStats.recomputed += nodes.update();
+	nodeTransforms = false;
+	for (uint32_t node : meshNodes)
+		nodeTransforms = nodeTransforms || nodes.getWorld(node) != glm::mat4(1.0f);
+
+	// a box under a matrix is bounded by the box around the moved center with the extents
+	// projected through the absolute value of the matrix
+	nodeBounds.clear();
+	if (nodeTransforms) {
+		nodeBounds.reserve(meshes.size());
+		for (size_t i = 0; i < meshes.size(); i++) {
+			const glm::mat4& world = nodes.getWorld(meshNodes[i]);
+			glm::vec3 center = (meshes[i].getBoundsMin() + meshes[i].getBoundsMax()) * 0.5f;
+			glm::vec3 extent = (meshes[i].getBoundsMax() - meshes[i].getBoundsMin()) * 0.5f;
+			glm::vec3 movedCenter = glm::vec3(world * glm::vec4(center, 1.0f));
+			glm::vec3 movedExtent = glm::abs(glm::vec3(world[0])) * extent.x + glm::abs(glm::vec3(world[1])) * extent.y
+				+ glm::abs(glm::vec3(world[2])) * extent.z;
+			nodeBounds.add(movedCenter - movedExtent, movedCenter + movedExtent);
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	nodeStats.ms += std::chrono::duration<double, std::milli>(end - start).count();
+	nodeStats.updates++;
+}
+
+void Model::printNodeStats(unsigned int frameCount)
+{
+	if (frameCount > 0) {
+		std::cout << path << " nodes per frame: " << static_cast<double>(nodeStats.recomputed) / frameCount << " of " << nodes.size()
+			<< " recomputed in " << static_cast<double>(nodeStats.updates) / frameCount << " updates, "
+			<< nodeStats.ms / frameCount << " ms" << std::endl;
+	}
+	nodeStats = NodeStats();
+}
+
+void Model::DrawCulled(Shader& shader, const MeshletCullView& view, const glm::mat4& model, MeshletCullStats* stats)
+{
+	updateNodes();
+	if (!nodeTransforms)
+		shader.setModel(model);
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		if (nodeTransforms) {
+			const glm::mat4& world = nodes.getWorld(meshNodes[i]);
+			shader.setModel(model * world);
+			meshes[i].DrawCulled(shader, view.transformed(world), stats);
+		}
+		else {
+			meshes[i].DrawCulled(shader, view, stats);
+		}
+	}
 }
 
 void Model::DrawInstanced(Shader& shader, unsigned int count)
 {
-	for (unsigned int i = 0; i < meshes.size(); i++)
+	updateNodes();
+	for (unsigned int i = 0; i < meshes.size(); i++) {
+		shader.setMat4("nodeMatrix", nodeTransforms ? nodes.getWorld(meshNodes[i]) : glm::mat4(1.0f));
 		meshes[i].DrawInstanced(shader, count);
+	}
 }
 
-void Model::loadModel(std::string path)
+void Model::DrawInstanced(Shader& shader, InstanceBuffer& instances)
 {
-	Assimp::Importer import;
-	const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	if (buckets.empty() || instances.size() == 0) return;
+	updateNodes();
+	instances.upload();
 
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-		std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
-		return;
+	glstate::BindVertexArray(VAO);
+	instances.attach();
+
+	GLsizei count = static_cast<GLsizei>(instances.size());
+	Mesh::DrawStats& stats = Mesh::drawStats();
+	for (const MaterialBucket& bucket : buckets) {
+		meshes[bucket.meshes.front()].bindMaterial(shader);
+		stats.triangles += bucket.triangles * instances.size();
+		stats.draws += bucket.meshes.size();
+		for (size_t j = 0; j < bucket.meshes.size(); j++) {
+			shader.setMat4("nodeMatrix", nodeTransforms ? nodes.getWorld(meshNodes[bucket.meshes[j]]) : glm::mat4(1.0f));
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, bucket.counts[j], indexType, bucket.offsets[j], count, bucket.baseVertices[j]);
+		}
 	}
+	glstate::BindVertexArray(0);
+}
+
+void Model::loadModel(std::string path)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	this->path = path;
 	directory = path.substr(0, path.find_last_of('/'));
 
-	processNode(scene->mRootNode, scene);
+	std::string cachePath = MeshCache::cachePathFor(path);
+	uint64_t sourceHash = useCache ? MeshCache::hashFile(path) : 0;
+
+	// material textures decode on the worker pool while meshes are imported and uploaded
+	ImageDecodeBatch decodes;
+	textureDecodes = &decodes;
+
+	if (useCache && sourceHash != 0 && loadFromCache(cachePath, sourceHash)) {
+		loadedFromCache = true;
+	}
+	else {
+		Assimp::Importer import;
+		const aiScene* scene = import.ReadFile(path, MODEL_IMPORT_FLAGS);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+			std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+			textureDecodes = nullptr;
+			return;
+		}
+
+		std::vector<ImportedMesh> imported;
+		processNode(scene->mRootNode, scene, imported, -1);
+
+		std::vector<CachedMesh> sources(imported.size());
+		for (size_t i = 0; i < imported.size(); i++) {
+			sources[i].vertices = imported[i].vertices.data();
+			sources[i].vertexCount = static_cast<unsigned int>(imported[i].vertices.size());
+			sources[i].indices = imported[i].indices.data();
+			sources[i].indexCount = static_cast<unsigned int>(imported[i].indices.size());
+			sources[i].lods = imported[i].lods;
+			sources[i].textures = imported[i].textures;
+			sources[i].node = imported[i].node;
+			sources[i].material = imported[i].material;
+		}
+		buildMeshes(sources);
+
+		if (useCache && sourceHash != 0)
+			MeshCache::write(cachePath, sourceHash, MODEL_IMPORT_FLAGS, sources, nodes);
+	}
+
+	if (streamTextures)
+		streamMaterialTextures();
+	else
+		uploadMaterialTextures();
+	textureDecodes = nullptr;
+	updateNodes();
+	nodeStats = NodeStats();
+
+	auto end = std::chrono::high_resolution_clock::now();
+	loadTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+	std::cout << "Model loaded " << path << (loadedFromCache ? " from mesh cache" : " with assimp")
+		<< " in " << loadTimeMs << " ms, " << getGeometryBytes() / 1024 << " KB " << vertexLayoutName(layout) << " geometry, "
+		<< meshes.size() << " meshes on " << nodes.size() << " nodes in " << buckets.size() << " material draws" << std::endl;
+}
+
+bool Model::loadFromCache(const std::string& cachePath, uint64_t sourceHash)
+{
+	MeshCache cache;
+	if (!cache.open(cachePath, sourceHash, MODEL_IMPORT_FLAGS))
+		return false;
+
+	// buffers are filled directly from the mapping, the cache is unmapped once all meshes are uploaded
+	std::vector<CachedMesh> sources = cache.getMeshes();
+	nodes = cache.getNodes();
+	for (CachedMesh& source : sources) {
+		std::vector<MeshTexture> textures;
+		for (const MeshTexture& texture : source.textures)
+			textures.push_back(loadMaterialTexture(texture.path, texture.type));
+		source.textures = textures;
+	}
+	buildMeshes(sources);
+	return true;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::buildMeshes(const std::vector<CachedMesh>& sources)
 {
+	if (sources.empty()) return;
+
+	size_t vertexCount = 0, indexCount = 0;
+	bool shortIndices = true;
+	for (const CachedMesh& source : sources) {
+		vertexCount += source.vertexCount;
+		indexCount += source.indexCount;
+		shortIndices = shortIndices && source.vertexCount <= 65536; // indices stay relative to the mesh's base vertex
+	}
+	indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glstate::BindVertexArray(VAO);
+
+	// the quantized layout is packed over the whole model so every mesh shares one dequantization
+	PositionDequant dequant;
+	glstate::BindBuffer(GL_ARRAY_BUFFER, VBO);
+	if (layout == VertexLayout::Standard) {
+		glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+		size_t offset = 0;
+		for (const CachedMesh& source : sources) {
+			glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(Vertex), source.vertexCount * sizeof(Vertex), source.vertices);
+			offset += source.vertexCount;
+		}
+	}
+	else {
+		std::vector<Vertex> vertices;
+		vertices.reserve(vertexCount);
+		for (const CachedMesh& source : sources)
+			vertices.insert(vertices.end(), source.vertices, source.vertices + source.vertexCount);
+		std::vector<unsigned char> packed;
+		packVertices(vertices.data(), vertices.size(), layout, packed, dequant);
+		glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+	}
+
+	glstate::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	if (shortIndices) {
+		std::vector<unsigned short> indices;
+		indices.reserve(indexCount);
+		for (const CachedMesh& source : sources)
+			indices.insert(indices.end(), source.indices, source.indices + source.indexCount);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+	}
+	else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+		size_t offset = 0;
+		for (const CachedMesh& source : sources) {
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset * sizeof(unsigned int), source.indexCount * sizeof(unsigned int), source.indices);
+			offset += source.indexCount;
+		}
+	}
+
+	Mesh::setupVertexAttributes(layout);
+	glstate::BindVertexArray(0);
+
+	MeshBufferRange range;
+	range.VAO = VAO;
+	range.layout = layout;
+	range.indexType = indexType;
+	range.dequant = dequant;
+	for (const CachedMesh& source : sources) {
+		meshes.push_back(Mesh(source.vertices, source.vertexCount, source.indices, source.indexCount, source.textures, range, source.lods));
+		range.baseVertex += static_cast<GLint>(source.vertexCount);
+		range.firstIndex += source.indexCount;
+		meshBounds.add(meshes.back().getBoundsMin(), meshes.back().getBoundsMax());
+		meshNodes.push_back(source.node < nodes.size() ? source.node : 0);
+	}
+	if (nodes.size() == 0)
+		nodes.addNode("root", -1, glm::mat4(1.0f));
+
+	uploadMaterialBlocks(sources);
+	buildMaterialBuckets();
+}
+
+void Model::buildMaterialBuckets()
+{
+	// texture paths rather than ids, streamed textures swap their ids later. the parameters go in as raw bytes.
+	std::map<std::vector<std::string>, size_t> bucketIndices;
+	for (size_t i = 0; i < meshes.size(); i++) {
+		std::vector<std::string> key;
+		for (const MeshTexture& texture : meshes[i].textures)
+			key.push_back(texture.type + '/' + texture.path);
+		const MaterialParams& params = meshes[i].getMaterial().getParams();
+		key.push_back(std::string(reinterpret_cast<const char*>(&params), sizeof(params)));
+		auto inserted = bucketIndices.emplace(key, buckets.size());
+		if (inserted.second)
+			buckets.push_back(MaterialBucket());
+		buckets[inserted.first->second].meshes.push_back(i);
+	}
+
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	std::vector<glext::DrawElementsIndirectCommand> commands;
+	for (MaterialBucket& bucket : buckets) {
+		bucket.indirectOffset = static_cast<GLintptr>(commands.size() * sizeof(glext::DrawElementsIndirectCommand));
+		for (size_t i : bucket.meshes) {
+			const Mesh& mesh = meshes[i];
+			const MeshLOD& full = mesh.getLODs()[0];
+			GLuint firstIndex = mesh.getFirstIndex() + full.indexOffset;
+			commands.push_back({ full.indexCount, 1, firstIndex, mesh.getBaseVertex(), 0 });
+
+			bucket.counts.push_back(static_cast<GLsizei>(full.indexCount));
+			bucket.offsets.push_back((const void*)(firstIndex * indexSize));
+			bucket.baseVertices.push_back(mesh.getBaseVertex());
+			bucket.triangles += full.indexCount / 3;
+		}
+	}
+
+	nodeDraws.clear();
+	for (size_t b = 0; b < buckets.size(); b++) {
+		for (size_t j = 0; j < buckets[b].meshes.size(); j++)
+			nodeDraws.push_back({ meshNodes[buckets[b].meshes[j]], b, j });
+	}
+	std::stable_sort(nodeDraws.begin(), nodeDraws.end(), [](const NodeDraw& a, const NodeDraw& b) { return a.node < b.node; });
+
+	if (glext::hasMultiDrawIndirect()) {
+		glGenBuffers(1, &indirectBuffer);
+		glstate::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(glext::DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+		glstate::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<ImportedMesh>& imported, int32_t parent)
+{
+	// assimp matrices are row major
+	glm::mat4 local;
+	for (int row = 0; row < 4; row++)
+		for (int column = 0; column < 4; column++)
+			local[column][row] = node->mTransformation[row][column];
+	uint32_t index = nodes.addNode(node->mName.C_Str(), parent, local);
+
 	for (unsigned int i = 0; i < node->mNumMeshes; i++) {
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
 		// add to mesh array
-		meshes.push_back(processMesh(mesh, scene));
+		imported.push_back(processMesh(mesh, scene));
+		imported.back().node = index;
 	}
 
 	// recurse through its children
 	for (unsigned int i = 0; i < node->mNumChildren; i++) {
-		processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, imported, static_cast<int32_t>(index));
 	}
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::readMeshGeometry(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<MeshTexture> textures;
+	vertices.clear();
+	indices.clear();
+	vertices.reserve(mesh->mNumVertices);
 
 	// populate vertices vector
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
@@ -74,11 +500,26 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 
 	// populate indices vector
 	for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-		aiFace face = mesh->mFaces[i];
+		const aiFace& face = mesh->mFaces[i];
 		for (unsigned int j = 0; j < face.mNumIndices; j++) {
 			indices.push_back(face.mIndices[j]);
 		}
 	}
+}
+
+Model::ImportedMesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<MeshTexture> textures;
+	MaterialParams params;
+	readMeshGeometry(mesh, vertices, indices);
+
+	// assimp keeps the file's triangle order, reorder for the post-transform cache before the
+	// buffers (and the mesh cache) see it. the LOD levels follow the full mesh in the same index list.
+	weldVertices(vertices, indices);
+	optimizeMesh(vertices, indices);
+	std::vector<MeshLOD> lods = buildLODChain(vertices, indices);
 
 	// populate textures vector
 	if (mesh->mMaterialIndex >= 0) {
@@ -92,9 +533,11 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 
 		std::vector<MeshTexture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
 		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+
+		params = loadMaterialParams(material);
 	}
 
-	return Mesh(vertices, indices, textures);
+	return { std::move(vertices), std::move(indices), std::move(textures), std::move(lods), 0, params };
 }
 
 std::vector<MeshTexture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
@@ -103,77 +546,151 @@ std::vector<MeshTexture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureT
 	for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		bool skip = false;
-		for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-			if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-				textures.push_back(textures_loaded[j]);
-				skip = true;
-				break;
-			}
-		}
-		if (!skip) {
-			MeshTexture texture;
-
-			TextureColorSpace colorSpace = TextureColorSpace::Linear;
-			if (type == aiTextureType_DIFFUSE || type == aiTextureType_AMBIENT) {
-				colorSpace = TextureColorSpace::sRGB;
-			}
-
-			texture.id = TextureFromFile(str.C_Str(), directory, colorSpace);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);
-		}
+		textures.push_back(loadMaterialTexture(str.C_Str(), typeName));
 	}
 	return textures;
 }
 
+MeshTexture Model::loadMaterialTexture(const std::string& path, const std::string& typeName)
+{
+	auto loaded = textureIndices.find(path);
+	if (loaded != textureIndices.end())
+		return textures_loaded[loaded->second];
+
+	MeshTexture texture;
+	texture.type = typeName;
+	texture.path = path;
+	std::string fullPath = directory + '/' + path;
+	TextureColorSpace space = materialColorSpace(typeName);
+	texture.id = TextureCache::instance().acquire(fullPath, space, false, false);
+	if (texture.id == 0) {
+		size_t bakedBytes;
+		unsigned int baked = loadBakedTexture(fullPath, space, false, &bakedBytes);
+		if (baked != 0)
+			texture.id = TextureCache::instance().insert(fullPath, space, false, false, baked, bakedBytes);
+	}
+	textureIndices[path] = textures_loaded.size();
+	textures_loaded.push_back(texture);
 
-unsigned int Model::TextureFromFile(const char* path, const std::string& directory, TextureColorSpace space) {
-	std::string filename = std::string(path);
-	filename = directory + '/' + filename;
+	// not resident yet, the id is filled in by uploadMaterialTextures once the decode comes back
+	if (texture.id == 0) {
+		if (!streamTextures)
+			textureDecodes->add(fullPath, false);
+		pendingTextures.push_back(textures_loaded.size() - 1);
+	}
+	return texture;
+}
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+TextureColorSpace Model::materialColorSpace(const std::string& typeName)
+{
+	// color maps are authored in sRGB, everything else holds linear data
+	if (typeName == "texture_diffuse" || typeName == "texture_ambient")
+		return TextureColorSpace::sRGB;
+	return TextureColorSpace::Linear;
+}
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		// check count of nrComponents from the data
-		GLenum baseFormat;
-		if (nrComponents == 1) baseFormat = GL_RED;
-		else if (nrComponents == 3) baseFormat = GL_RGB;
-		else if (nrComponents == 4) baseFormat = GL_RGBA;
 
-		GLenum internalFormat = baseFormat;
-		if (space == TextureColorSpace::sRGB) {
-			if (baseFormat == GL_RGB)
-				internalFormat = GL_SRGB;
-			else if (baseFormat == GL_RGBA)
-				internalFormat = GL_SRGB_ALPHA;
+void Model::uploadMaterialTextures()
+{
+	// decodes finish in any order, upload each one as soon as it lands
+	size_t index;
+	DecodedImage image;
+	while (textureDecodes->next(index, image)) {
+		MeshTexture& texture = textures_loaded[pendingTextures[index]];
+		if (image.valid()) {
+			TextureColorSpace space = materialColorSpace(texture.type);
+			texture.id = createTextureFromImage(image, space);
+			TextureCache::instance().insert(directory + '/' + texture.path, space, false, false, texture.id, TextureCache::estimateImageBytes(image));
 		}
+		else
+			std::cout << "Texture failed to load at path: " << texture.path << std::endl;
+		image.release();
+	}
+	pendingTextures.clear();
+	patchMeshTextures();
+}
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, baseFormat, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+void Model::streamMaterialTextures()
+{
+	// meshes draw with the placeholder until each texture's mips are resident
+	TextureStreamer& streamer = TextureStreamer::instance();
+	for (size_t slot : pendingTextures) {
+		MeshTexture& texture = textures_loaded[slot];
+		texture.id = streamer.getPlaceholder();
+		streamer.request(directory + '/' + texture.path, false, materialColorSpace(texture.type), false, this,
+			[this, slot](unsigned int textureID) {
+				textures_loaded[slot].id = textureID;
+				patchMeshTextures();
+			});
+	}
+	pendingTextures.clear();
+	patchMeshTextures();
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		
+void Model::patchMeshTextures()
+{
+	// meshes were built with placeholder ids, patch in the uploaded ones
+	for (Mesh& mesh : meshes) {
+		for (MeshTexture& meshTexture : mesh.textures)
+			meshTexture.id = textures_loaded[textureIndices[meshTexture.path]].id;
+		mesh.updateMaterialTextures();
 	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
+}
+
+MaterialParams Model::loadMaterialParams(const aiMaterial* material)
+{
+	MaterialParams params;
+	aiColor3D color;
+	if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == aiReturn_SUCCESS)
+		params.diffuseColor = glm::vec4(color.r, color.g, color.b, 1.0f);
+	if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == aiReturn_SUCCESS)
+		params.specularColor = glm::vec4(color.r, color.g, color.b, 1.0f);
+	// exporters write 0 for "not set", which would light every fragment at full specular
+	float shininess = 0.0f;
+	if (material->Get(AI_MATKEY_SHININESS, shininess) == aiReturn_SUCCESS && shininess > 0.0f)
+		params.shininess = shininess;
+	float opacity = 1.0f;
+	if (material->Get(AI_MATKEY_OPACITY, opacity) == aiReturn_SUCCESS)
+		params.opacity = opacity;
+	return params;
+}
+
+void Model::uploadMaterialBlocks(const std::vector<CachedMesh>& sources)
+{
+	// every mesh's MaterialBlock in one buffer, each at an offset glBindBufferRange accepts
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	size_t stride = (sizeof(MaterialParams) + alignment - 1) / alignment * alignment;
+	std::vector<unsigned char> blocks(stride * sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+		std::memcpy(&blocks[i * stride], &sources[i].material, sizeof(MaterialParams));
+
+	glGenBuffers(1, &materialBuffer);
+	glstate::BindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, blocks.size(), blocks.data(), GL_STATIC_DRAW);
+	glstate::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	for (size_t i = 0; i < meshes.size(); i++) {
+		meshes[i].getMaterial().setParams(sources[i].material);
+		meshes[i].getMaterial().setBlock(materialBuffer, static_cast<GLintptr>(i * stride));
 	}
-	stbi_image_free(data);
-	return textureID;
+}
+
+void Model::prepareMaterials(const Shader& shader) const
+{
+	for (const Mesh& mesh : meshes)
+		mesh.getMaterial().prepare(shader);
 }
 
 const std::vector<Mesh>& Model::getMeshes() const
 {
 	return meshes;
 }
+
+size_t Model::getGeometryBytes() const
+{
+	size_t bytes = 0;
+	for (const Mesh& mesh : meshes)
+		bytes += mesh.getVertexBufferBytes() + mesh.getIndexBufferBytes();
+	return bytes;
+}
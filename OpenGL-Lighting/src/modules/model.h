@@ -1,31 +1,166 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include <unordered_map>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "shader.h"
 #include "mesh.h"
+#include "frustum.h"
+#include "node_hierarchy.h"
 #include "utils.h"
 
+struct CachedMesh;
+
+// assimp post-processing applied on import, also part of the mesh cache key
+constexpr unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
 class Model {
 public:
-	Model(const char* path) {
+	// streamTextures: draw with the placeholder while TextureStreamer uploads the materials
+	// layout: vertex buffer format of every mesh, compact ones need COMPACT_VERTEX shaders
+	Model(const char* path, bool useCache = true, bool streamTextures = false, VertexLayout layout = VertexLayout::Standard)
+		: useCache(useCache), streamTextures(streamTextures), layout(layout) {
 		loadModel(path);
 	}
-	void Draw(Shader& shader);
+	~Model();
+
+	// each model holds one TextureCache reference per unique texture, copies would release them twice
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+
+	// every draw places each mesh under its node's world matrix times model, which it sets as the shader's model
+	// uniform itself. while no node moves its meshes that is model alone and the meshes go out batched.
+
+	// whole model at full detail, one multi-draw per material bucket, one draw per mesh once a node moves
+	void Draw(Shader& shader, const glm::mat4& model);
+	// every mesh picks its own LOD level
+	void Draw(Shader& shader, const glm::mat4& model, const LODView& view);
+	// the per instance matrix comes from the shader, a mesh's node world matrix goes in as its "nodeMatrix" uniform
 	void DrawInstanced(Shader& shader, unsigned int count);
+	// every mesh once per entry of instances, one instanced draw per mesh. nodes as above.
+	void DrawInstanced(Shader& shader, InstanceBuffer& instances);
+	// full detail minus the meshes whose box, moved by its node, is outside frustum (world space)
+	void Draw(Shader& shader, const Frustum& frustum, const glm::mat4& model, FrustumCullStats* stats = nullptr);
+	// view is built for model, see MeshletCullView. meshes under a moved node get it moved along.
+	void DrawCulled(Shader& shader, const MeshletCullView& view, const glm::mat4& model, MeshletCullStats* stats = nullptr);
 
 	const std::vector<Mesh>& getMeshes() const; // may be temporary for getting mesh array
+
+	// the imported node tree, every mesh hangs off one node
+	const NodeHierarchy& getNodes() const { return nodes; }
+	int32_t findNode(const std::string& name) const { return nodes.find(name); }
+	uint32_t getMeshNode(size_t mesh) const { return meshNodes[mesh]; }
+	// local transform relative to the parent node, picked up by the next updateNodes()
+	void setNodeTransform(uint32_t node, const glm::mat4& local) { nodes.setLocal(node, local); }
+	// recomputes the subtrees under changed nodes, the draws taking a model matrix call this themselves
+	void updateNodes();
+	// prints this model's per frame node update cost over frameCount frames and resets it
+	void printNodeStats(unsigned int frameCount);
+
+	// load statistics, used to compare cold (assimp) and warm (mesh cache) starts
+	double getLoadTimeMs() const { return loadTimeMs; }
+	bool isLoadedFromCache() const { return loadedFromCache; }
+	// vertex + index buffer bytes over all meshes
+	size_t getGeometryBytes() const;
+	// draw calls Draw(shader) issues, meshes with identical materials go out together
+	size_t getMaterialBucketCount() const { return buckets.size(); }
+	// resolves every mesh material's samplers for shader up front, so its first frame doesn't either
+	void prepareMaterials(const Shader& shader) const;
+
+	// color space a material texture of this type is uploaded in
+	static TextureColorSpace materialColorSpace(const std::string& typeName);
+	// every attribute and index of mesh as imported, before welding and the cache passes
+	static void readMeshGeometry(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
 private:
+	// assimp output before it is uploaded (and written to the mesh cache)
+	struct ImportedMesh {
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<MeshTexture> textures;
+		std::vector<MeshLOD> lods;
+		uint32_t node;
+		MaterialParams material;
+	};
+
+	// one mesh of the per mesh path drawNodes takes, ordered by node then bucket
+	struct NodeDraw {
+		uint32_t node;
+		size_t bucket;
+		size_t slot; // index into the bucket's arrays
+	};
+
+	// updateNodes() work since the last printNodeStats
+	struct NodeStats {
+		unsigned long long updates = 0;
+		unsigned long long recomputed = 0;
+		double ms = 0.0;
+	};
+
+	// meshes sharing one texture set, drawn with a single multi-draw. the fallback arrays mirror the indirect commands.
+	struct MaterialBucket {
+		std::vector<size_t> meshes;
+		GLintptr indirectOffset = 0;
+		std::vector<GLsizei> counts;
+		std::vector<const void*> offsets;
+		std::vector<GLint> baseVertices;
+		unsigned long long triangles = 0;
+	};
+
 	std::vector<Mesh> meshes;
+	NodeHierarchy nodes;
+	std::vector<uint32_t> meshNodes;
+	std::vector<NodeDraw> nodeDraws;
+	bool nodeTransforms = false; // some mesh's node world matrix isn't the identity
+	NodeStats nodeStats;
+	// one vertex/index buffer pair for every mesh, each mesh draws its range with a base vertex
+	unsigned int VAO = 0, VBO = 0, EBO = 0;
+	unsigned int indirectBuffer = 0; // 0 when glMultiDrawElementsIndirect isn't available
+	unsigned int materialBuffer = 0; // every mesh's MaterialBlock
+	GLenum indexType = GL_UNSIGNED_INT;
+	std::vector<MaterialBucket> buckets;
+	// object space box of every mesh, in mesh order
+	BoxBatch meshBounds;
+	// the same boxes moved by their node's world matrix, rebuilt by updateNodes while nodeTransforms is set
+	BoxBatch nodeBounds;
+	// per draw scratch for the frustum culled Draw
+	std::vector<unsigned char> meshVisibility;
+	std::vector<GLsizei> visibleCounts;
+	std::vector<const void*> visibleOffsets;
+	std::vector<GLint> visibleBaseVertices;
 	std::vector<MeshTexture> textures_loaded;
+	std::unordered_map<std::string, size_t> textureIndices; // material path -> textures_loaded slot
 	std::string directory;
+	std::string path;
+
+	// one multi-draw per material bucket with whatever model matrix the shader holds
+	void drawBuckets(Shader& shader);
+	// one draw per mesh under model times its node's world matrix, visibility (mesh order) skips meshes when given
+	void drawNodes(Shader& shader, const glm::mat4& model, const unsigned char* visibility = nullptr);
+
+	// decode batch and textures_loaded slots waiting on it, only set while loading
+	ImageDecodeBatch* textureDecodes = nullptr;
+	std::vector<size_t> pendingTextures;
+
+	bool useCache;
+	bool streamTextures;
+	VertexLayout layout;
+	bool loadedFromCache = false;
+	double loadTimeMs = 0.0;
 
 	void loadModel(std::string path);
-	void processNode(aiNode* node, const aiScene* scene);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+	bool loadFromCache(const std::string& cachePath, uint64_t sourceHash);
+	MeshTexture loadMaterialTexture(const std::string& path, const std::string& typeName);
+	void uploadMaterialTextures();
+	void streamMaterialTextures();
+	void patchMeshTextures();
+	void buildMeshes(const std::vector<CachedMesh>& sources);
+	void buildMaterialBuckets();
+	void uploadMaterialBlocks(const std::vector<CachedMesh>& sources);
+	static MaterialParams loadMaterialParams(const aiMaterial* material);
+	void processNode(aiNode* node, const aiScene* scene, std::vector<ImportedMesh>& imported, int32_t parent);
+	ImportedMesh processMesh(aiMesh* mesh, const aiScene* scene);
 	std::vector<MeshTexture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
-	unsigned int TextureFromFile(const char* path, const std::string& directory, TextureColorSpace space = TextureColorSpace::Linear);
 };
\ No newline at end of file
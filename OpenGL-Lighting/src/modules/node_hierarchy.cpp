@@ -0,0 +1,78 @@
+#include "node_hierarchy.h"
+
+#include <iostream>
+
+uint32_t NodeHierarchy::addNode(const std::string& name, int32_t parent, const glm::mat4& local)
+{
+	uint32_t index = static_cast<uint32_t>(locals.size());
+	if (parent >= static_cast<int32_t>(index)) {
+		std::cout << "ERROR::NODE_HIERARCHY::PARENT_AFTER_CHILD " << name << std::endl;
+		parent = -1;
+	}
+
+	names.push_back(name);
+	parents.push_back(parent);
+	subtreeSizes.push_back(1);
+	locals.push_back(local);
+	worlds.push_back(local);
+	dirty.push_back(1);
+	dirtyCount++;
+
+	// depth first order means the new node closes the subtree of every ancestor
+	for (int32_t ancestor = parent; ancestor >= 0; ancestor = parents[ancestor])
+		subtreeSizes[ancestor]++;
+	return index;
+}
+
+void NodeHierarchy::clear()
+{
+	names.clear();
+	parents.clear();
+	subtreeSizes.clear();
+	locals.clear();
+	worlds.clear();
+	dirty.clear();
+	dirtyCount = 0;
+}
+
+void NodeHierarchy::setLocal(uint32_t node, const glm::mat4& local)
+{
+	locals[node] = local;
+	if (!dirty[node]) {
+		dirty[node] = 1;
+		dirtyCount++;
+	}
+}
+
+int32_t NodeHierarchy::find(const std::string& name) const
+{
+	for (size_t i = 0; i < names.size(); i++) {
+		if (names[i] == name)
+			return static_cast<int32_t>(i);
+	}
+	return -1;
+}
+
+size_t NodeHierarchy::update()
+{
+	if (dirtyCount == 0) return 0;
+
+	size_t recomputed = 0;
+	size_t count = locals.size();
+	for (size_t i = 0; i < count;) {
+		if (!dirty[i]) {
+			i++;
+			continue;
+		}
+		// parents are earlier in the range, so a forward walk sees every parent's new world first
+		size_t end = i + subtreeSizes[i];
+		for (size_t j = i; j < end; j++) {
+			worlds[j] = parents[j] < 0 ? locals[j] : worlds[parents[j]] * locals[j];
+			dirty[j] = 0;
+		}
+		recomputed += end - i;
+		i = end;
+	}
+	dirtyCount = 0;
+	return recomputed;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// a node tree kept flat in depth first order: a parent always comes before its children and a node's
+// subtree is the contiguous range [node, node + subtree size). world matrices are cached and only the
+// subtrees under nodes changed since the last update() are recomputed, in one forward pass.
+class NodeHierarchy {
+public:
+	// nodes must be added in depth first order, parent -1 for a root. returns the node's index.
+	uint32_t addNode(const std::string& name, int32_t parent, const glm::mat4& local);
+	void clear();
+	size_t size() const { return locals.size(); }
+
+	void setLocal(uint32_t node, const glm::mat4& local);
+	const glm::mat4& getLocal(uint32_t node) const { return locals[node]; }
+	// valid after update()
+	const glm::mat4& getWorld(uint32_t node) const { return worlds[node]; }
+	int32_t getParent(uint32_t node) const { return parents[node]; }
+	const std::string& getName(uint32_t node) const { return names[node]; }
+	uint32_t getSubtreeSize(uint32_t node) const { return subtreeSizes[node]; }
+	// first node with this name, -1 if there is none
+	int32_t find(const std::string& name) const;
+
+	bool isDirty() const { return dirtyCount > 0; }
+	// recomputes the world matrices of every changed subtree, returns how many nodes were recomputed
+	size_t update();
+
+private:
+	std::vector<std::string> names;
+	std::vector<int32_t> parents;
+	std::vector<uint32_t> subtreeSizes;
+	std::vector<glm::mat4> locals;
+	std::vector<glm::mat4> worlds;
+	std::vector<unsigned char> dirty;
+	size_t dirtyCount = 0;
+};
@@ -0,0 +1,180 @@
+#include "program_cache.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "gl_extensions.h"
+#include "mapped_file.h"
+
+namespace {
+	const char PROGRAM_CACHE_MAGIC[4] = { 'O', 'G', 'L', 'P' };
+	const char* PROGRAM_CACHE_DIRECTORY = "shaders/cache";
+
+	uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t hashString(uint64_t hash, const std::string& value)
+	{
+		// the terminator keeps "ab" + "c" and "a" + "bc" apart
+		return hashBytes(hash, value.c_str(), value.size() + 1);
+	}
+
+	void ensureDirectory(const char* path)
+	{
+#ifdef _WIN32
+		_mkdir(path);
+#else
+		mkdir(path, 0755);
+#endif
+	}
+}
+
+ProgramCache& ProgramCache::instance()
+{
+	static ProgramCache cache;
+	return cache;
+}
+
+bool ProgramCache::isEnabled()
+{
+	if (!checked) {
+		checked = true;
+		enabled = glext::hasProgramBinary();
+
+		const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		driverHash = 14695981039346656037ull;
+		for (GLenum name : strings) {
+			const GLubyte* value = glGetString(name);
+			driverHash = hashString(driverHash, value ? reinterpret_cast<const char*>(value) : "");
+		}
+	}
+	return enabled;
+}
+
+uint64_t ProgramCache::hashSources(const std::vector<std::string>& sources)
+{
+	isEnabled();
+	uint64_t hash = driverHash;
+	for (const std::string& source : sources)
+		hash = hashString(hash, source);
+	return hash;
+}
+
+std::string ProgramCache::cachePathFor(const std::vector<std::string>& stagePaths) const
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (const std::string& path : stagePaths)
+		hash = hashString(hash, path);
+
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+	return std::string(PROGRAM_CACHE_DIRECTORY) + "/" + name + ".progbin";
+}
+
+bool ProgramCache::load(const std::string& cachePath, uint64_t sourceHash, unsigned int program)
+{
+	if (!isEnabled()) return false;
+
+	MappedFile file;
+	if (!file.open(cachePath) || file.size() < sizeof(ProgramCacheHeader)) return false;
+
+	const ProgramCacheHeader* header = reinterpret_cast<const ProgramCacheHeader*>(file.data());
+	if (std::memcmp(header->magic, PROGRAM_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != PROGRAM_CACHE_VERSION ||
+		header->sourceHash != sourceHash ||
+		sizeof(ProgramCacheHeader) + static_cast<size_t>(header->binaryLength) > file.size())
+		return false;
+
+	// the driver may still refuse a binary it wrote itself, e.g. after a silent update
+	glext::ProgramBinary(program, header->binaryFormat, file.data() + sizeof(ProgramCacheHeader), header->binaryLength);
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	return success != 0;
+}
+
+bool ProgramCache::store(const std::string& cachePath, uint64_t sourceHash, unsigned int program)
+{
+	if (!isEnabled()) return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return false;
+
+	std::vector<unsigned char> binary(length);
+	GLenum binaryFormat = 0;
+	glext::GetProgramBinary(program, length, NULL, &binaryFormat, binary.data());
+
+	ensureDirectory(PROGRAM_CACHE_DIRECTORY);
+	std::string tempPath = cachePath + ".tmp";
+	std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "ERROR::PROGRAM_CACHE::Could not write " << cachePath << std::endl;
+		return false;
+	}
+
+	ProgramCacheHeader header = {};
+	std::memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+	header.version = PROGRAM_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = static_cast<uint32_t>(length);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+
+	out.close();
+	if (!out) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	std::remove(cachePath.c_str());
+	if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void ProgramCache::recordTiming(const std::string& name, double ms, bool fromCache)
+{
+	timings.push_back({ name, ms, fromCache });
+}
+
+void ProgramCache::printReport() const
+{
+	double compiledMs = 0.0, cachedMs = 0.0;
+	int compiled = 0, cached = 0;
+
+	// formatted apart so std::cout keeps its own flags and precision
+	std::ostringstream report;
+	report << std::left << std::setw(80) << "program" << std::setw(10) << "source" << std::right << std::setw(10) << "ms" << std::endl;
+	for (const Timing& timing : timings) {
+		report << std::left << std::setw(80) << timing.name << std::setw(10) << (timing.fromCache ? "cache" : "compile")
+			<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << timing.ms << std::endl;
+		if (timing.fromCache) {
+			cachedMs += timing.ms;
+			cached++;
+		}
+		else {
+			compiledMs += timing.ms;
+			compiled++;
+		}
+	}
+	report << compiled << " compiled in " << compiledMs << " ms, " << cached << " loaded from cache in " << cachedMs << " ms" << std::endl;
+	std::cout << report.str();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+
+// bump whenever the file layout below changes
+constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t binaryFormat;
+	uint32_t binaryLength;
+};
+
+// linked program binaries on disk under shaders/cache, one file per set of stage files. the file
+// name comes from the stage paths, the header holds the hash of the exact sources and the driver
+// that produced the binary, so an edited shader or a driver update recompiles and overwrites it.
+class ProgramCache {
+public:
+	struct Timing {
+		std::string name;
+		double ms;
+		bool fromCache;
+	};
+
+	static ProgramCache& instance();
+
+	// false when the driver can't save binaries, Shader then always compiles
+	bool isEnabled();
+
+	// 64-bit FNV-1a over the driver identity and every stage source in order
+	uint64_t hashSources(const std::vector<std::string>& sources);
+	std::string cachePathFor(const std::vector<std::string>& stagePaths) const;
+
+	// loads the binary into program, false if it is missing, stale or rejected by the driver
+	bool load(const std::string& cachePath, uint64_t sourceHash, unsigned int program);
+	bool store(const std::string& cachePath, uint64_t sourceHash, unsigned int program);
+
+	void recordTiming(const std::string& name, double ms, bool fromCache);
+	const std::vector<Timing>& getTimings() const { return timings; }
+	// per program compile or load time plus totals for both
+	void printReport() const;
+
+private:
+	ProgramCache() = default;
+
+	bool checked = false;
+	bool enabled = false;
+	uint64_t driverHash = 0;
+	std::vector<Timing> timings;
+};
@@ -0,0 +1,243 @@
+#include "render_queue.h"
+#include "gl_state.h"
+
+#include <iostream>
+#include <algorithm>
+
+namespace {
+	// 16 bits standing for a set of textures, equal sets end up next to each other in the sort
+	uint64_t materialKey(const unsigned int* textures, unsigned int count)
+	{
+		uint32_t hash = 0;
+		for (unsigned int i = 0; i < count; i++)
+			hash = hash * 31u + textures[i];
+		return (hash ^ (hash >> 16)) & 0xFFFF;
+	}
+
+	uint64_t materialKey(const Mesh& mesh)
+	{
+		uint32_t hash = 0;
+		for (const MeshTexture& texture : mesh.textures)
+			hash = hash * 31u + texture.id;
+		return (hash ^ (hash >> 16)) & 0xFFFF;
+	}
+}
+
+void RenderQueueStats::print(unsigned int frameCount)
+{
+	if (frameCount > 0 && packets > 0) {
+		std::cout << name << " per frame: " << packets / frameCount << " packets, "
+			<< programs / frameCount << " program binds (" << programsImmediate / frameCount << " unsorted), "
+			<< textures / frameCount << " texture binds (" << texturesImmediate / frameCount << "), "
+			<< vaos / frameCount << " vao binds (" << vaosImmediate / frameCount << ")" << std::endl;
+	}
+	packets = programs = programsImmediate = textures = texturesImmediate = vaos = vaosImmediate = 0;
+}
+
+void RenderQueue::setDepthRange(float nearDepth, float farDepth)
+{
+	this->nearDepth = nearDepth;
+	this->farDepth = farDepth;
+}
+
+void RenderQueue::setBackToFront(unsigned int pass, bool backToFront)
+{
+	if (backToFront) this->backToFront |= 1u << pass;
+	else this->backToFront &= ~(1u << pass);
+}
+
+void RenderQueue::submit(unsigned int pass, Shader& shader, Model& model, const glm::mat4& matrix, float depth, const LODView* view)
+{
+	model.updateNodes();
+	const std::vector<Mesh>& meshes = model.getMeshes();
+	for (size_t i = 0; i < meshes.size(); i++) {
+		glm::mat4 world = matrix * model.getNodes().getWorld(model.getMeshNode(i));
+		unsigned int lod = view ? meshes[i].selectLOD(world, *view) : 0;
+		submit(pass, shader, meshes[i], world, depth, lod);
+	}
+}
+
+void RenderQueue::submit(unsigned int pass, Shader& shader, const Mesh& mesh, const glm::mat4& model, float depth, unsigned int lod,
+	PacketUniforms uniforms, const void* user)
+{
+	const MeshLOD& level = mesh.getLODs()[lod];
+	size_t indexSize = mesh.getIndexType() == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+
+	DrawPacket packet;
+	packet.shader = &shader;
+	packet.mesh = &mesh;
+	packet.VAO = mesh.getVAO();
+	packet.indexType = mesh.getIndexType();
+	packet.count = level.indexCount;
+	packet.offset = (void*)((mesh.getFirstIndex() + level.indexOffset) * indexSize);
+	packet.first = mesh.getBaseVertex();
+	packet.model = model;
+	packet.uniforms = uniforms;
+	packet.user = user;
+	push(pass, packet, depth);
+}
+
+void RenderQueue::submitArrays(unsigned int pass, Shader& shader, GLuint VAO, GLint first, GLsizei count, const glm::mat4& model, float depth,
+	const unsigned int* textures, unsigned int textureCount, PacketUniforms uniforms, const void* user)
+{
+	DrawPacket packet;
+	packet.shader = &shader;
+	packet.textures = textures;
+	packet.textureCount = textureCount;
+	packet.VAO = VAO;
+	packet.count = count;
+	packet.first = first;
+	packet.model = model;
+	packet.uniforms = uniforms;
+	packet.user = user;
+	push(pass, packet, depth);
+}
+
+void RenderQueue::push(unsigned int pass, const DrawPacket& packet, float depth)
+{
+	if (pass >= RENDER_QUEUE_PASSES) {
+		std::cout << "ERROR::RENDER_QUEUE::PASS_OUT_OF_RANGE " << pass << std::endl;
+		return;
+	}
+
+	float t = farDepth > nearDepth ? (depth - nearDepth) / (farDepth - nearDepth) : 0.0f;
+	uint64_t quantized = static_cast<uint64_t>(std::min(std::max(t, 0.0f), 1.0f) * RENDER_KEY_DEPTH_MAX);
+	if (backToFront & (1u << pass))
+		quantized = RENDER_KEY_DEPTH_MAX - quantized;
+
+	uint64_t key = static_cast<uint64_t>(pass) << RENDER_KEY_PASS_SHIFT;
+	key |= static_cast<uint64_t>(packet.shader->ID & 0xFFF) << RENDER_KEY_SHADER_SHIFT;
+	key |= (packet.mesh ? materialKey(*packet.mesh) : materialKey(packet.textures, packet.textureCount)) << RENDER_KEY_MATERIAL_SHIFT;
+	key |= static_cast<uint64_t>(packet.VAO & 0xFFF) << RENDER_KEY_VAO_SHIFT;
+	key |= quantized;
+
+	packets.push_back(packet);
+	keys.push_back(key);
+	sorted = false;
+
+	// what drawing it right away would have cost
+	stats.packets++;
+	if (packet.shader != lastSubmitted) {
+		stats.programsImmediate++;
+		lastSubmitted = packet.shader;
+	}
+	stats.texturesImmediate += packet.mesh ? packet.mesh->textures.size() : packet.textureCount;
+	stats.vaosImmediate++;
+}
+
+// least significant byte first, 8 counting passes at most. a byte every key shares is skipped, which
+// is most of them in a frame with few shaders and materials. stable, so equal keys keep submission order.
+void RenderQueue::sort()
+{
+	size_t count = keys.size();
+	order.resize(count);
+	scratch.resize(count);
+	for (size_t i = 0; i < count; i++)
+		order[i] = static_cast<uint32_t>(i);
+
+	for (unsigned int shift = 0; shift < 64 && count > 1; shift += 8) {
+		size_t offsets[256] = {};
+		for (size_t i = 0; i < count; i++)
+			offsets[(keys[order[i]] >> shift) & 0xFF]++;
+		if (offsets[(keys[order[0]] >> shift) & 0xFF] == count) continue;
+
+		size_t sum = 0;
+		for (size_t& offset : offsets) {
+			size_t bucket = offset;
+			offset = sum;
+			sum += bucket;
+		}
+		for (size_t i = 0; i < count; i++)
+			scratch[offsets[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+		order.swap(scratch);
+	}
+
+	sortedKeys.resize(count);
+	for (size_t i = 0; i < count; i++)
+		sortedKeys[i] = keys[order[i]];
+	sorted = true;
+}
+
+void RenderQueue::execute(unsigned int pass)
+{
+	if (!sorted) sort();
+	if (pass >= RENDER_QUEUE_PASSES) return;
+
+	// a pass is a contiguous run of the sorted keys
+	uint64_t passBits = static_cast<uint64_t>(pass) << RENDER_KEY_PASS_SHIFT;
+	size_t begin = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), passBits) - sortedKeys.begin();
+	size_t end = pass + 1 < RENDER_QUEUE_PASSES
+		? std::lower_bound(sortedKeys.begin(), sortedKeys.end(), passBits + (1ull << RENDER_KEY_PASS_SHIFT)) - sortedKeys.begin()
+		: sortedKeys.size();
+	if (begin == end) return;
+
+	// the caller may have changed anything since the last pass, so nothing is assumed bound
+	Shader* shader = nullptr;
+	const void* material = nullptr;
+	GLuint vao = 0;
+	bool vaoKnown = false;
+	unsigned int bound[RENDER_QUEUE_TEXTURE_UNITS];
+	std::fill(bound, bound + RENDER_QUEUE_TEXTURE_UNITS, ~0u);
+
+	Mesh::DrawStats& drawStats = Mesh::drawStats();
+	for (size_t i = begin; i < end; i++) {
+		const DrawPacket& packet = packets[order[i]];
+
+		if (packet.shader != shader) {
+			shader = packet.shader;
+			shader->use();
+			stats.programs++;
+			material = nullptr; // sampler uniforms belong to the program
+		}
+
+		const void* packetMaterial = packet.mesh ? static_cast<const void*>(packet.mesh) : static_cast<const void*>(packet.textures);
+		if (packetMaterial != material) {
+			material = packetMaterial;
+			if (packet.mesh) {
+				bool tracked = packet.mesh->textures.size() <= RENDER_QUEUE_TEXTURE_UNITS;
+				stats.textures += packet.mesh->bindMaterial(*shader, tracked ? bound : nullptr);
+				if (!tracked) std::fill(bound, bound + RENDER_QUEUE_TEXTURE_UNITS, ~0u);
+			}
+			else {
+				bool changed = false;
+				for (unsigned int unit = 0; unit < packet.textureCount && unit < RENDER_QUEUE_TEXTURE_UNITS; unit++) {
+					if (bound[unit] == packet.textures[unit]) continue;
+					glstate::ActiveTexture(GL_TEXTURE0 + unit);
+					glstate::BindTexture(GL_TEXTURE_2D, packet.textures[unit]);
+					bound[unit] = packet.textures[unit];
+					stats.textures++;
+					changed = true;
+				}
+				if (changed) glstate::ActiveTexture(GL_TEXTURE0);
+			}
+		}
+
+		if (!vaoKnown || packet.VAO != vao) {
+			glstate::BindVertexArray(packet.VAO);
+			vao = packet.VAO;
+			vaoKnown = true;
+			stats.vaos++;
+		}
+
+		shader->setModel(packet.model);
+		if (packet.uniforms)
+			packet.uniforms(*shader, packet.user);
+
+		if (packet.indexType)
+			glDrawElementsBaseVertex(GL_TRIANGLES, packet.count, packet.indexType, packet.offset, packet.first);
+		else
+			glDrawArrays(GL_TRIANGLES, packet.first, packet.count);
+		drawStats.draws++;
+		drawStats.triangles += packet.count / 3;
+	}
+	glstate::BindVertexArray(0);
+}
+
+void RenderQueue::clear()
+{
+	packets.clear();
+	keys.clear();
+	sortedKeys.clear();
+	sorted = true;
+	lastSubmitted = nullptr;
+}
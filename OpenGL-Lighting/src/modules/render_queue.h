@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "mesh.h"
+#include "model.h"
+
+// sort key layout, most significant first: pass 4 | shader 12 | material 16 | vao 12 | depth 20.
+// sorting by it groups a pass's packets by program, then textures, then vertex array.
+constexpr unsigned int RENDER_KEY_PASS_SHIFT = 60;
+constexpr unsigned int RENDER_KEY_SHADER_SHIFT = 48;
+constexpr unsigned int RENDER_KEY_MATERIAL_SHIFT = 32;
+constexpr unsigned int RENDER_KEY_VAO_SHIFT = 20;
+constexpr uint32_t RENDER_KEY_DEPTH_MAX = 0xFFFFF;
+constexpr unsigned int RENDER_QUEUE_PASSES = 16;
+// texture units whose bindings the queue tracks while executing
+constexpr unsigned int RENDER_QUEUE_TEXTURE_UNITS = 16;
+
+// per packet uniforms beyond the model matrix, e.g. a light's color
+typedef void (*PacketUniforms)(Shader& shader, const void* user);
+
+struct DrawPacket {
+	Shader* shader = nullptr;
+	const Mesh* mesh = nullptr;             // material and index range come from the mesh, null for an arrays draw
+	const unsigned int* textures = nullptr; // arrays draws only, bound to units 0..textureCount-1
+	unsigned int textureCount = 0;
+	GLuint VAO = 0;
+	GLenum indexType = 0;                   // 0 for glDrawArrays
+	GLsizei count = 0;
+	const void* offset = nullptr;
+	GLint first = 0;                        // base vertex of an indexed draw, first vertex of an arrays draw
+	glm::mat4 model = glm::mat4(1.0f);
+	PacketUniforms uniforms = nullptr;
+	const void* user = nullptr;
+};
+
+// gl state changes the queue issued, next to the ones the same packets drawn one by one in submission order
+// would have issued: a program switch whenever the shader changes, every texture of every draw and a VAO per draw.
+struct RenderQueueStats {
+	std::string name;
+	unsigned long long packets = 0;
+	unsigned long long programs = 0, programsImmediate = 0;
+	unsigned long long textures = 0, texturesImmediate = 0;
+	unsigned long long vaos = 0, vaosImmediate = 0;
+
+	explicit RenderQueueStats(const std::string& name) : name(name) {}
+	// prints the per frame averages over frameCount frames and resets the counters
+	void print(unsigned int frameCount);
+};
+
+// draws are submitted as packets into numbered passes during the frame, then radix sorted on their 64-bit key and
+// issued one pass at a time. program, texture and vertex array binds that would not change anything are skipped.
+class RenderQueue {
+public:
+	explicit RenderQueue(const std::string& name = "render queue") : stats(name) {}
+
+	// depths in [nearDepth, farDepth] are quantized into the key, others clamp
+	void setDepthRange(float nearDepth, float farDepth);
+	// blended passes want their packets back to front, every pass starts front to back
+	void setBackToFront(unsigned int pass, bool backToFront);
+
+	// one packet per mesh with the node transforms on top of matrix, levels picked by selectLOD when view is given
+	void submit(unsigned int pass, Shader& shader, Model& model, const glm::mat4& matrix, float depth, const LODView* view = nullptr);
+	void submit(unsigned int pass, Shader& shader, const Mesh& mesh, const glm::mat4& model, float depth, unsigned int lod = 0,
+		PacketUniforms uniforms = nullptr, const void* user = nullptr);
+	// glDrawArrays(GL_TRIANGLES) over VAO. textures must stay alive until the pass is executed.
+	void submitArrays(unsigned int pass, Shader& shader, GLuint VAO, GLint first, GLsizei count, const glm::mat4& model, float depth,
+		const unsigned int* textures = nullptr, unsigned int textureCount = 0, PacketUniforms uniforms = nullptr, const void* user = nullptr);
+
+	// sorts on the first call after a submit, then issues the packets of this pass. state the queue doesn't
+	// track (framebuffers, blending, per pass uniforms) is set by the caller in between.
+	void execute(unsigned int pass);
+	// drops every packet, once per frame after the last execute
+	void clear();
+	size_t size() const { return packets.size(); }
+
+	RenderQueueStats stats;
+
+private:
+	std::vector<DrawPacket> packets;
+	std::vector<uint64_t> keys;
+	// after sort(): packet indices in key order and the keys in that order
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> scratch;
+	std::vector<uint64_t> sortedKeys;
+	bool sorted = true;
+	float nearDepth = 0.0f, farDepth = 1000.0f;
+	uint16_t backToFront = 0; // one bit per pass
+	const Shader* lastSubmitted = nullptr;
+
+	void push(unsigned int pass, const DrawPacket& packet, float depth);
+	void sort();
+};
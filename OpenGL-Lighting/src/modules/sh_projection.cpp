@@ -0,0 +1,145 @@
+#include "sh_projection.h"
+
+#include <cmath>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SH_PROJECTION_SSE2
+#endif
+
+namespace {
+	void evaluateBasis(float x, float y, float z, float basis[9])
+	{
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * y;
+		basis[2] = 0.488603f * z;
+		basis[3] = 0.488603f * x;
+		basis[4] = 1.092548f * x * y;
+		basis[5] = 1.092548f * y * z;
+		basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+		basis[7] = 1.092548f * x * z;
+		basis[8] = 0.546274f * (x * x - y * y);
+	}
+
+	// direction through texel (s, t) in [-1, 1] of a GL cubemap face
+	void faceDirection(int face, float s, float t, float& x, float& y, float& z)
+	{
+		switch (face) {
+		case 0: x = 1.0f; y = -t; z = -s; break;
+		case 1: x = -1.0f; y = -t; z = s; break;
+		case 2: x = s; y = 1.0f; z = t; break;
+		case 3: x = s; y = -1.0f; z = -t; break;
+		case 4: x = s; y = -t; z = 1.0f; break;
+		default: x = -s; y = -t; z = -1.0f; break;
+		}
+	}
+
+	// running sums for one range of rows, rgb(+unused) per coefficient
+	struct Accumulator {
+#ifdef SH_PROJECTION_SSE2
+		__m128 sums[9];
+		Accumulator() { for (__m128& sum : sums) sum = _mm_setzero_ps(); }
+
+		void add(const float* rgb, const float basis[9], float weight)
+		{
+			__m128 color = _mm_mul_ps(_mm_set_ps(0.0f, rgb[2], rgb[1], rgb[0]), _mm_set1_ps(weight));
+			for (int k = 0; k < 9; k++)
+				sums[k] = _mm_add_ps(sums[k], _mm_mul_ps(color, _mm_set1_ps(basis[k])));
+		}
+
+		glm::vec3 get(int k) const
+		{
+			float values[4];
+			_mm_storeu_ps(values, sums[k]);
+			return glm::vec3(values[0], values[1], values[2]);
+		}
+#else
+		glm::vec3 sums[9] = {};
+
+		void add(const float* rgb, const float basis[9], float weight)
+		{
+			glm::vec3 color = glm::vec3(rgb[0], rgb[1], rgb[2]) * weight;
+			for (int k = 0; k < 9; k++)
+				sums[k] += color * basis[k];
+		}
+
+		glm::vec3 get(int k) const { return sums[k]; }
+#endif
+	};
+}
+
+SH9 projectCubemapSH9(const float* const faces[6], int size, ThreadPool& pool)
+{
+	SH9 result;
+	double totalWeight = 0.0;
+	std::mutex mutex;
+
+	size_t rows = static_cast<size_t>(size) * 6;
+	pool.parallelFor(rows, [&](size_t begin, size_t end) {
+		Accumulator accumulator;
+		double weightSum = 0.0;
+		float basis[9];
+
+		for (size_t row = begin; row < end; row++) {
+			int face = static_cast<int>(row / size);
+			int y = static_cast<int>(row % size);
+			float t = 2.0f * (y + 0.5f) / size - 1.0f;
+			const float* texel = faces[face] + static_cast<size_t>(y) * size * 3;
+
+			for (int x = 0; x < size; x++, texel += 3) {
+				float s = 2.0f * (x + 0.5f) / size - 1.0f;
+				// solid angle of the texel, up to the constant texel area that cancels out below
+				float lengthSquared = 1.0f + s * s + t * t;
+				float weight = 1.0f / (lengthSquared * std::sqrt(lengthSquared));
+
+				float dx, dy, dz;
+				faceDirection(face, s, t, dx, dy, dz);
+				float inverseLength = 1.0f / std::sqrt(lengthSquared);
+				evaluateBasis(dx * inverseLength, dy * inverseLength, dz * inverseLength, basis);
+
+				accumulator.add(texel, basis, weight);
+				weightSum += weight;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int k = 0; k < 9; k++)
+			result.coefficients[k] += accumulator.get(k);
+		totalWeight += weightSum;
+	});
+
+	// the weights have to add up to the full sphere
+	float normalization = totalWeight > 0.0 ? static_cast<float>(4.0 * 3.14159265358979 / totalWeight) : 0.0f;
+	for (glm::vec3& coefficient : result.coefficients)
+		coefficient *= normalization;
+	return result;
+}
+
+SH9 radianceToIrradianceSH9(const SH9& radiance)
+{
+	// clamped cosine band factors pi, 2pi/3 and pi/4 over the 1/pi the diffuse term expects
+	const float bands[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+	SH9 irradiance;
+	for (int k = 0; k < 9; k++)
+		irradiance.coefficients[k] = radiance.coefficients[k] * bands[k];
+	return irradiance;
+}
+
+glm::vec3 evaluateSH9(const SH9& sh, const glm::vec3& direction)
+{
+	float basis[9];
+	evaluateBasis(direction.x, direction.y, direction.z, basis);
+	glm::vec3 value(0.0f);
+	for (int k = 0; k < 9; k++)
+		value += sh.coefficients[k] * basis[k];
+	return value;
+}
+
+SH9Block toSH9Block(const SH9& sh)
+{
+	SH9Block block;
+	for (int k = 0; k < 9; k++)
+		block.coefficients[k] = glm::vec4(sh.coefficients[k], 0.0f);
+	return block;
+}
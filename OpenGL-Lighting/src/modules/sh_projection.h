@@ -0,0 +1,26 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "thread_pool.h"
+
+// first three bands of real spherical harmonics, one rgb value per basis function
+struct SH9 {
+	glm::vec3 coefficients[9] = {};
+};
+
+// std140 layout of the IrradianceSH uniform block, vec3 arrays pad to vec4 anyway
+struct SH9Block {
+	glm::vec4 coefficients[9];
+};
+
+// projects a float rgb cubemap onto SH9. faces are size x size and ordered like
+// GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, every texel is weighted by the solid angle it covers.
+// rows of all six faces are split across pool.
+SH9 projectCubemapSH9(const float* const faces[6], int size, ThreadPool& pool = ThreadPool::shared());
+
+// folds the clamped cosine lobe (divided by pi) into radiance coefficients, evaluating the result
+// gives the same value per normal as the old convolution cubemap
+SH9 radianceToIrradianceSH9(const SH9& radiance);
+
+glm::vec3 evaluateSH9(const SH9& sh, const glm::vec3& direction);
+SH9Block toSH9Block(const SH9& sh);
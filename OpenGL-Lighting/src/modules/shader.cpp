@@ -1,232 +1,346 @@
 #include "shader.h"
+#include "program_cache.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
+#include "frame_data.h"
 
+#include <chrono>
+#include <cstring>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
-{
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-
-	// check ifstream objects if they can throw exceptions
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-	try
-	{
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-
-		vShaderFile.close();
-		fShaderFile.close();
-
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-	}
-	catch (std::ifstream::failure e)
+namespace {
+	std::string readShaderFile(const char* path)
 	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+		std::ifstream shaderFile;
+
+		// check ifstream objects if they can throw exceptions
+		shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+		try
+		{
+			shaderFile.open(path);
+			std::stringstream shaderStream;
+			shaderStream << shaderFile.rdbuf();
+			shaderFile.close();
+			return shaderStream.str();
+		}
+		catch (std::ifstream::failure e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+		}
+		return std::string();
 	}
 
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-
-	// vertex shader
-	unsigned int vertex;
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
-
-	// debugging vertex shader compilation
-	int success;
-	char infoLog[512];
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-
-	if (!success)
+	unsigned int compileStage(GLenum type, const std::string& code, const char* stageName)
 	{
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+		const char* shaderCode = code.c_str();
+		unsigned int shader = glCreateShader(type);
+		glShaderSource(shader, 1, &shaderCode, NULL);
+		glCompileShader(shader);
+
+		int success;
+		char infoLog[512];
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shader, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+		}
+		return shader;
 	}
 
-	// fragment shader
-	unsigned int fragment;
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-
-	if (!success)
+	// #version has to stay the first line, the defines go straight after it
+	std::string injectDefines(const std::string& source, const std::string& preamble)
 	{
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
+		if (preamble.empty()) return source;
 
-	ID = glCreateProgram();
-	glAttachShader(ID, vertex);
-	glAttachShader(ID, fragment);
-	glLinkProgram(ID);
-
-	glGetShaderiv(ID, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
+		size_t version = source.find("#version");
+		if (version == std::string::npos) return preamble + source;
+		size_t lineEnd = source.find('\n', version);
+		if (lineEnd == std::string::npos) return source + "\n" + preamble;
+		return source.substr(0, lineEnd + 1) + preamble + source.substr(lineEnd + 1);
 	}
+}
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+ShaderDefines& ShaderDefines::define(const std::string& name, const std::string& value)
+{
+	values[name] = value;
+	return *this;
 }
 
-Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath)
+ShaderDefines& ShaderDefines::define(const std::string& name, int value)
 {
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::string geometryCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
-	std::ifstream gShaderFile;
+	return define(name, std::to_string(value));
+}
 
-	// check ifstream objects if they can throw exceptions
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+std::string ShaderDefines::key() const
+{
+	std::string key;
+	for (const auto& value : values)
+		key += (key.empty() ? "" : ";") + value.first + "=" + value.second;
+	return key;
+}
 
-	try
-	{
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		gShaderFile.open(geometryPath);
-		std::stringstream vShaderStream, fShaderStream, gShaderStream;
-
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		gShaderStream << gShaderFile.rdbuf();
-
-		vShaderFile.close();
-		fShaderFile.close();
-		gShaderFile.close();
-
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-		geometryCode = gShaderStream.str();
-	}
-	catch (std::ifstream::failure e)
-	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
-	}
+std::string ShaderDefines::preamble() const
+{
+	std::string preamble;
+	for (const auto& value : values)
+		preamble += "#define " + value.first + " " + value.second + "\n";
+	return preamble;
+}
 
-	const char* vShaderCode = vertexCode.c_str();
-	const char* fShaderCode = fragmentCode.c_str();
-	const char* gShaderCode = geometryCode.c_str();
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines)
+{
+	build({ vertexPath, fragmentPath }, { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER }, defines);
+}
 
-	// vertex shader
-	unsigned int vertex;
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
+Shader::Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath, const ShaderDefines& defines)
+{
+	build({ vertexPath, geometryPath, fragmentPath }, { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER }, defines);
+}
 
-	// debugging vertex shader compilation
-	int success;
-	char infoLog[512];
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+void Shader::build(const std::vector<std::string>& paths, const std::vector<GLenum>& types, const ShaderDefines& defines)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string preamble = defines.preamble();
+	std::vector<std::string> sources;
+	std::string name;
+	for (const std::string& path : paths) {
+		sources.push_back(injectDefines(readShaderFile(path.c_str()), preamble));
+		name += (name.empty() ? "" : " + ") + path;
+	}
+	if (!defines.empty())
+		name += " [" + defines.key() + "]";
+
+	// the program binary is only tried once every source is known, an edit anywhere misses.
+	// every variant of the same files gets its own cache file.
+	ProgramCache& cache = ProgramCache::instance();
+	std::vector<std::string> cacheKey = paths;
+	if (!defines.empty())
+		cacheKey.push_back(defines.key());
+	std::string cachePath = cache.cachePathFor(cacheKey);
+	uint64_t sourceHash = cache.hashSources(sources);
 
-	if (!success)
+	ID = glCreateProgram();
+	bool fromCache = cache.load(cachePath, sourceHash, ID);
+	if (!fromCache)
 	{
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+		std::vector<unsigned int> stages;
+		for (size_t i = 0; i < sources.size(); i++) {
+			const char* stageName = types[i] == GL_VERTEX_SHADER ? "VERTEX" : types[i] == GL_GEOMETRY_SHADER ? "GEOMETRY" : "FRAGMENT";
+			stages.push_back(compileStage(types[i], sources[i], stageName));
+			glAttachShader(ID, stages.back());
+		}
+
+		if (cache.isEnabled())
+			glext::ProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(ID);
+
+		int success;
+		char infoLog[512];
+		glGetProgramiv(ID, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			glGetProgramInfoLog(ID, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
+		}
+		else
+			cache.store(cachePath, sourceHash, ID);
+
+		for (unsigned int stage : stages) {
+			glDetachShader(ID, stage);
+			glDeleteShader(stage);
+		}
 	}
 
-	// fragment shader
-	unsigned int fragment;
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
+	reflectUniforms();
 
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	// the camera block is shared by every program at a fixed binding
+	GLuint frameBlock = glGetUniformBlockIndex(ID, "FrameData");
+	if (frameBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(ID, frameBlock, FRAME_DATA_BINDING);
 
-	if (!success)
-	{
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+	auto end = std::chrono::high_resolution_clock::now();
+	cache.recordTiming(name, std::chrono::duration<double, std::milli>(end - start).count(), fromCache);
+}
+
+void Shader::reflectUniforms()
+{
+	uniforms = std::make_shared<UniformTable>();
+
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+
+	auto addSlot = [this](const std::string& name, GLint location) {
+		uniforms->slots[name] = static_cast<int>(uniforms->values.size());
+		uniforms->values.push_back({ location, {}, false });
+	};
+
+	for (GLint i = 0; i < count; i++) {
+		GLint size = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+		glGetActiveUniform(ID, i, static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), length);
+
+		// uniform block members have no location
+		GLint location = glGetUniformLocation(ID, name.c_str());
+		if (location < 0) continue;
+
+		// arrays of plain types are reported once as "name[0]"
+		bool isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+		if (!isArray) {
+			addSlot(name, location);
+			continue;
+		}
+
+		// "name" and "name[0]" are the same location, so they share one slot and one cached value
+		std::string base = name.substr(0, name.size() - 3);
+		addSlot(base, location);
+		uniforms->slots[base + "[0]"] = uniforms->slots[base];
+		for (GLint element = 1; element < size; element++) {
+			std::string elementName = base + "[" + std::to_string(element) + "]";
+			GLint elementLocation = glGetUniformLocation(ID, elementName.c_str());
+			if (elementLocation >= 0)
+				addSlot(elementName, elementLocation);
+		}
 	}
 
-	// geometry shader
-	unsigned int geometry;
-	geometry = glCreateShader(GL_GEOMETRY_SHADER);
-	glShaderSource(geometry, 1, &gShaderCode, NULL);
-	glCompileShader(geometry);
+	uniforms->modelSlot = findSlot("model");
+	uniforms->normalMatrixSlot = findSlot("normalMatrix");
+}
+
+int Shader::findSlot(const std::string& name) const
+{
+	auto it = uniforms->slots.find(name);
+	return it != uniforms->slots.end() ? it->second : -1;
+}
 
-	glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
+bool Shader::updateCache(int slot, const void* value, size_t size) const
+{
+	if (slot < 0) return false;
 
-	if (!success)
-	{
-		glGetShaderInfoLog(geometry, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n" << infoLog << std::endl;
+	UniformSlot& uniform = uniforms->values[slot];
+	if (uniform.hasValue && std::memcmp(uniform.value, value, size) == 0) {
+		uniformStats().skipped++;
+		return false;
 	}
 
-	ID = glCreateProgram();
-	glAttachShader(ID, vertex);
-	glAttachShader(ID, geometry);
-	glAttachShader(ID, fragment);
-	glLinkProgram(ID);
+	std::memcpy(uniform.value, value, size);
+	uniform.hasValue = true;
+	uniformStats().uploads++;
+	return true;
+}
 
-	glGetShaderiv(ID, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(ID, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
+Shader::UniformStats& Shader::uniformStats()
+{
+	static UniformStats stats;
+	return stats;
+}
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
-	glDeleteShader(geometry);
+void Shader::printUniformStats(unsigned int frameCount)
+{
+	UniformStats& stats = uniformStats();
+	if (frameCount > 0)
+		std::cout << "uniforms per frame: " << stats.uploads / frameCount << " uploaded, " << stats.skipped / frameCount << " skipped" << std::endl;
+	stats = UniformStats();
 }
 
 void Shader::use()
 {
-	glUseProgram(ID);
+	glstate::UseProgram(ID);
 }
 void Shader::setBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	set(UniformHandle<int>{ findSlot(name) }, (int)value);
 }
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	set(UniformHandle<int>{ findSlot(name) }, value);
 }
 void Shader::setFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	set(UniformHandle<float>{ findSlot(name) }, value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& vec) const
 {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y);
+	set(UniformHandle<glm::vec2>{ findSlot(name) }, vec);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	set(UniformHandle<glm::vec3>{ findSlot(name) }, glm::vec3(x, y, z));
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& vec) const
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y, vec.z);
+	set(UniformHandle<glm::vec3>{ findSlot(name) }, vec);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& vec) const
 {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), vec.x, vec.y, vec.z, vec.w);
+	set(UniformHandle<glm::vec4>{ findSlot(name) }, vec);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	set(UniformHandle<glm::mat4>{ findSlot(name) }, mat);
 }
 
+void Shader::setModel(const glm::mat4& model) const
+{
+	int slot = uniforms->modelSlot;
+	if (!updateCache(slot, &model[0][0], sizeof(float) * 16)) return;
+	glUniformMatrix4fv(uniforms->values[slot].location, 1, GL_FALSE, &model[0][0]);
+
+	if (uniforms->normalMatrixSlot >= 0)
+		set(UniformHandle<glm::mat3>{ uniforms->normalMatrixSlot }, glm::transpose(glm::inverse(glm::mat3(model))));
+}
 
+void Shader::set(UniformHandle<int> uniform, int value) const
+{
+	if (updateCache(uniform.slot, &value, sizeof(value)))
+		glUniform1i(uniforms->values[uniform.slot].location, value);
+}
+
+void Shader::set(UniformHandle<float> uniform, float value) const
+{
+	if (updateCache(uniform.slot, &value, sizeof(value)))
+		glUniform1f(uniforms->values[uniform.slot].location, value);
+}
+
+void Shader::set(UniformHandle<glm::vec2> uniform, const glm::vec2& vec) const
+{
+	float value[2] = { vec.x, vec.y };
+	if (updateCache(uniform.slot, value, sizeof(value)))
+		glUniform2f(uniforms->values[uniform.slot].location, vec.x, vec.y);
+}
+
+void Shader::set(UniformHandle<glm::vec3> uniform, const glm::vec3& vec) const
+{
+	float value[3] = { vec.x, vec.y, vec.z };
+	if (updateCache(uniform.slot, value, sizeof(value)))
+		glUniform3f(uniforms->values[uniform.slot].location, vec.x, vec.y, vec.z);
+}
+
+void Shader::set(UniformHandle<glm::vec4> uniform, const glm::vec4& vec) const
+{
+	float value[4] = { vec.x, vec.y, vec.z, vec.w };
+	if (updateCache(uniform.slot, value, sizeof(value)))
+		glUniform4f(uniforms->values[uniform.slot].location, vec.x, vec.y, vec.z, vec.w);
+}
+
+void Shader::set(UniformHandle<glm::mat3> uniform, const glm::mat3& mat) const
+{
+	if (updateCache(uniform.slot, &mat[0][0], sizeof(float) * 9))
+		glUniformMatrix3fv(uniforms->values[uniform.slot].location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::set(UniformHandle<glm::mat4> uniform, const glm::mat4& mat) const
+{
+	if (updateCache(uniform.slot, &mat[0][0], sizeof(float) * 16))
+		glUniformMatrix4fv(uniforms->values[uniform.slot].location, 1, GL_FALSE, &mat[0][0]);
+}
\ No newline at end of file
@@ -6,11 +6,38 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <memory>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// uniform location resolved once, T is the type it gets set as
+template <typename T>
+struct UniformHandle {
+	int slot = -1;
+	bool valid() const { return slot >= 0; }
+};
+
+// feature key of a shader variant, defines and compile time constants that go in right after #version.
+// kept sorted by name so the same set always gives the same key whatever order it was built in.
+class ShaderDefines {
+public:
+	ShaderDefines& define(const std::string& name, const std::string& value = "1");
+	ShaderDefines& define(const std::string& name, int value);
+
+	bool empty() const { return values.empty(); }
+	// "KERNEL_SIZE=16;NR_LIGHTS=32", empty without defines
+	std::string key() const;
+	// one #define line per entry
+	std::string preamble() const;
+
+private:
+	std::map<std::string, std::string> values;
+};
 
 class Shader
 {
@@ -19,10 +46,10 @@ public:
 	unsigned int ID;
 
 	// vert and frag shader constructor. Paths should start at root directory.
-	Shader(const char* vertexPath, const char* fragmentPath);
+	Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines = ShaderDefines());
 
 	// vert, geom, and frag shader constructor
-	Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath);
+	Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath, const ShaderDefines& defines = ShaderDefines());
 
 	// use and activate the shader
 	void use();
@@ -36,4 +63,54 @@ public:
 	void setVec3(const std::string& name, const glm::vec3& vec) const;
 	void setVec4(const std::string& name, const glm::vec4& vec) const;
 	void setMat4(const std::string& name, const glm::mat4& mat) const;
+	// "model" and, when the program declares it, the mat3 "normalMatrix" worked out from it here instead of per vertex.
+	// an unchanged model skips both.
+	void setModel(const glm::mat4& model) const;
+
+	// every active uniform is reflected after link, array elements get their own entry ("samples[3]"),
+	// the bare array name and its [0] entry give the same handle.
+	// unknown or inactive names give an invalid handle and setting it does nothing.
+	template <typename T>
+	UniformHandle<T> getUniform(const std::string& name) const { return UniformHandle<T>{ findSlot(name) }; }
+
+	// glUniform is skipped when the value matches the last one set on this program
+	void set(UniformHandle<int> uniform, int value) const;
+	void set(UniformHandle<float> uniform, float value) const;
+	void set(UniformHandle<glm::vec2> uniform, const glm::vec2& vec) const;
+	void set(UniformHandle<glm::vec3> uniform, const glm::vec3& vec) const;
+	void set(UniformHandle<glm::vec4> uniform, const glm::vec4& vec) const;
+	void set(UniformHandle<glm::mat3> uniform, const glm::mat3& mat) const;
+	void set(UniformHandle<glm::mat4> uniform, const glm::mat4& mat) const;
+
+	// glUniform calls issued and skipped by every Shader since the last reset
+	struct UniformStats {
+		unsigned long long uploads = 0;
+		unsigned long long skipped = 0;
+	};
+	static UniformStats& uniformStats();
+	// prints the per frame averages over frameCount frames and resets the counters
+	static void printUniformStats(unsigned int frameCount);
+
+private:
+	struct UniformSlot {
+		GLint location;
+		float value[16];
+		bool hasValue;
+	};
+	// shared so copies of a Shader agree on what the program currently holds
+	struct UniformTable {
+		std::unordered_map<std::string, int> slots;
+		std::vector<UniformSlot> values;
+		int modelSlot = -1;
+		int normalMatrixSlot = -1;
+	};
+	std::shared_ptr<UniformTable> uniforms;
+
+	void reflectUniforms();
+	int findSlot(const std::string& name) const;
+	// true when value differs from the cached one, which it then replaces
+	bool updateCache(int slot, const void* value, size_t size) const;
+
+	// reads every stage and injects the defines, then links from the program binary cache or compiles on a miss
+	void build(const std::vector<std::string>& paths, const std::vector<GLenum>& types, const ShaderDefines& defines);
 };
\ No newline at end of file
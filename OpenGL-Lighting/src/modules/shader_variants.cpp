@@ -0,0 +1,55 @@
+#include "shader_variants.h"
+#include "program_cache.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath)
+	: vertexPath(vertexPath), fragmentPath(fragmentPath)
+{
+}
+
+ShaderVariants::ShaderVariants(const std::string& vertexPath, const std::string& geometryPath, const std::string& fragmentPath)
+	: vertexPath(vertexPath), geometryPath(geometryPath), fragmentPath(fragmentPath)
+{
+}
+
+Shader& ShaderVariants::get(const ShaderDefines& defines)
+{
+	std::string key = defines.key();
+	auto it = variants.find(key);
+	if (it != variants.end()) return it->second;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	Shader shader = geometryPath.empty()
+		? Shader(vertexPath.c_str(), fragmentPath.c_str(), defines)
+		: Shader(vertexPath.c_str(), geometryPath.c_str(), fragmentPath.c_str(), defines);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	Stats& total = stats();
+	total.built++;
+	total.ms += std::chrono::duration<double, std::milli>(end - start).count();
+	const std::vector<ProgramCache::Timing>& timings = ProgramCache::instance().getTimings();
+	if (!timings.empty() && timings.back().fromCache)
+		total.fromCache++;
+
+	return variants.emplace(key, shader).first->second;
+}
+
+ShaderVariants::Stats& ShaderVariants::stats()
+{
+	static Stats total;
+	return total;
+}
+
+void ShaderVariants::printStats()
+{
+	const Stats& total = stats();
+	// a local stream, the fixed precision stays off std::cout
+	std::ostringstream line;
+	line << "shader variants: " << total.built << " built (" << total.fromCache << " from cache) in "
+		<< std::fixed << std::setprecision(2) << total.ms << " ms";
+	std::cout << line.str() << std::endl;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+
+#include "shader.h"
+
+// specializations of one set of stage files, each built on the first request for its feature key and
+// kept for the lifetime of the object. loop counts and feature toggles become compile time constants
+// so the hot loops in the variant carry no uniform branches.
+class ShaderVariants {
+public:
+	ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath);
+	ShaderVariants(const std::string& vertexPath, const std::string& geometryPath, const std::string& fragmentPath);
+
+	// builds the variant if this key hasn't been seen yet, the reference stays valid after later builds
+	Shader& get(const ShaderDefines& defines);
+	size_t size() const { return variants.size(); }
+
+	// variants built by every ShaderVariants, with the time spent building them
+	struct Stats {
+		unsigned int built = 0;
+		unsigned int fromCache = 0; // loaded as a program binary instead of compiled
+		double ms = 0.0;
+	};
+	static Stats& stats();
+	static void printStats();
+
+private:
+	std::string vertexPath;
+	std::string geometryPath;
+	std::string fragmentPath;
+	std::unordered_map<std::string, Shader> variants;
+};
@@ -18,6 +18,8 @@ const std::unordered_map<GLenum, GLenum> Texture::sizedFormatToType = {
     { GL_RG8,            GL_UNSIGNED_BYTE },
     { GL_RGB8,           GL_UNSIGNED_BYTE },
     { GL_RGBA8,          GL_UNSIGNED_BYTE },
+    { GL_SRGB8,          GL_UNSIGNED_BYTE },
+    { GL_SRGB8_ALPHA8,   GL_UNSIGNED_BYTE },
     { GL_R16F,           GL_FLOAT },
     { GL_RG16F,          GL_FLOAT },
     { GL_RGB16F,         GL_FLOAT },
@@ -8,6 +8,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <unordered_map>
 
+#include "gl_extensions.h"
+#include "gl_state.h"
+
 class Texture {
 public:
 	unsigned int id;
@@ -19,19 +22,19 @@ public:
 	// base constructor
 	Texture(int width, int height, GLenum internalFormat, GLenum baseFormat, const GLvoid* data = NULL) : width(width), height(height) {
 		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
 		GLenum type = getDataType(internalFormat);
 		if (type != -1)
 			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, baseFormat, type, data);
 		else
 			std::cerr << "Error: internal format not supported." << std::endl;
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate::BindTexture(GL_TEXTURE_2D, 0);
 	}
 
 	// overloaded constructor if they can provide the filter and wrap
 	Texture(int width, int height, GLenum internalFormat, GLenum baseFormat, GLint filter, GLint wrap, const GLvoid* data = NULL) : width(width), height(height) {
 		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
 		GLenum type = getDataType(internalFormat);
 		if (type != -1)
 			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, baseFormat, type, data);
@@ -39,29 +42,82 @@ public:
 			std::cerr << "Error: internal format not supported." << std::endl;
 		setTexFilter(filter);
 		setTexWrap(wrap);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate::BindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	// pre-mipped constructor, levels[i] points at mip i with rows aligned to 4 bytes. internalFormat has to be
+	// sized. storage is immutable when glTexStorage2D is available, otherwise every level is specified once.
+	Texture(int width, int height, GLenum internalFormat, GLenum baseFormat, GLint wrap, int levelCount, const GLvoid* const* levels) : width(width), height(height) {
+		glGenTextures(1, &id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
+		GLenum type = getDataType(internalFormat);
+		if (type == -1) {
+			std::cerr << "Error: internal format not supported." << std::endl;
+			glstate::BindTexture(GL_TEXTURE_2D, 0);
+			return;
+		}
+
+		bool immutable = glext::hasTextureStorage();
+		if (immutable)
+			glext::TexStorage2D(GL_TEXTURE_2D, levelCount, internalFormat, width, height);
+		for (int level = 0; level < levelCount; level++) {
+			int levelWidth = width >> level > 0 ? width >> level : 1;
+			int levelHeight = height >> level > 0 ? height >> level : 1;
+			if (immutable)
+				glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, baseFormat, type, levels[level]);
+			else
+				glTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0, baseFormat, type, levels[level]);
+		}
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		setTexWrap(wrap);
+	}
+
+	// block compressed constructor, levels[i] holds levelSizes[i] bytes of mip i already encoded in compressedFormat
+	Texture(int width, int height, GLenum compressedFormat, GLint wrap, int levelCount, const GLvoid* const* levels, const GLsizei* levelSizes) : width(width), height(height) {
+		glGenTextures(1, &id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
+
+		bool immutable = glext::hasTextureStorage();
+		if (immutable)
+			glext::TexStorage2D(GL_TEXTURE_2D, levelCount, compressedFormat, width, height);
+		for (int level = 0; level < levelCount; level++) {
+			int levelWidth = width >> level > 0 ? width >> level : 1;
+			int levelHeight = height >> level > 0 ? height >> level : 1;
+			if (immutable)
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, compressedFormat, levelSizes[level], levels[level]);
+			else
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat, levelWidth, levelHeight, 0, levelSizes[level], levels[level]);
+		}
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		setTexWrap(wrap);
 	}
 
 	void setTexFilter(GLint filter) {
-		glBindTexture(GL_TEXTURE_2D, id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 		unbind();
 	}
 
 	void setTexWrap(GLint wrap) {
-		glBindTexture(GL_TEXTURE_2D, id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 		unbind();
 	}
 
 	void bind() {
-		glBindTexture(GL_TEXTURE_2D, id);
+		glstate::BindTexture(GL_TEXTURE_2D, id);
 	}
 
 	void unbind() {
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate::BindTexture(GL_TEXTURE_2D, 0);
 	}
 
 	void genMipMap() {
@@ -0,0 +1,129 @@
+#include "texture_cache.h"
+#include "gl_state.h"
+
+#include <vector>
+#include <cctype>
+
+TextureCache& TextureCache::instance()
+{
+	static TextureCache cache;
+	return cache;
+}
+
+unsigned int TextureCache::acquire(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr)
+{
+	auto it = entries.find(makeKey(path, space, flipVertically, hdr));
+	if (it == entries.end()) {
+		stats.misses++;
+		return 0;
+	}
+
+	it->second.refCount++;
+	stats.hits++;
+	stats.bytesSaved += it->second.bytes;
+	return it->second.textureID;
+}
+
+unsigned int TextureCache::insert(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr, unsigned int textureID, size_t bytes)
+{
+	if (textureID == 0) return 0;
+
+	std::string key = makeKey(path, space, flipVertically, hdr);
+	auto it = entries.find(key);
+	if (it != entries.end()) {
+		// already cached, keep the first upload
+		it->second.refCount++;
+		if (it->second.textureID != textureID)
+			glstate::DeleteTextures(1, &textureID);
+		return it->second.textureID;
+	}
+
+	entries[key] = { textureID, 1, bytes };
+	keysByID[textureID] = key;
+	stats.residentBytes += bytes;
+	stats.textureCount++;
+	return textureID;
+}
+
+void TextureCache::release(unsigned int textureID)
+{
+	auto keyIt = keysByID.find(textureID);
+	if (keyIt == keysByID.end()) return;
+
+	auto it = entries.find(keyIt->second);
+	if (it != entries.end() && --it->second.refCount == 0) {
+		glstate::DeleteTextures(1, &textureID);
+		stats.residentBytes -= it->second.bytes;
+		stats.textureCount--;
+		entries.erase(it);
+		keysByID.erase(keyIt);
+	}
+}
+
+void TextureCache::printStats() const
+{
+	std::cout << "TextureCache: " << stats.textureCount << " textures, "
+		<< stats.hits << " hits, " << stats.misses << " misses, "
+		<< stats.residentBytes / (1024.0 * 1024.0) << " MB resident, "
+		<< stats.bytesSaved / (1024.0 * 1024.0) << " MB saved" << std::endl;
+}
+
+std::string TextureCache::canonicalPath(const std::string& path)
+{
+	std::string normalized = path;
+	for (char& c : normalized) {
+		if (c == '\\') c = '/';
+#ifdef _WIN32
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+#endif
+	}
+
+	bool absolute = !normalized.empty() && normalized[0] == '/';
+	std::vector<std::string> segments;
+	size_t start = 0;
+	while (start <= normalized.size()) {
+		size_t end = normalized.find('/', start);
+		if (end == std::string::npos) end = normalized.size();
+		std::string segment = normalized.substr(start, end - start);
+
+		if (segment == "..") {
+			if (!segments.empty() && segments.back() != "..")
+				segments.pop_back();
+			else if (!absolute)
+				segments.push_back(segment);
+		}
+		else if (!segment.empty() && segment != ".") {
+			segments.push_back(segment);
+		}
+		start = end + 1;
+	}
+
+	std::string result = absolute ? "/" : "";
+	for (size_t i = 0; i < segments.size(); i++) {
+		if (i > 0) result += '/';
+		result += segments[i];
+	}
+	return result;
+}
+
+size_t TextureCache::estimateImageBytes(const DecodedImage& image)
+{
+	size_t pixels = static_cast<size_t>(image.width) * static_cast<size_t>(image.height);
+
+	// hdr images go up as RGB16F without mips
+	if (image.hdr)
+		return pixels * 3 * 2;
+
+	// a full mip chain adds roughly a third on top of the base level
+	size_t base = pixels * static_cast<size_t>(image.channels);
+	return base + base / 3;
+}
+
+std::string TextureCache::makeKey(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr)
+{
+	std::string key = canonicalPath(path);
+	key += space == TextureColorSpace::sRGB ? "|srgb" : "|linear";
+	key += flipVertically ? "|flip" : "|noflip";
+	key += hdr ? "|hdr" : "|ldr";
+	return key;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+
+#include "utils.h"
+
+// process-wide texture dedup. textures are keyed by canonical path + color space + flip flag + hdr flag
+// and reference counted, so two models (or two loadTexture calls) sharing a file upload it once.
+// only ever touched from the thread that owns the GL context.
+class TextureCache {
+public:
+	struct Stats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t bytesSaved = 0;    // bytes that would have been uploaded again without the cache
+		size_t residentBytes = 0; // estimated vram of everything currently cached (mips included)
+		size_t textureCount = 0;
+	};
+
+	static TextureCache& instance();
+
+	// returns the cached texture and takes a reference, 0 on a miss
+	unsigned int acquire(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr);
+	// registers a freshly uploaded texture with a single reference and returns the id to use. if the
+	// key was inserted meanwhile (two streamed uploads of one file) the new texture is dropped.
+	unsigned int insert(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr, unsigned int textureID, size_t bytes);
+	// drops a reference, the texture is deleted once nothing uses it anymore
+	void release(unsigned int textureID);
+
+	const Stats& getStats() const { return stats; }
+	void printStats() const;
+
+	// lexical normalization: forward slashes, no "." or "dir/.." segments, lower case on windows
+	static std::string canonicalPath(const std::string& path);
+	static std::string makeKey(const std::string& path, TextureColorSpace space, bool flipVertically, bool hdr);
+	// estimated vram of the texture createTextureFromImage makes from this image
+	static size_t estimateImageBytes(const DecodedImage& image);
+
+private:
+	struct Entry {
+		unsigned int textureID;
+		unsigned int refCount;
+		size_t bytes;
+	};
+
+	std::unordered_map<std::string, Entry> entries;
+	std::unordered_map<unsigned int, std::string> keysByID;
+	Stats stats;
+};
@@ -0,0 +1,220 @@
+#include "texture_streamer.h"
+#include "texture_cache.h"
+#include "gl_state.h"
+
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+TextureStreamer& TextureStreamer::instance()
+{
+	static TextureStreamer streamer;
+	return streamer;
+}
+
+TextureStreamer::TextureStreamer() : state(std::make_shared<SharedState>())
+{
+}
+
+void TextureStreamer::request(const std::string& path, bool flipVertically, TextureColorSpace space, bool hdr,
+	const void* owner, ResidentCallback onResident)
+{
+	stats.requested++;
+
+	unsigned int cached = TextureCache::instance().acquire(path, space, flipVertically, hdr);
+	if (cached != 0) {
+		stats.completed++;
+		onResident(cached);
+		return;
+	}
+
+	uint64_t request = nextRequest++;
+	Upload& upload = uploads[request];
+	upload.path = path;
+	upload.flipVertically = flipVertically;
+	upload.hdr = hdr;
+	upload.space = space;
+	upload.owner = owner;
+	upload.onResident = onResident;
+	stats.pending = uploads.size();
+
+	std::shared_ptr<SharedState> shared = state;
+	ThreadPool::shared().enqueue([shared, request, path, flipVertically, hdr]() {
+		DecodedImage image = decodeImage(path, flipVertically, hdr);
+		{
+			std::lock_guard<std::mutex> lock(shared->mutex);
+			shared->done.push_back({ request, std::move(image) });
+		}
+		shared->condition.notify_one();
+	});
+}
+
+void TextureStreamer::cancel(const void* owner)
+{
+	for (auto it = uploads.begin(); it != uploads.end();) {
+		if (it->second.owner != owner) {
+			++it;
+			continue;
+		}
+
+		if (it->second.texture != 0)
+			glstate::DeleteTextures(1, &it->second.texture);
+		for (auto queued = uploadQueue.begin(); queued != uploadQueue.end(); ++queued) {
+			if (*queued == it->first) {
+				uploadQueue.erase(queued);
+				break;
+			}
+		}
+		it = uploads.erase(it);
+	}
+	stats.pending = uploads.size();
+}
+
+void TextureStreamer::update()
+{
+	collectDecodes(false);
+
+	if (pbos[0] == 0)
+		glGenBuffers(PBO_RING_SIZE, pbos);
+
+	// stb rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t used = 0;
+	while (used < frameBudget && !uploadQueue.empty()) {
+		auto it = uploads.find(uploadQueue.front());
+		Upload& upload = it->second;
+
+		used += streamRows(upload, frameBudget - used);
+		if (upload.nextRow == upload.image.height) {
+			// off the books before the callback runs, it may queue or cancel other requests
+			Upload finished = std::move(upload);
+			uploads.erase(it);
+			uploadQueue.pop_front();
+			completeUpload(finished);
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	stats.lastFrameBytes = used;
+	stats.bytesUploaded += used;
+	stats.pending = uploads.size();
+}
+
+void TextureStreamer::finish()
+{
+	size_t budget = frameBudget;
+	frameBudget = std::numeric_limits<size_t>::max();
+	while (!uploads.empty()) {
+		if (uploadQueue.empty())
+			collectDecodes(true);
+		update();
+	}
+	frameBudget = budget;
+}
+
+unsigned int TextureStreamer::getPlaceholder()
+{
+	if (placeholder == 0)
+		placeholder = createDefaultTexture();
+	return placeholder;
+}
+
+void TextureStreamer::collectDecodes(bool wait)
+{
+	std::deque<Decoded> done;
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		if (wait)
+			state->condition.wait(lock, [this]() { return !state->done.empty(); });
+		done.swap(state->done);
+	}
+
+	for (Decoded& decoded : done) {
+		auto it = uploads.find(decoded.request);
+		if (it == uploads.end()) continue; // cancelled while decoding
+
+		Upload& upload = it->second;
+		if (!decoded.image.valid()) {
+			std::cout << "Failed to stream texture at path: " << upload.path << std::endl;
+			uploads.erase(it);
+			continue;
+		}
+
+		upload.image = std::move(decoded.image);
+
+		GLenum internalFormat;
+		textureFormatsForImage(upload.image, upload.space, internalFormat, upload.baseFormat);
+		upload.dataType = upload.image.hdr ? GL_FLOAT : GL_UNSIGNED_BYTE;
+		upload.rowBytes = static_cast<size_t>(upload.image.width) * upload.image.channels * (upload.image.hdr ? sizeof(float) : 1);
+
+		// storage only, rows arrive over the next frames. nothing samples it until it is complete.
+		glGenTextures(1, &upload.texture);
+		glstate::BindTexture(GL_TEXTURE_2D, upload.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, upload.image.width, upload.image.height, 0, upload.baseFormat, upload.dataType, NULL);
+		glstate::BindTexture(GL_TEXTURE_2D, 0);
+
+		uploadQueue.push_back(decoded.request);
+	}
+}
+
+size_t TextureStreamer::streamRows(Upload& upload, size_t budget)
+{
+	// always make progress, even if a single row is larger than what's left of the budget
+	size_t rows = budget / upload.rowBytes;
+	if (rows == 0) rows = 1;
+	rows = std::min(rows, static_cast<size_t>(upload.image.height - upload.nextRow));
+	size_t bytes = rows * upload.rowBytes;
+	const unsigned char* source = static_cast<const unsigned char*>(upload.image.data) + upload.nextRow * upload.rowBytes;
+
+	glstate::BindTexture(GL_TEXTURE_2D, upload.texture);
+
+	// orphan the next buffer in the ring so the driver never waits on a transfer still in flight
+	glstate::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+	nextPbo = (nextPbo + 1) % PBO_RING_SIZE;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped) {
+		memcpy(mapped, source, bytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.nextRow, upload.image.width, static_cast<GLsizei>(rows),
+			upload.baseFormat, upload.dataType, (const void*)0);
+		glstate::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	else {
+		glstate::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.nextRow, upload.image.width, static_cast<GLsizei>(rows),
+			upload.baseFormat, upload.dataType, source);
+	}
+
+	glstate::BindTexture(GL_TEXTURE_2D, 0);
+	upload.nextRow += static_cast<int>(rows);
+	return bytes;
+}
+
+void TextureStreamer::completeUpload(Upload& upload)
+{
+	glstate::BindTexture(GL_TEXTURE_2D, upload.texture);
+	if (upload.image.hdr) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	else {
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+	glstate::BindTexture(GL_TEXTURE_2D, 0);
+
+	unsigned int textureID = TextureCache::instance().insert(upload.path, upload.space, upload.flipVertically, upload.hdr,
+		upload.texture, TextureCache::estimateImageBytes(upload.image));
+	upload.image.release();
+	stats.completed++;
+
+	upload.onResident(textureID);
+}
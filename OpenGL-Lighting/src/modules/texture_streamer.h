@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "utils.h"
+
+// streams textures in the background so loading never blocks on glTexImage2D + glGenerateMipmap.
+// decodes run on the shared worker pool, pixels go up through a small ring of orphaned pixel unpack
+// buffers a few rows at a time, capped at a per-frame byte budget. until a texture is fully resident
+// its users sample the 1x1 placeholder, then onResident hands them the real id.
+//
+//   TextureStreamer::instance().request(path, false, TextureColorSpace::sRGB, this,
+//       [&](unsigned int id) { diffuse = id; });
+//   while (running) { TextureStreamer::instance().update(); ... }
+class TextureStreamer {
+public:
+	typedef std::function<void(unsigned int textureID)> ResidentCallback;
+
+	struct Stats {
+		size_t requested = 0;
+		size_t completed = 0;
+		size_t bytesUploaded = 0;
+		size_t lastFrameBytes = 0;
+		size_t pending = 0;
+	};
+
+	static constexpr size_t DEFAULT_FRAME_BUDGET = 4 * 1024 * 1024;
+	static constexpr unsigned int PBO_RING_SIZE = 3;
+
+	static TextureStreamer& instance();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// queues a texture. cache hits call onResident immediately, the returned texture then holds a
+	// TextureCache reference either way. owner only tags the request for cancel().
+	void request(const std::string& path, bool flipVertically, TextureColorSpace space, bool hdr,
+		const void* owner, ResidentCallback onResident);
+
+	// drops every request made by owner, callbacks for them never run
+	void cancel(const void* owner);
+
+	// uploads at most the frame budget, call once per frame on the context thread
+	void update();
+	// blocks until every queued texture is resident, ignoring the budget
+	void finish();
+	bool idle() const { return uploads.empty(); }
+
+	// shared 1x1 white texture sampled while uploads are in flight
+	unsigned int getPlaceholder();
+
+	void setFrameBudget(size_t bytes) { frameBudget = bytes > 0 ? bytes : 1; }
+	size_t getFrameBudget() const { return frameBudget; }
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct Upload {
+		std::string path;
+		bool flipVertically;
+		bool hdr;
+		TextureColorSpace space;
+		const void* owner;
+		ResidentCallback onResident;
+
+		DecodedImage image;
+		unsigned int texture = 0;
+		GLenum baseFormat = GL_RGB;
+		GLenum dataType = GL_UNSIGNED_BYTE;
+		size_t rowBytes = 0;
+		int nextRow = 0;
+	};
+	struct Decoded {
+		uint64_t request;
+		DecodedImage image;
+	};
+	struct SharedState {
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<Decoded> done;
+	};
+
+	TextureStreamer();
+
+	std::unordered_map<uint64_t, Upload> uploads;
+	std::deque<uint64_t> uploadQueue; // decoded requests in arrival order, the front one is streaming
+	std::shared_ptr<SharedState> state;
+	uint64_t nextRequest = 1;
+
+	unsigned int pbos[PBO_RING_SIZE] = {};
+	unsigned int nextPbo = 0;
+	unsigned int placeholder = 0;
+	size_t frameBudget = DEFAULT_FRAME_BUDGET;
+	Stats stats;
+
+	void collectDecodes(bool wait);
+	// returns the bytes uploaded for the front request
+	size_t streamRows(Upload& upload, size_t budget);
+	void completeUpload(Upload& upload);
+};
@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0) {
+		unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	condition.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn)
+{
+	if (count == 0) return;
+
+	size_t rangeCount = std::min(count, static_cast<size_t>(size()) + 1);
+	size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+	rangeCount = (count + rangeSize - 1) / rangeSize;
+
+	std::mutex doneMutex;
+	std::condition_variable doneCondition;
+	size_t remaining = rangeCount - 1;
+
+	for (size_t r = 1; r < rangeCount; r++) {
+		size_t begin = r * rangeSize;
+		size_t end = std::min(count, begin + rangeSize);
+		enqueue([&, begin, end]() {
+			fn(begin, end);
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--remaining == 0) doneCondition.notify_one();
+		});
+	}
+
+	fn(0, std::min(count, rangeSize));
+
+	std::unique_lock<std::mutex> lock(doneMutex);
+	doneCondition.wait(lock, [&]() { return remaining == 0; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (stopping && jobs.empty()) return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// fixed size worker pool for cpu side asset work (image decoding, baking). jobs must never
+// touch the GL context, that stays on the thread that created the window.
+class ThreadPool {
+public:
+	// threadCount of 0 uses every hardware thread except the one driving the context
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void enqueue(std::function<void()> job);
+
+	// splits [0, count) into contiguous ranges and blocks until all of them ran. the calling
+	// thread works on a range too, so don't call this from inside a pool job.
+	void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn);
+
+	unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+	// process-wide pool shared by the asset loaders
+	static ThreadPool& shared();
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+
+	void workerLoop();
+};
@@ -0,0 +1,189 @@
+#include "transform_store.h"
+#include "thread_pool.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2
+#endif
+
+uint32_t TransformStore::add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	if (count == positionX.size()) {
+		size_t padded = count + 4;
+		for (std::vector<float>* column : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ })
+			column->resize(padded, 0.0f);
+		for (std::vector<float>* column : { &rotationW, &scaleX, &scaleY, &scaleZ })
+			column->resize(padded, 1.0f);
+		dirty.resize(padded, 0);
+		matrices.resize(padded, glm::mat4(1.0f));
+	}
+
+	uint32_t index = static_cast<uint32_t>(count++);
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+	setRotation(index, rotation);
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+	return index;
+}
+
+uint32_t TransformStore::add(const glm::vec3& position, float angleDegrees, const glm::vec3& rotationAxis, const glm::vec3& scale)
+{
+	return add(position, glm::angleAxis(glm::radians(angleDegrees), glm::normalize(rotationAxis)), scale);
+}
+
+void TransformStore::reserve(size_t capacity)
+{
+	size_t padded = (capacity + 3) & ~static_cast<size_t>(3);
+	for (std::vector<float>* column : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ })
+		column->reserve(padded);
+	dirty.reserve(padded);
+	matrices.reserve(padded);
+}
+
+void TransformStore::clear()
+{
+	for (std::vector<float>* column : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ })
+		column->clear();
+	dirty.clear();
+	matrices.clear();
+	count = dirtyCount = 0;
+}
+
+void TransformStore::setPosition(uint32_t index, const glm::vec3& position)
+{
+	positionX[index] = position.x;
+	positionY[index] = position.y;
+	positionZ[index] = position.z;
+	markDirty(index);
+}
+
+void TransformStore::setRotation(uint32_t index, const glm::quat& rotation)
+{
+	// the kernel assumes unit quaternions
+	glm::quat unit = glm::normalize(rotation);
+	rotationX[index] = unit.x;
+	rotationY[index] = unit.y;
+	rotationZ[index] = unit.z;
+	rotationW[index] = unit.w;
+	markDirty(index);
+}
+
+void TransformStore::setRotation(uint32_t index, float angleDegrees, const glm::vec3& rotationAxis)
+{
+	setRotation(index, glm::angleAxis(glm::radians(angleDegrees), glm::normalize(rotationAxis)));
+}
+
+void TransformStore::setScale(uint32_t index, const glm::vec3& scale)
+{
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+	markDirty(index);
+}
+
+void TransformStore::markDirty(uint32_t index)
+{
+	if (!dirty[index]) {
+		dirty[index] = 1;
+		dirtyCount++;
+	}
+}
+
+void TransformStore::markAllDirty()
+{
+	std::fill(dirty.begin(), dirty.begin() + count, 1);
+	dirtyCount = count;
+}
+
+size_t TransformStore::update(bool simd, bool parallel)
+{
+	if (dirtyCount == 0) return 0;
+
+	size_t groups = positionX.size() / 4;
+	if (parallel && dirtyCount >= TRANSFORM_PARALLEL_THRESHOLD) {
+		ThreadPool::shared().parallelFor(groups, [&](size_t begin, size_t end) {
+			composeRange(begin * 4, end * 4, simd);
+		});
+	}
+	else {
+		composeRange(0, groups * 4, simd);
+	}
+
+	size_t updated = dirtyCount;
+	dirtyCount = 0;
+	return updated;
+}
+
+// M = T * S * R: the rotation's columns with row i scaled by scale[i], the position in the last column
+void TransformStore::composeRange(size_t begin, size_t end, bool simd)
+{
+	size_t i = begin;
+
+#ifdef TRANSFORM_SSE2
+	if (simd) {
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= end; i += 4) {
+			uint32_t flags;
+			std::memcpy(&flags, &dirty[i], sizeof(flags));
+			if (!flags) continue;
+			std::memset(&dirty[i], 0, 4);
+
+			__m128 x = _mm_loadu_ps(&rotationX[i]), y = _mm_loadu_ps(&rotationY[i]);
+			__m128 z = _mm_loadu_ps(&rotationZ[i]), w = _mm_loadu_ps(&rotationW[i]);
+			__m128 sx = _mm_loadu_ps(&scaleX[i]), sy = _mm_loadu_ps(&scaleY[i]), sz = _mm_loadu_ps(&scaleZ[i]);
+
+			__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+			__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+			__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+			// one register per matrix element, lane k belongs to object i + k
+			__m128 c0[4] = {
+				_mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)))),
+				_mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(xy, wz))),
+				_mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(xz, wy))),
+				zero };
+			__m128 c1[4] = {
+				_mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xy, wz))),
+				_mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)))),
+				_mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(yz, wx))),
+				zero };
+			__m128 c2[4] = {
+				_mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xz, wy))),
+				_mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(yz, wx))),
+				_mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)))),
+				zero };
+			__m128 c3[4] = { _mm_loadu_ps(&positionX[i]), _mm_loadu_ps(&positionY[i]), _mm_loadu_ps(&positionZ[i]), one };
+
+			// transposing each column's registers gives that column of the four matrices
+			__m128* columns[4] = { c0, c1, c2, c3 };
+			for (int c = 0; c < 4; c++) {
+				__m128* v = columns[c];
+				_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+				for (int k = 0; k < 4; k++)
+					_mm_storeu_ps(&matrices[i + k][c][0], v[k]);
+			}
+		}
+	}
+#endif
+
+	for (; i < end; i++) {
+		if (!dirty[i]) continue;
+		dirty[i] = 0;
+
+		float x = rotationX[i], y = rotationY[i], z = rotationZ[i], w = rotationW[i];
+		float sx = scaleX[i], sy = scaleY[i], sz = scaleZ[i];
+		glm::mat4& m = matrices[i];
+		m[0] = glm::vec4(sx * (1.0f - 2.0f * (y * y + z * z)), sy * 2.0f * (x * y + w * z), sz * 2.0f * (x * z - w * y), 0.0f);
+		m[1] = glm::vec4(sx * 2.0f * (x * y - w * z), sy * (1.0f - 2.0f * (x * x + z * z)), sz * 2.0f * (y * z + w * x), 0.0f);
+		m[2] = glm::vec4(sx * 2.0f * (x * z + w * y), sy * 2.0f * (y * z - w * x), sz * (1.0f - 2.0f * (x * x + y * y)), 0.0f);
+		m[3] = glm::vec4(positionX[i], positionY[i], positionZ[i], 1.0f);
+	}
+}
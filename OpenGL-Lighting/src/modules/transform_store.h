@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// updates smaller than this stay on the calling thread
+constexpr size_t TRANSFORM_PARALLEL_THRESHOLD = 16384;
+
+// positions, rotations and scales of many objects as structure of arrays, with their model matrices cached
+// and only rebuilt for objects touched since the last update(). the matrices are composed in the order
+// computeModelMatrix uses, translate * scale * rotate, so both agree for any scale.
+class TransformStore {
+public:
+	// returns the object's index, matrices of new objects are built on the next update
+	uint32_t add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale = glm::vec3(1.0f));
+	uint32_t add(const glm::vec3& position, float angleDegrees, const glm::vec3& rotationAxis, const glm::vec3& scale = glm::vec3(1.0f));
+	void reserve(size_t count);
+	void clear();
+	size_t size() const { return count; }
+
+	void setPosition(uint32_t index, const glm::vec3& position);
+	void setRotation(uint32_t index, const glm::quat& rotation);
+	void setRotation(uint32_t index, float angleDegrees, const glm::vec3& rotationAxis);
+	void setScale(uint32_t index, const glm::vec3& scale);
+	glm::vec3 getPosition(uint32_t index) const { return glm::vec3(positionX[index], positionY[index], positionZ[index]); }
+	glm::quat getRotation(uint32_t index) const { return glm::quat(rotationW[index], rotationX[index], rotationY[index], rotationZ[index]); }
+	glm::vec3 getScale(uint32_t index) const { return glm::vec3(scaleX[index], scaleY[index], scaleZ[index]); }
+
+	// rebuilds the matrices of dirty objects four at a time, returns how many were dirty.
+	// simd = false forces the scalar loop, the SSE2 one is used otherwise when compiled in.
+	// past TRANSFORM_PARALLEL_THRESHOLD dirty objects the work is split across the shared pool unless parallel is false.
+	size_t update(bool simd = true, bool parallel = true);
+	// every object dirty, e.g. to time a full rebuild
+	void markAllDirty();
+
+	// valid after update()
+	const glm::mat4& getMatrix(uint32_t index) const { return matrices[index]; }
+	const glm::mat4* getMatrices() const { return matrices.data(); }
+
+private:
+	size_t count = 0;
+	// padded to a multiple of 4 with identity transforms so the SSE path never needs a tail
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<unsigned char> dirty;
+	std::vector<glm::mat4> matrices;
+	size_t dirtyCount = 0;
+
+	void markDirty(uint32_t index);
+	void composeRange(size_t begin, size_t end, bool simd);
+};
@@ -0,0 +1,127 @@
+#include "uniform_ring.h"
+#include "gl_extensions.h"
+#include "gl_state.h"
+
+#include <iostream>
+#include <cstring>
+#include <chrono>
+
+UniformRing::UniformRing(size_t frameBytes)
+{
+	GLint offsetAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if (offsetAlignment > 0)
+		alignment = static_cast<size_t>(offsetAlignment);
+	this->frameBytes = (frameBytes + alignment - 1) / alignment * alignment;
+
+	glGenBuffers(1, &buffer);
+	glstate::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+	if (glext::hasBufferStorage()) {
+		GLsizeiptr ringBytes = static_cast<GLsizeiptr>(this->frameBytes * UNIFORM_RING_FRAMES);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glext::BufferStorage(GL_UNIFORM_BUFFER, ringBytes, nullptr, flags);
+		mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, ringBytes, flags));
+		if (!mapped) {
+			// storage is immutable, start over with a plain buffer
+			std::cout << "ERROR::UNIFORM_RING::PERSISTENT_MAP_FAILED falling back to orphaning" << std::endl;
+			glstate::DeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glstate::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		}
+	}
+	if (!mapped)
+		glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(this->frameBytes), nullptr, GL_STREAM_DRAW);
+}
+
+UniformRing::~UniformRing()
+{
+	if (mapped) {
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+	}
+	for (GLsync fence : fences)
+		if (fence) glDeleteSync(fence);
+	glstate::DeleteBuffers(1, &buffer);
+}
+
+void UniformRing::beginFrame()
+{
+	region = (region + 1) % UNIFORM_RING_FRAMES;
+	cursor = 0;
+
+	if (!mapped) {
+		// the driver hands out fresh storage while draws still in flight keep reading the old one
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, GL_STREAM_DRAW);
+		return;
+	}
+
+	GLsync& fence = fences[region];
+	if (!fence) return;
+	// a signalled fence costs a poll, waiting means the gpu is UNIFORM_RING_FRAMES frames behind
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		stats.waits++;
+		auto start = std::chrono::high_resolution_clock::now();
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+		} while (status == GL_TIMEOUT_EXPIRED);
+		stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	if (status == GL_WAIT_FAILED)
+		std::cout << "ERROR::UNIFORM_RING::FENCE_WAIT_FAILED" << std::endl;
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void UniformRing::endFrame()
+{
+	if (mapped)
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+UniformRange UniformRing::push(const void* data, size_t size)
+{
+	size_t offset = (cursor + alignment - 1) / alignment * alignment;
+	if (size == 0 || offset + size > frameBytes) {
+		if (!overflowReported) {
+			std::cout << "ERROR::UNIFORM_RING::FRAME_FULL " << frameBytes << " bytes per frame" << std::endl;
+			overflowReported = true;
+		}
+		return UniformRange();
+	}
+	cursor = offset + size;
+
+	size_t base = 0;
+	if (mapped) {
+		base = region * frameBytes;
+		std::memcpy(mapped + base + offset, data, size);
+	}
+	else {
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	}
+
+	stats.pushes++;
+	stats.bytes += size;
+	UniformRange range;
+	range.buffer = buffer;
+	range.offset = static_cast<GLintptr>(base + offset);
+	range.size = static_cast<GLsizeiptr>(size);
+	return range;
+}
+
+void UniformRing::bind(GLuint bindingPoint, const UniformRange& range)
+{
+	if (range.valid())
+		glstate::BindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, range.buffer, range.offset, range.size);
+}
+
+void UniformRing::printStats(unsigned int frameCount)
+{
+	if (frameCount > 0) {
+		std::cout << "uniform ring per frame (" << (mapped ? "persistent" : "orphaning") << "): " << stats.pushes / frameCount
+			<< " pushes, " << stats.bytes / frameCount << " bytes, " << stats.waits << " fence waits (" << stats.waitMs << " ms)" << std::endl;
+	}
+	stats = StreamStats();
+}
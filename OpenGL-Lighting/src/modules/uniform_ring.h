@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <glad/glad.h>
+
+// frames the cpu may run ahead of the gpu, one region of the ring each
+constexpr unsigned int UNIFORM_RING_FRAMES = 3;
+
+// a range of the ring holding one push, valid until the same region comes round again
+struct UniformRange {
+	GLuint buffer = 0;
+	GLintptr offset = 0;
+	GLsizeiptr size = 0;
+	bool valid() const { return size > 0; }
+};
+
+// streaming uniform data written once and read by the draws of the same frame: per frame, per pass or per draw
+// blocks are pushed and bound with glBindBufferRange instead of each living in its own buffer.
+// with buffer storage the ring is persistently and coherently mapped, split into UNIFORM_RING_FRAMES regions and
+// a region is reused once the fence placed after its frame has signalled. without it the buffer is orphaned at
+// the start of every frame and each push is a glBufferSubData into the fresh storage.
+class UniformRing {
+public:
+	// frameBytes is the most one frame may push, offset alignment included
+	explicit UniformRing(size_t frameBytes);
+	~UniformRing();
+
+	// owns a GL buffer and its mapping
+	UniformRing(const UniformRing&) = delete;
+	UniformRing& operator=(const UniformRing&) = delete;
+
+	// moves to the next region, waiting on its fence if the gpu is still reading it
+	void beginFrame();
+	// fences the region the frame wrote
+	void endFrame();
+
+	// copies size bytes in at the next aligned offset, an invalid range once the frame's region is full
+	UniformRange push(const void* data, size_t size);
+	template <typename T>
+	UniformRange push(const T& block) { return push(&block, sizeof(T)); }
+	// binds range to a GL_UNIFORM_BUFFER binding point
+	static void bind(GLuint bindingPoint, const UniformRange& range);
+
+	bool isPersistent() const { return mapped != nullptr; }
+
+	// pushes, bytes and fence waits since the last reset
+	struct StreamStats {
+		unsigned long long pushes = 0;
+		unsigned long long bytes = 0;
+		unsigned long long waits = 0;
+		double waitMs = 0.0;
+	};
+	StreamStats stats;
+	// prints the per frame averages over frameCount frames and resets the counters
+	void printStats(unsigned int frameCount);
+
+private:
+	GLuint buffer = 0;
+	size_t frameBytes;
+	size_t alignment = 256;
+	unsigned char* mapped = nullptr; // whole ring, null on the orphaning path
+	GLsync fences[UNIFORM_RING_FRAMES] = {};
+	unsigned int region = UNIFORM_RING_FRAMES - 1;
+	size_t cursor = 0; // bytes used in the current region
+	bool overflowReported = false;
+};
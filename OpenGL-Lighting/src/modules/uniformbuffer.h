@@ -7,6 +7,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.h"
+
 class UniformBuffer
 {
 private:
@@ -17,24 +19,24 @@ public:
 	// constructor will be used for buffer allocation
 	UniformBuffer(unsigned int bufferDataSize, GLenum usage = GL_STATIC_DRAW) : bufferDataSize(bufferDataSize) {
 		glGenBuffers(1, &UBO);
-		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, UBO);
 		glBufferData(GL_UNIFORM_BUFFER, bufferDataSize, NULL, usage);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, 0);
 	}
 
 	~UniformBuffer() {
-		glDeleteBuffers(1, &UBO);
+		glstate::DeleteBuffers(1, &UBO);
 	}
 
 	void bindBufferBase(unsigned int bindingPoint) {
-		glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, UBO);
+		glstate::BindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, UBO);
 	}
 
 	void setData(const void* data, unsigned int size, unsigned int offset = 0) const {
 		assert(offset + size <= bufferDataSize);
-		glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+		// left bound, the next setData on this buffer skips the bind
+		glstate::BindBuffer(GL_UNIFORM_BUFFER, UBO);
 		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 	}
 
 	unsigned int getBufferSize() const { return bufferDataSize; }
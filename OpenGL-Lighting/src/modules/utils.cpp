@@ -1,4 +1,5 @@
 #include <iostream>
+#include <unordered_set>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -7,6 +8,11 @@
 
 #include "utils.h"
 #include "camera.h"
+#include "mesh_simplifier.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "baked_texture.h"
+#include "gl_state.h"
 
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -106,29 +112,33 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glstate::Viewport(0, 0, width, height);
 }
 
 unsigned int loadCubemap(std::vector<std::string> faces)
 {
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-	int width, height, nrChannels;
+	// faces decode in parallel and are uploaded as they come back
+	ImageDecodeBatch batch;
 	for (unsigned int i = 0; i < faces.size(); i++)
+		batch.add(faces[i], false);
+
+	size_t face;
+	DecodedImage image;
+	while (batch.next(face, image))
 	{
-		unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-		if (data)
+		if (image.valid())
 		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			stbi_image_free(data);
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.data);
 		}
 		else
 		{
-			std::cout << "Cubemap failed to load at path: " << faces[i] << std::endl;
-			stbi_image_free(data);
+			std::cout << "Cubemap failed to load at path: " << faces[face] << std::endl;
 		}
+		image.release();
 	}
 
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -151,26 +161,135 @@ unsigned int createDefaultTexture()
 
 unsigned int loadTexture(const char* path, bool flipVertically, TextureColorSpace space)
 {
-	stbi_set_flip_vertically_on_load(flipVertically);
-
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-	if (!data)
+	TextureCache& cache = TextureCache::instance();
+	unsigned int cached = cache.acquire(path, space, flipVertically, false);
+	if (cached != 0)
+		return cached;
+
+	// a cooked mip chain skips both the decode and the gpu mip generation
+	size_t bakedBytes;
+	unsigned int baked = loadBakedTexture(path, space, flipVertically, &bakedBytes);
+	if (baked != 0)
+		return cache.insert(path, space, flipVertically, false, baked, bakedBytes);
+
+	DecodedImage image = decodeImage(path, flipVertically);
+	if (!image.valid())
 	{
 		std::cout << "Failed to load texture" << std::endl;
-		stbi_image_free(data);
 		return 0;
 	}
-	
-	GLenum baseFormat = GL_RGB;
-	if (nrChannels == 1)
+
+	unsigned int textureID = createTextureFromImage(image, space);
+	cache.insert(path, space, flipVertically, false, textureID, TextureCache::estimateImageBytes(image));
+	return textureID;
+}
+
+unsigned int loadHDR(const char* path, bool flipVertically)
+{
+	TextureCache& cache = TextureCache::instance();
+	unsigned int cached = cache.acquire(path, TextureColorSpace::Linear, flipVertically, true);
+	if (cached != 0)
+		return cached;
+
+	DecodedImage image = decodeImage(path, flipVertically, true);
+	if (!image.valid())
+	{
+		std::cout << "Failed to load HDR image" << std::endl;
+		return 0;
+	}
+
+	unsigned int textureID = createTextureFromImage(image, TextureColorSpace::Linear);
+	cache.insert(path, TextureColorSpace::Linear, flipVertically, true, textureID, TextureCache::estimateImageBytes(image));
+	return textureID;
+}
+
+void streamTexture(const char* path, bool flipVertically, TextureColorSpace space, unsigned int& texture)
+{
+	TextureStreamer& streamer = TextureStreamer::instance();
+	texture = streamer.getPlaceholder();
+
+	unsigned int* target = &texture;
+	streamer.request(path, flipVertically, space, false, target, [target](unsigned int textureID) {
+		*target = textureID;
+	});
+}
+
+std::vector<unsigned int> loadTextures(const std::vector<TextureLoadRequest>& requests)
+{
+	std::vector<unsigned int> textureIDs(requests.size(), 0);
+	TextureCache& cache = TextureCache::instance();
+
+	// only cache misses are decoded, and a file requested twice in one batch is decoded once
+	ImageDecodeBatch batch;
+	std::vector<size_t> batchRequests;
+	std::vector<size_t> duplicates;
+	std::unordered_set<std::string> queuedKeys;
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		const TextureLoadRequest& request = requests[i];
+		if (queuedKeys.count(TextureCache::makeKey(request.path, request.space, request.flipVertically, request.hdr)))
+		{
+			duplicates.push_back(i);
+			continue;
+		}
+
+		textureIDs[i] = cache.acquire(request.path, request.space, request.flipVertically, request.hdr);
+		if (textureIDs[i] != 0)
+			continue;
+
+		size_t bakedBytes;
+		unsigned int baked = request.hdr ? 0 : loadBakedTexture(request.path, request.space, request.flipVertically, &bakedBytes);
+		if (baked != 0)
+		{
+			textureIDs[i] = cache.insert(request.path, request.space, request.flipVertically, request.hdr, baked, bakedBytes);
+			continue;
+		}
+
+		queuedKeys.insert(TextureCache::makeKey(request.path, request.space, request.flipVertically, request.hdr));
+		batch.add(request.path, request.flipVertically, request.hdr);
+		batchRequests.push_back(i);
+	}
+
+	size_t index;
+	DecodedImage image;
+	while (batch.next(index, image))
+	{
+		const TextureLoadRequest& request = requests[batchRequests[index]];
+		if (image.valid())
+		{
+			unsigned int textureID = createTextureFromImage(image, request.space);
+			cache.insert(request.path, request.space, request.flipVertically, request.hdr, textureID, TextureCache::estimateImageBytes(image));
+			textureIDs[batchRequests[index]] = textureID;
+		}
+		else
+			std::cout << "Failed to load texture at path: " << request.path << std::endl;
+		image.release();
+	}
+
+	for (size_t i : duplicates)
+		textureIDs[i] = cache.acquire(requests[i].path, requests[i].space, requests[i].flipVertically, requests[i].hdr);
+
+	return textureIDs;
+}
+
+void textureFormatsForImage(const DecodedImage& image, TextureColorSpace space, GLenum& internalFormat, GLenum& baseFormat)
+{
+	if (image.hdr)
+	{
+		internalFormat = GL_RGB16F;
+		baseFormat = GL_RGB;
+		return;
+	}
+
+	baseFormat = GL_RGB;
+	if (image.channels == 1)
 		baseFormat = GL_RED;
-	else if (nrChannels == 3)
+	else if (image.channels == 3)
 		baseFormat = GL_RGB;
-	else if (nrChannels == 4)
+	else if (image.channels == 4)
 		baseFormat = GL_RGBA;
 
-	GLenum internalFormat = baseFormat;
+	internalFormat = baseFormat;
 
 	if (space == TextureColorSpace::sRGB) {
 		if (baseFormat == GL_RGB)
@@ -178,33 +297,29 @@ unsigned int loadTexture(const char* path, bool flipVertically, TextureColorSpac
 		else if (baseFormat == GL_RGBA)
 			internalFormat = GL_SRGB_ALPHA;
 	}
-
-	Texture tex(width, height, internalFormat, baseFormat, GL_LINEAR, GL_REPEAT, data);
-	tex.genMipMap();
-
-	stbi_image_free(data);
-
-	return tex.id;
 }
 
-unsigned int loadHDR(const char* path, bool flipVertically)
+unsigned int createTextureFromImage(const DecodedImage& image, TextureColorSpace space, GLint minFilter)
 {
-	stbi_set_flip_vertically_on_load(flipVertically);
+	GLenum internalFormat, baseFormat;
+	textureFormatsForImage(image, space, internalFormat, baseFormat);
 
-	int width, height, nrChannels;
-	float* data = stbi_loadf(path, &width, &height, &nrChannels, 0);
-	if (!data)
+	if (image.hdr)
 	{
-		std::cout << "Failed to load HDR image" << std::endl;
-		stbi_image_free(data);
-		return 0;
+		Texture hdrTexture(image.width, image.height, internalFormat, baseFormat, GL_LINEAR, GL_CLAMP_TO_EDGE, image.data);
+		return hdrTexture.id;
 	}
 
-	Texture hdrTexture(width, height, GL_RGB16F, GL_RGB, GL_LINEAR, GL_CLAMP_TO_EDGE, data);
-
-	stbi_image_free(data);
+	Texture tex(image.width, image.height, internalFormat, baseFormat, GL_LINEAR, GL_REPEAT, image.data);
+	tex.genMipMap();
+	if (minFilter != GL_LINEAR)
+	{
+		tex.bind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	}
+	tex.unbind();
 
-	return hdrTexture.id;
+	return tex.id;
 }
 
 unsigned int createCubeVAO()
@@ -272,9 +387,9 @@ unsigned int createCubeVAO()
 
 	unsigned int VBO;
 	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glBindVertexArray(cubeVAO);
+	glstate::BindVertexArray(cubeVAO);
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
@@ -283,15 +398,15 @@ unsigned int createCubeVAO()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 	glEnableVertexAttribArray(2);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glstate::BindVertexArray(0);
 
 	return cubeVAO;
 }
 
-unsigned int createSphereVAO(unsigned int& indicesCount, float radius, unsigned int sectorCount, unsigned int stackCount) {
-	std::vector<float> vertices;
-	std::vector<unsigned int> indices;
+void generateSphere(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount) {
+	vertices.clear();
+	indices.clear();
 
 	const float PI = 3.1415926f;
 
@@ -304,25 +419,24 @@ unsigned int createSphereVAO(unsigned int& indicesCount, float radius, unsigned
 		for (unsigned int j = 0; j <= sectorCount; j++) {
 			float sectorAngle = j * (2 * PI / (float)sectorCount);
 
+			Vertex vertex;
 			// positions
 			float x = xy * cosf(sectorAngle);
 			float y = xy * sinf(sectorAngle);
-			vertices.push_back(x);
-			vertices.push_back(y);
-			vertices.push_back(z);
+			vertex.Position = glm::vec3(x, y, z);
 
 			// normals
 			float lengthInv = 1.0 / radius;
-			vertices.push_back(x * lengthInv);
-			vertices.push_back(y * lengthInv);
-			vertices.push_back(z * lengthInv);
+			vertex.Normal = glm::vec3(x * lengthInv, y * lengthInv, z * lengthInv);
 
 			// uvs
 			float s = (float)j / (float)sectorCount;
 			float t = (float)i / (float)stackCount;
-			vertices.push_back(s);
-			vertices.push_back(t);
+			vertex.TexCoords = glm::vec2(s, t);
 
+			vertex.Tangent = glm::vec3(0.0f);
+			vertex.Bitangent = glm::vec3(0.0f);
+			vertices.push_back(vertex);
 		}
 	}
 
@@ -345,88 +459,76 @@ unsigned int createSphereVAO(unsigned int& indicesCount, float radius, unsigned
 		}
 	}
 
-	size_t vertexCount = vertices.size() / 8;
-
-	std::vector<glm::vec3> tangents(vertexCount, glm::vec3(0.0f));
-	std::vector<glm::vec3> bitangents(vertexCount, glm::vec3(0.0f));
-
 	for (unsigned int i = 0; i < indices.size(); i+=3) {
-		unsigned int i0 = indices[i];
-		unsigned int i1 = indices[i + 1];
-		unsigned int i2 = indices[i + 2];
-
 		glm::vec3 pos[3];
 		glm::vec2 uv[3];
 
 		for (unsigned int j = 0; j < 3; j++) {
-			unsigned int index = indices[i + j];
-			pos[j] = glm::vec3(vertices[index * 8 + 0], vertices[index * 8 + 1], vertices[index * 8 + 2]);
-			uv[j] = glm::vec2(vertices[index * 8 + 6], vertices[index * 8 + 7]);
+			pos[j] = vertices[indices[i + j]].Position;
+			uv[j] = vertices[indices[i + j]].TexCoords;
 		}
 
 		glm::mat2x3 TB = getTangentBitangentMatrix(pos, uv);
-		glm::vec3 tangent = TB[0];
-		glm::vec3 bitangent = TB[1];
-
-		tangents[i0] += tangent;
-		tangents[i1] += tangent;
-		tangents[i2] += tangent;
-
-		bitangents[i0] += bitangent;
-		bitangents[i1] += bitangent;
-		bitangents[i2] += bitangent;
-
+		for (unsigned int j = 0; j < 3; j++) {
+			vertices[indices[i + j]].Tangent += TB[0];
+			vertices[indices[i + j]].Bitangent += TB[1];
+		}
 	}
 
-	for (unsigned int i = 0; i < vertexCount; ++i) {
-		tangents[i] = glm::normalize(tangents[i]);
-		bitangents[i] = glm::normalize(bitangents[i]);
+	for (Vertex& vertex : vertices) {
+		vertex.Tangent = glm::normalize(vertex.Tangent);
+		vertex.Bitangent = glm::normalize(vertex.Bitangent);
 	}
+}
+
+unsigned int createSphereVAO(unsigned int& indicesCount, float radius, unsigned int sectorCount, unsigned int stackCount) {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	generateSphere(vertices, indices, radius, sectorCount, stackCount);
 
 	unsigned int VAO, VBO, EBO;
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 
-	glBindVertexArray(VAO);
+	glstate::BindVertexArray(VAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	glstate::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
 	glEnableVertexAttribArray(0);
 
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
 	glEnableVertexAttribArray(1);
 
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
 	glEnableVertexAttribArray(2);
 
-	unsigned int tanVBO;
-	glGenBuffers(1, &tanVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, tanVBO);
-	glBufferData(GL_ARRAY_BUFFER, tangents.size() * sizeof(glm::vec3), tangents.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
 	glEnableVertexAttribArray(3);
 
-	unsigned int bitanVBO;
-	glGenBuffers(1, &bitanVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, bitanVBO);
-	glBufferData(GL_ARRAY_BUFFER, bitangents.size() * sizeof(glm::vec3), bitangents.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 	glEnableVertexAttribArray(4);
 
-	glBindVertexArray(0);
+	glstate::BindVertexArray(0);
 
 	indicesCount = indices.size();
 
 	return VAO;
 }
 
+Mesh createSphereMesh(float radius, unsigned int sectorCount, unsigned int stackCount, VertexLayout layout) {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	generateSphere(vertices, indices, radius, sectorCount, stackCount);
+
+	std::vector<MeshLOD> lods = buildLODChain(vertices, indices);
+	return Mesh(vertices, indices, std::vector<MeshTexture>(), layout, lods);
+}
+
 unsigned int createQuadVAO()
 {
 	float vertices[] = {
@@ -464,11 +566,11 @@ unsigned int createQuadVAO()
 
 	unsigned int quadVAO;
 	glGenVertexArrays(1, &quadVAO);
-	glBindVertexArray(quadVAO);
+	glstate::BindVertexArray(quadVAO);
 
 	unsigned int VBO;
 	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
@@ -480,7 +582,7 @@ unsigned int createQuadVAO()
 
 	unsigned int tanBitanVBO;
 	glGenBuffers(1, &tanBitanVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, tanBitanVBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, tanBitanVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(tanBitan), tanBitan, GL_STATIC_DRAW);
 
 	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)(0 * sizeof(glm::vec3)));
@@ -488,8 +590,8 @@ unsigned int createQuadVAO()
 	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (void*)(sizeof(glm::vec3)));
 	glEnableVertexAttribArray(4);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glstate::BindVertexArray(0);
 
 	return quadVAO;
 }
@@ -535,17 +637,17 @@ unsigned int createFrameVAO()
 
 	unsigned int quadVBO;
 	glGenBuffers(1, &quadVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
-	glBindVertexArray(quadVAO);
+	glstate::BindVertexArray(quadVAO);
 
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glstate::BindVertexArray(0);
 
 	return quadVAO;
 }
@@ -568,17 +670,17 @@ unsigned int createDebugFrameVAO()
 
 	unsigned int debugVBO;
 	glGenBuffers(1, &debugVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, debugVBO);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, debugVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glBindVertexArray(debugVAO);
+	glstate::BindVertexArray(debugVAO);
 
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glstate::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glstate::BindVertexArray(0);
 
 	return debugVAO;
 }
@@ -597,8 +699,8 @@ void bindTextures(const std::vector<unsigned int>& textures, GLenum textureTarge
 {
 	for (size_t i = 0; i < textures.size(); ++i)
 	{
-		glActiveTexture(startUnit + i);
-		glBindTexture(textureTarget, textures[i]);
+		glstate::ActiveTexture(startUnit + i);
+		glstate::BindTexture(textureTarget, textures[i]);
 	}
 }
 
@@ -618,8 +720,8 @@ float lerp(float a, float b, float t)
 void DisplayFramebufferTexture(Shader shader, unsigned int frame, unsigned int textureID) {
 	shader.use();
 	shader.setInt("fboAttachment", 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glBindVertexArray(frame);
+	glstate::ActiveTexture(GL_TEXTURE0);
+	glstate::BindTexture(GL_TEXTURE_2D, textureID);
+	glstate::BindVertexArray(frame);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
@@ -10,12 +10,21 @@
 #include "../modules/shader.h"
 #include "../../stb/stb_image.h"
 #include "texture.h"
+#include "image_decoder.h"
+#include "mesh.h"
 
 enum class TextureColorSpace {
 	Linear,
 	sRGB
 };
 
+struct TextureLoadRequest {
+	std::string path;
+	bool flipVertically;
+	TextureColorSpace space = TextureColorSpace::Linear;
+	bool hdr = false;
+};
+
 // adjusts the viewport when user resizes it
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
@@ -26,12 +35,26 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 unsigned int loadCubemap(std::vector<std::string> faces);
 unsigned int createDefaultTexture();
+// loaders go through TextureCache, so a file already uploaded with the same color space, flip and
+// hdr flag comes back as the same id with its reference count bumped
 unsigned int loadTexture(const char* path, bool flipVertically, TextureColorSpace space = TextureColorSpace::Linear);
 unsigned int loadHDR(const char* path, bool flipVertically);
+// decodes every request concurrently on the shared worker pool, uploads on the calling thread.
+// returned ids are in request order, 0 for images that failed to load.
+std::vector<unsigned int> loadTextures(const std::vector<TextureLoadRequest>& requests);
+unsigned int createTextureFromImage(const DecodedImage& image, TextureColorSpace space, GLint minFilter = GL_LINEAR_MIPMAP_LINEAR);
+// gl formats createTextureFromImage uses for a decoded image
+void textureFormatsForImage(const DecodedImage& image, TextureColorSpace space, GLenum& internalFormat, GLenum& baseFormat);
+// async variant of loadTexture. texture is set to the shared placeholder right away and swapped for
+// the real id by TextureStreamer::update once every mip is resident, so it has to outlive the upload.
+void streamTexture(const char* path, bool flipVertically, TextureColorSpace space, unsigned int& texture);
 
 // vertex array object references
 unsigned int createCubeVAO();
 unsigned int createSphereVAO(unsigned int& indicesCount, float radius = 1.0f, unsigned int sectorCount = 16, unsigned int stackCount = 16);
+// uv sphere as a Mesh with a LOD chain, draw it through Mesh::Draw(shader, model, view) to get screen size selection
+Mesh createSphereMesh(float radius = 1.0f, unsigned int sectorCount = 16, unsigned int stackCount = 16, VertexLayout layout = VertexLayout::Standard);
+void generateSphere(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float radius, unsigned int sectorCount, unsigned int stackCount);
 unsigned int createQuadVAO();
 unsigned int createFrameVAO();
 unsigned int createDebugFrameVAO();
@@ -0,0 +1,190 @@
+#include "vertex_format.h"
+#include "mesh.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	int16_t toSnorm16(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return static_cast<int16_t>(std::lround(value * 32767.0f));
+	}
+
+	float signNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// -1 when the stored bitangent points against cross(normal, tangent)
+	float handedness(const Vertex& vertex)
+	{
+		return glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+	}
+
+	template <typename T>
+	void packAttributes(const Vertex& vertex, T& packed)
+	{
+		encodeOctahedral(vertex.Normal, packed.normal);
+		encodeOctahedral(vertex.Tangent, packed.tangent);
+		packed.texCoords[0] = floatToHalf(vertex.TexCoords.x);
+		packed.texCoords[1] = floatToHalf(vertex.TexCoords.y);
+	}
+}
+
+size_t vertexLayoutStride(VertexLayout layout)
+{
+	switch (layout) {
+	case VertexLayout::Compact: return sizeof(CompactVertex);
+	case VertexLayout::CompactQuantized: return sizeof(QuantizedVertex);
+	default: return sizeof(Vertex);
+	}
+}
+
+const char* vertexLayoutName(VertexLayout layout)
+{
+	switch (layout) {
+	case VertexLayout::Compact: return "compact";
+	case VertexLayout::CompactQuantized: return "compact quantized";
+	default: return "standard";
+	}
+}
+
+void encodeOctahedral(const glm::vec3& direction, int16_t encoded[2])
+{
+	float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if (length == 0.0f) {
+		// missing normals/tangents stay zero-ish instead of turning into NaN
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+
+	float x = direction.x / length;
+	float y = direction.y / length;
+	if (direction.z < 0.0f) {
+		// fold the lower hemisphere over the diagonals
+		float foldedX = (1.0f - std::abs(y)) * signNotZero(x);
+		float foldedY = (1.0f - std::abs(x)) * signNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+	encoded[0] = toSnorm16(x);
+	encoded[1] = toSnorm16(y);
+}
+
+glm::vec3 decodeOctahedral(const int16_t encoded[2])
+{
+	float x = std::max(encoded[0] / 32767.0f, -1.0f);
+	float y = std::max(encoded[1] / 32767.0f, -1.0f);
+	glm::vec3 direction(x, y, 1.0f - std::abs(x) - std::abs(y));
+	if (direction.z < 0.0f) {
+		direction.x = (1.0f - std::abs(y)) * signNotZero(x);
+		direction.y = (1.0f - std::abs(x)) * signNotZero(y);
+	}
+	return glm::normalize(direction);
+}
+
+uint16_t floatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (floatExponent == 0xff)
+		return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+	int exponent = static_cast<int>(floatExponent) - 127 + 15;
+	if (exponent >= 31)
+		return static_cast<uint16_t>(sign | 0x7c00);
+
+	if (exponent <= 0) {
+		// denormal half, the implicit one becomes part of the mantissa
+		if (exponent < -10) return static_cast<uint16_t>(sign);
+		mantissa |= 0x800000;
+		uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1fff;
+	// a carry out of the mantissa correctly bumps the exponent
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++;
+	return static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t value)
+{
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -magnitude : magnitude;
+	}
+
+	uint32_t bits = exponent == 31
+		? sign | 0x7f800000 | (mantissa << 13)
+		: sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+void packVertices(const Vertex* vertices, size_t vertexCount, VertexLayout layout, std::vector<unsigned char>& packed, PositionDequant& dequant)
+{
+	dequant = PositionDequant();
+	packed.resize(vertexCount * vertexLayoutStride(layout));
+
+	if (layout == VertexLayout::Standard) {
+		if (vertexCount > 0)
+			std::memcpy(packed.data(), vertices, packed.size());
+		return;
+	}
+
+	if (layout == VertexLayout::Compact) {
+		CompactVertex* out = reinterpret_cast<CompactVertex*>(packed.data());
+		for (size_t i = 0; i < vertexCount; i++) {
+			const Vertex& vertex = vertices[i];
+			out[i].position[0] = vertex.Position.x;
+			out[i].position[1] = vertex.Position.y;
+			out[i].position[2] = vertex.Position.z;
+			out[i].position[3] = handedness(vertex);
+			packAttributes(vertex, out[i]);
+		}
+		return;
+	}
+
+	// quantized: snorm16 across the bounds of this mesh, per axis
+	glm::vec3 minimum(0.0f), maximum(0.0f);
+	if (vertexCount > 0) {
+		minimum = maximum = vertices[0].Position;
+		for (size_t i = 1; i < vertexCount; i++) {
+			minimum = glm::min(minimum, vertices[i].Position);
+			maximum = glm::max(maximum, vertices[i].Position);
+		}
+	}
+	dequant.offset = (minimum + maximum) * 0.5f;
+	dequant.scale = glm::max((maximum - minimum) * 0.5f, glm::vec3(1e-6f));
+
+	QuantizedVertex* out = reinterpret_cast<QuantizedVertex*>(packed.data());
+	for (size_t i = 0; i < vertexCount; i++) {
+		const Vertex& vertex = vertices[i];
+		glm::vec3 local = (vertex.Position - dequant.offset) / dequant.scale;
+		out[i].position[0] = toSnorm16(local.x);
+		out[i].position[1] = toSnorm16(local.y);
+		out[i].position[2] = toSnorm16(local.z);
+		out[i].position[3] = toSnorm16(handedness(vertex));
+		packAttributes(vertex, out[i]);
+	}
+}
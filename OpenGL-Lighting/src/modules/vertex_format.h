@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct Vertex;
+
+// how Mesh lays out its vertex buffer. the compact layouts need a vertex shader built with
+// COMPACT_VERTEX defined, which decodes them back into the usual attributes.
+enum class VertexLayout {
+	Standard,        // Vertex as is, 56 bytes
+	Compact,         // CompactVertex, 28 bytes
+	CompactQuantized // QuantizedVertex, 20 bytes, positions relative to the mesh bounds
+};
+
+// shared by both compact layouts: octahedral normal and tangent as snorm16 pairs, half float uvs.
+// the bitangent is rebuilt as cross(normal, tangent) * the sign kept in position.w.
+struct CompactVertex {
+	float position[4];
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t texCoords[2];
+};
+
+struct QuantizedVertex {
+	int16_t position[4]; // snorm, xyz scaled into the mesh bounds, w = bitangent sign
+	int16_t normal[2];
+	int16_t tangent[2];
+	uint16_t texCoords[2];
+};
+
+// object space position = offset + scale * stored position, identity for the unquantized layouts
+struct PositionDequant {
+	glm::vec3 offset = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+};
+
+size_t vertexLayoutStride(VertexLayout layout);
+const char* vertexLayoutName(VertexLayout layout);
+
+// unit vector to the octahedron unfolded onto [-1, 1]^2, stored as snorm16
+void encodeOctahedral(const glm::vec3& direction, int16_t encoded[2]);
+glm::vec3 decodeOctahedral(const int16_t encoded[2]);
+
+// round to nearest, overflow goes to infinity
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// converts vertices into layout, dequant receives the transform the vertex shader has to apply
+void packVertices(const Vertex* vertices, size_t vertexCount, VertexLayout layout, std::vector<unsigned char>& packed, PositionDequant& dequant);
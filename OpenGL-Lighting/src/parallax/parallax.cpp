@@ -8,11 +8,14 @@
 #include "../modules/model.h"
 #include "../modules/utils.h"
 #include "../modules/shader.h"
+#include "../modules/shader_variants.h"
 #include "../modules/camera.h"
 #include "../modules/framebuffer.h"
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 
@@ -41,10 +44,10 @@ int parallax_main() {
 	}
 
 	// viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	glstate::Enable(GL_DEPTH_TEST);
+	glstate::Enable(GL_CULL_FACE);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -58,9 +61,10 @@ int parallax_main() {
 	);
 	glfwSetWindowUserPointer(window, &camera);
 
-	Shader floorShader("shaders/base_lit.vert", "shaders/base_lit.frag");
+	ShaderVariants litVariants("shaders/base_lit.vert", "shaders/base_lit.frag");
+	Shader& floorShader = litVariants.get(ShaderDefines());
 	Shader depthDirShader("shaders/simple_depth.vert", "shaders/empty.frag");
-	Shader cyborgShader("shaders/base_lit.vert", "shaders/material_lit.frag");
+	Shader& cyborgShader = litVariants.get(ShaderDefines().define("MODEL_MATERIAL"));
 
 	// directional shadow mapping
 	const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
@@ -96,11 +100,13 @@ int parallax_main() {
 
 	Model cyborg("resources/objects/cyborg/cyborg.obj");
 
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -114,31 +120,29 @@ int parallax_main() {
 		glm::mat4 lightView = glm::lookAt(dirLightPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		glm::mat4 lightSpaceMatrix = lightProjection * lightView;
 
-		glCullFace(GL_FRONT);
+		glstate::CullFace(GL_FRONT);
 		depthDirShader.use();
 		depthDirShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-		depthDirShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		depthDirShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 5.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 
 		depthFBO.bind();
 		glClear(GL_DEPTH_BUFFER_BIT);
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		depthDirShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		cyborg.Draw(depthDirShader);
+		glm::mat4 cyborgModel = computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+		cyborg.Draw(depthDirShader, cyborgModel);
 		depthFBO.unbind();
-		glCullFace(GL_BACK);
+		glstate::CullFace(GL_BACK);
 
 
-		glViewport(0, 0, W_WIDTH, W_HEIGHT);
+		glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		floorShader.use();
-		floorShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		floorShader.setMat4("view", camera.getViewMatrix());
-		floorShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		floorShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 10.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		floorShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 		floorShader.setVec3("lightPos", dirLightPos);
@@ -158,14 +162,10 @@ int parallax_main() {
 		floorShader.setFloat("height_scale", 0.05f);
 
 		bindTextures(textureIDs);
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
 		cyborgShader.use();
-		cyborgShader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		cyborgShader.setMat4("view", camera.getViewMatrix());
-		cyborgShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		cyborgShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 		cyborgShader.setVec3("lightPos", dirLightPos);
 		cyborgShader.setVec3("dirLight.position", dirLightPos);
@@ -174,12 +174,14 @@ int parallax_main() {
 		cyborgShader.setVec3("dirLight.specular", glm::vec3(0.3f));
 		cyborgShader.setInt("dirShadowMap", 4);
 
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, depthTexture.id);
+		glstate::ActiveTexture(GL_TEXTURE4);
+		glstate::BindTexture(GL_TEXTURE_2D, depthTexture.id);
 
 		cyborgShader.setFloat("material.shininess", 8.0f);
 		cyborgShader.setVec3("viewPos", camera.getCameraPos());
-		cyborg.Draw(cyborgShader);
+		cyborg.Draw(cyborgShader, cyborgModel);
+
+		frameUniforms.endFrame();
 
 		// checks events and swap buffers
 		glfwPollEvents();
@@ -13,6 +13,8 @@
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 
@@ -46,11 +48,11 @@ int dir_shadows_main()
 	}
 
 	// viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	// glEnable(GL_FRAMEBUFFER_SRGB);
+	glstate::Enable(GL_DEPTH_TEST);
+	glstate::Enable(GL_CULL_FACE);
+	// glstate::Enable(GL_FRAMEBUFFER_SRGB);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -137,11 +139,18 @@ int dir_shadows_main()
 	// prepare to bind textures
 	std::vector<unsigned int> textureIDs = { tex_diff, tex_spec, depthTexture.id };
 
+	// meshlet culling savings per pass, printed every few seconds
+	MeshletCullStats shadowCullStats("shadow"), forwardCullStats("forward");
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
+
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.f);
 
 		// render commands
 		
@@ -153,23 +162,24 @@ int dir_shadows_main()
 		glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		glm::mat4 lightSpaceMatrix = lightProjection * lightView;
 		
-		glCullFace(GL_FRONT);
+		glstate::CullFace(GL_FRONT);
 		depthShader.use();
 		depthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-		depthShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
+		depthShader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
 			glm::vec3(10.0f, 5.0f, 10.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		
 		depthFBO.bind();
 		glClear(GL_DEPTH_BUFFER_BIT);
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		depthShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 2.5f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		object.Draw(depthShader);
+		glm::mat4 objectModel = computeModelMatrix(glm::vec3(0.0f, 2.5f, 0.0f),
+			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+		// front faces are culled here, so only clusters facing the light entirely can go
+		object.DrawCulled(depthShader, MeshletCullView(lightProjection, lightView, objectModel, GL_FRONT), objectModel, &shadowCullStats);
 		depthFBO.unbind();
-		glCullFace(GL_BACK);
+		glstate::CullFace(GL_BACK);
 
-		glViewport(0, 0, W_WIDTH, W_HEIGHT);
+		glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -177,18 +187,16 @@ int dir_shadows_main()
 		ppShader.use();
 		ppShader.setFloat("near_plane", near_plane);
 		ppShader.setFloat("far_plane", far_plane);
-		glBindVertexArray(frame);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, depthTexture.id);
+		glstate::BindVertexArray(frame);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, depthTexture.id);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+		glstate::BindVertexArray(0);
 		// */
 
 		// second pass
 		shader.use();
-		shader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		shader.setMat4("view", camera.getViewMatrix());
-		shader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), 
+		shader.setModel(computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f), 
 				glm::vec3(10.0f, 5.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 
@@ -206,12 +214,23 @@ int dir_shadows_main()
 		shader.setVec3("viewPos", camera.getCameraPos());
 		bindTextures(textureIDs);
 
-		glBindVertexArray(floorVAO);
+		glstate::BindVertexArray(floorVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		shader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 1.7f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		object.Draw(shader);
+		objectModel = computeModelMatrix(glm::vec3(0.0f, 1.7f, 0.0f),
+			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+		object.DrawCulled(shader, MeshletCullView(camera.getProjectionMatrix(), camera.getViewMatrix(), objectModel), objectModel,
+			&forwardCullStats);
+
+		frameCount++;
+		if (glfwGetTime() - statsTime > 5.0) {
+			shadowCullStats.print(frameCount);
+			forwardCullStats.print(frameCount);
+			frameCount = 0;
+			statsTime = glfwGetTime();
+		}
+
+		frameUniforms.endFrame();
 
 		// checks events and swap buffers
 		glfwPollEvents();
@@ -13,6 +13,10 @@
 #include "../modules/uniformbuffer.h"
 #include "../modules/light_types.h"
 #include "../modules/texture.h"
+#include "../modules/transform_store.h"
+#include "../modules/render_queue.h"
+#include "../modules/frame_data.h"
+#include "../modules/gl_state.h"
 
 #include "../../stb/stb_image.h"
 
@@ -46,11 +50,11 @@ int point_shadows_main()
 	}
 
 	// viewport setter
-	glViewport(0, 0, W_WIDTH, W_HEIGHT);
+	glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	// glEnable(GL_FRAMEBUFFER_SRGB);
+	glstate::Enable(GL_DEPTH_TEST);
+	glstate::Enable(GL_CULL_FACE);
+	// glstate::Enable(GL_FRAMEBUFFER_SRGB);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -134,7 +138,7 @@ int point_shadows_main()
 	// point shadow mapping
 	unsigned int depthCubemap;
 	glGenTextures(1, &depthCubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
 	for (unsigned int i = 0; i < 6; ++i) {
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	}
@@ -144,13 +148,13 @@ int point_shadows_main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	
-	glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
+	glstate::BindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubemap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	// std::cout << "depthCubemap = " << depthCubemap << std::endl;
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0); 
+	glstate::BindTexture(GL_TEXTURE_CUBE_MAP, 0); 
 	// for some reason, unbinding the cube does not produce shadow lights. I tried checking collisions between overriding texture ids but there's nothing. :(
 
 
@@ -177,14 +181,41 @@ int point_shadows_main()
 	// prepare to bind textures
 	std::vector<unsigned int> textureIDs = { tex_diff, tex_spec, depthTexture.id };
 
+	// the scene is static, its matrices are built once here instead of every frame
+	TransformStore transforms;
+	uint32_t shadowFloor = transforms.add(glm::vec3(0.0f, 0.0f, 0.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(10.0f, 5.0f, 10.0f));
+	uint32_t shadowObject = transforms.add(glm::vec3(0.0f, 2.5f, 0.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+	uint32_t litFloor = transforms.add(glm::vec3(0.0f, 0.0f, 0.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(10.0f, 5.0f, 10.0f));
+	uint32_t litObject = transforms.add(glm::vec3(0.0f, 1.7f, 0.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+	transforms.update();
+
+	// both shadow maps and the lit pass are submitted up front, then sorted and drawn pass by pass
+	enum { DIR_DEPTH_PASS, POINT_DEPTH_PASS, LIT_PASS };
+	RenderQueue queue("shadow queue");
+	queue.setDepthRange(0.1f, 1000.0f);
+	unsigned int frameCount = 0;
+	double statsTime = glfwGetTime();
+
+	FrameUniforms frameUniforms;
 	// render loop
 	while (!glfwWindowShouldClose(window))
 	{
 		// input
 		processInput(window);
+		frameUniforms.publish(camera, W_WIDTH, W_HEIGHT, 0.1f, 1000.0f);
 
 		// render commands
 
+		glm::vec3 cameraPos = camera.getCameraPos();
+		glm::vec3 objectPos = glm::vec3(transforms.getMatrix(litObject)[3]);
+		queue.submitArrays(DIR_DEPTH_PASS, depthDirShader, floorVAO, 0, 6, transforms.getMatrix(shadowFloor), 0.0f);
+		queue.submit(DIR_DEPTH_PASS, depthDirShader, object, transforms.getMatrix(shadowObject), 0.0f);
+		queue.submitArrays(POINT_DEPTH_PASS, depthPointShader, floorVAO, 0, 6, transforms.getMatrix(shadowFloor), 0.0f);
+		queue.submit(POINT_DEPTH_PASS, depthPointShader, object, transforms.getMatrix(shadowObject), 0.0f);
+		queue.submitArrays(LIT_PASS, shader, floorVAO, 0, 6, transforms.getMatrix(litFloor), glm::length(cameraPos),
+			textureIDs.data(), (unsigned int)textureIDs.size());
+		queue.submit(LIT_PASS, shader, object, transforms.getMatrix(litObject), glm::length(objectPos - cameraPos));
+
 		// first pass: render to depth map (directional shadows)
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -193,25 +224,19 @@ int point_shadows_main()
 		glm::mat4 lightView = glm::lookAt(dirLightPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		glm::mat4 lightSpaceMatrix = lightProjection * lightView;
 
-		glCullFace(GL_FRONT);
+		glstate::CullFace(GL_FRONT);
 		depthDirShader.use();
 		depthDirShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-		depthDirShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
-			glm::vec3(10.0f, 5.0f, 10.0f), 90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 
 		depthFBO.bind();
 		glClear(GL_DEPTH_BUFFER_BIT);
-		glBindVertexArray(floorVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		depthDirShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 2.5f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		object.Draw(depthDirShader);
+		queue.execute(DIR_DEPTH_PASS);
 		depthFBO.unbind();
-		glCullFace(GL_BACK);
+		glstate::CullFace(GL_BACK);
 
 		// render depth map (point shadows)
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
+		glstate::Viewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
 		depthPointShader.use();
@@ -221,15 +246,10 @@ int point_shadows_main()
 			depthPointShader.setMat4("shadowMatrices[" + std::to_string(i) + "]", shadowTransforms[i]);
 		}
 		depthPointShader.setFloat("far_plane", far);
+		queue.execute(POINT_DEPTH_PASS);
+		glstate::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		glBindVertexArray(floorVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		depthPointShader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 2.5f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		object.Draw(depthPointShader);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-		glViewport(0, 0, W_WIDTH, W_HEIGHT);
+		glstate::Viewport(0, 0, W_WIDTH, W_HEIGHT);
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -237,20 +257,16 @@ int point_shadows_main()
 		ppShader.use();
 		ppShader.setFloat("near_plane", near_plane);
 		ppShader.setFloat("far_plane", far_plane);
-		glBindVertexArray(frame);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, depthTexture.id);
+		glstate::BindVertexArray(frame);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		glstate::BindTexture(GL_TEXTURE_2D, depthTexture.id);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+		glstate::BindVertexArray(0);
 		// */
 		
 		// second pass
 		shader.use();
 		
-		shader.setMat4("projection", camera.getProjectionMatrix(W_WIDTH, W_HEIGHT, 0.1f, 1000.f));
-		shader.setMat4("view", camera.getViewMatrix());
-		shader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 0.0f, 0.0f),
-			glm::vec3(10.0f, 5.0f, 10.0f), -90.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 		// shader.setMat4("lightSpaceMatrix", glm::mat4(1.0f));
 
@@ -266,21 +282,26 @@ int point_shadows_main()
 		
 		shader.setFloat("material.shininess", 32.0f);
 
-		shader.setVec3("viewPos", camera.getCameraPos());
+		shader.setVec3("viewPos", cameraPos);
 
 		shader.setFloat("far_plane", far);
-		bindTextures(textureIDs);
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
+		glstate::ActiveTexture(GL_TEXTURE3);
+		glstate::BindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
 		shader.setInt("shadowCubemap", 3);
-		
-		glBindVertexArray(floorVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glstate::ActiveTexture(GL_TEXTURE0);
+		queue.execute(LIT_PASS);
+		queue.clear();
+
+		frameCount++;
+		if (glfwGetTime() - statsTime > 5.0) {
+			queue.stats.print(frameCount);
+			glstate::printStats(frameCount);
+			frameCount = 0;
+			statsTime = glfwGetTime();
+		}
 
-		shader.setMat4("model", computeModelMatrix(glm::vec3(0.0f, 1.7f, 0.0f),
-			glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
-		object.Draw(shader);
+		frameUniforms.endFrame();
 
 		// checks events and swap buffers
 		glfwPollEvents();
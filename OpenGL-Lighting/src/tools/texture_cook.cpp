@@ -0,0 +1,100 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include "../modules/model.h"
+#include "../modules/baked_texture.h"
+
+// picks the block format from the file name: normal maps go to BC5, single channel pbr/height maps
+// to BC4 and everything else (albedo, diffuse, specular) to BC1/BC7
+static TextureCompression compressionForTexture(const std::string& path)
+{
+	std::string name = path.substr(path.find_last_of('/') + 1);
+	if (name.find("normal") != std::string::npos) return TextureCompression::Normal;
+	const char* masks[] = { "metallic", "roughness", "ao.", "disp" };
+	for (const char* mask : masks)
+		if (name.find(mask) != std::string::npos) return TextureCompression::Mask;
+	return TextureCompression::Color;
+}
+
+// cooks the mip chain of every texture the demos load into a block compressed .ktx next to the source
+// image. needs no gl context, loaders pick the cooked files up automatically while they are up to date.
+int texture_cook_main()
+{
+	std::vector<TextureLoadRequest> textures = {
+		{ "resources/textures/brickwall.jpg", true, TextureColorSpace::sRGB },
+		{ "resources/textures/brickwall_normal.jpg", true, TextureColorSpace::Linear },
+		{ "resources/textures/bricks2.jpg", true, TextureColorSpace::sRGB },
+		{ "resources/textures/bricks2_normal.jpg", true, TextureColorSpace::Linear },
+		{ "resources/textures/bricks2_disp.jpg", true, TextureColorSpace::Linear },
+		{ "resources/textures/wood.png", true, TextureColorSpace::sRGB },
+		{ "resources/textures/pbr/rusted_iron/albedo.png", true, TextureColorSpace::sRGB },
+		{ "resources/textures/pbr/rusted_iron/normal.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/metallic.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/roughness.png", true, TextureColorSpace::Linear },
+		{ "resources/textures/pbr/rusted_iron/ao.png", true, TextureColorSpace::Linear }
+	};
+
+	// model materials, resolved the same way Model does
+	const char* models[] = {
+		"resources/objects/cyborg/cyborg.obj",
+		"resources/objects/backpack/backpack.obj",
+		"resources/objects/rock/rock.obj",
+		"resources/objects/planet/planet.obj"
+	};
+	const std::pair<aiTextureType, const char*> materialTypes[] = {
+		{ aiTextureType_DIFFUSE, "texture_diffuse" },
+		{ aiTextureType_SPECULAR, "texture_specular" },
+		{ aiTextureType_HEIGHT, "texture_normal" }
+	};
+
+	for (const char* modelPath : models) {
+		Assimp::Importer import;
+		const aiScene* scene = import.ReadFile(modelPath, 0);
+		if (!scene) {
+			std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+			continue;
+		}
+
+		std::string path = modelPath;
+		std::string directory = path.substr(0, path.find_last_of('/'));
+		for (unsigned int m = 0; m < scene->mNumMaterials; m++) {
+			for (const auto& type : materialTypes) {
+				for (unsigned int i = 0; i < scene->mMaterials[m]->GetTextureCount(type.first); i++) {
+					aiString texturePath;
+					scene->mMaterials[m]->GetTexture(type.first, i, &texturePath);
+					TextureLoadRequest request = { directory + '/' + texturePath.C_Str(), false, Model::materialColorSpace(type.second) };
+
+					bool known = false;
+					for (const TextureLoadRequest& existing : textures)
+						known = known || (existing.path == request.path && existing.space == request.space);
+					if (!known)
+						textures.push_back(request);
+				}
+			}
+		}
+	}
+
+	std::cout << std::left << std::setw(60) << "texture" << std::right << std::setw(10) << "ms" << std::endl;
+	double totalMs = 0.0;
+	for (const TextureLoadRequest& texture : textures) {
+		auto start = std::chrono::high_resolution_clock::now();
+		TextureCompression compression = compressionForTexture(texture.path);
+		bool cooked = cookTexture(texture.path, texture.space, texture.flipVertically, compression);
+		auto end = std::chrono::high_resolution_clock::now();
+		double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		totalMs += ms;
+
+		std::cout << std::left << std::setw(60) << texture.path << std::right << std::fixed << std::setprecision(2);
+		if (cooked)
+			std::cout << std::setw(10) << ms << std::endl;
+		else
+			std::cout << std::setw(10) << "failed" << std::endl;
+	}
+	std::cout << textures.size() << " textures cooked in " << totalMs << " ms" << std::endl;
+
+	return 0;
+}